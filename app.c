@@ -13,20 +13,93 @@
 **
 */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "globals.h"
+#include "fmt.h"
+#include "debug.h"
+#include "perf.h"
+#include "timing.h"
+#include "progress.h"
+#include "writer.h"
 #include "rMPI_model.h"
 #include "phases.h"
+#include "events.h"
+#include "snapshot.h"
+#include "branch.h"
 #include "app.h"
 
 
+/* Wall clock time at which app_model() gives up. 0.0 means never */
+static SIM_LOCAL double deadline= 0.0;
+
+/* Write a snapshot every snapshot_every seconds of wall clock time */
+static SIM_LOCAL double snapshot_every= 0.0;
+static SIM_LOCAL double next_snapshot;
+static SIM_LOCAL char *snapshot_fname;
+
+/* A --branch continues from here, instead of starting over */
+static SIM_LOCAL snapshot_state_t *continue_from= NULL;
+
+
+
+/*
+** Give the next app_model() call this many seconds of wall clock time.
+** 0.0 removes the limit.
+*/
+void
+app_time_budget(double seconds)
+{
+
+    if (seconds > 0.0)   {
+	deadline= get_clock_value() + seconds;
+    } else   {
+	deadline= 0.0;
+    }
+
+}  /* end of app_time_budget() */
+
+
+
+/*
+** Write a snapshot to fname every this many seconds of wall clock time,
+** during the next app_model() call. 0.0 turns snapshots off.
+*/
+void
+app_snapshot(double seconds, char *fname)
+{
+
+    snapshot_every= seconds;
+    snapshot_fname= fname;
+    next_snapshot= get_clock_value() + seconds;
+
+}  /* end of app_snapshot() */
+
+
+
+/*
+** The next app_model() call continues from state, with the parameters
+** it is given, instead of starting over. Like a --resume, without the
+** file and without comparing the parameters.
+*/
+void
+app_continue(snapshot_state_t *state)
+{
+
+    continue_from= state;
+
+}  /* end of app_continue() */
+
+
+
 /*
 ** Return the elapsed time
 */
 double
 app_model(int verbose, double tau, double checkpoint_time, double restart_time,
-	double work_time, double ras_delay, FILE *fp_ints, FILE *fp_faults,
+	double work_time, double ras_delay, writer_t *w_ints, writer_t *w_faults,
 	float soft_time_to_reboot, float soft_reboot_success_rate, int hotswap)
 {
 
@@ -39,49 +112,83 @@ double elapsed_time;
 
 int done;
 int dead_nodes;
+snapshot_params_t params;
+snapshot_state_t state;
 
 
-    /*
-    ** First start
-    */
-    elapsed_time= 0.0;
-    rework_time= 0.0;
-    rework_done= 0.0;
-    last_event= 0.0;
+    memset(&params, 0, sizeof(params));
+    params.tau= tau;
+    params.checkpoint_time= checkpoint_time;
+    params.restart_time= restart_time;
+    params.work_time= work_time;
+    params.ras_delay= ras_delay;
+    params.soft_reboot_success_rate= soft_reboot_success_rate;
+    if (soft_reboot_success_rate >= 0.0)   {
+	/* Not used otherwise */
+	params.soft_time_to_reboot= soft_time_to_reboot;
+    }
+    params.hotswap= hotswap;
 
+    if (continue_from || snapshot_resumed(&state))   {
+	/* Continue at the top of the loop below, where the snapshot was taken */
+	if (continue_from)   {
+	    /* A --branch, with its own parameters */
+	    state= *continue_from;
+	    continue_from= NULL;
+	} else if (memcmp(&state.params, &params, sizeof(params)) != 0)   {
+	    sim_error(8, "ERROR: The snapshot was taken with a different checkpoint interval, "
+		"work, checkpoint, restart, RAS delay, or soft reboot time\n");
+	}
+	elapsed_time= state.elapsed_time;
+	last_event= state.last_event;
+	rework_time= state.rework_time;
+	rework_done= 0.0;
+	done= FALSE;
+    } else   {
+	/*
+	** First start
+	*/
+	elapsed_time= 0.0;
+	rework_time= 0.0;
+	rework_done= 0.0;
+	last_event= 0.0;
+	perf_phase_iterations++;
 
-    /* 
-    ** Generate monotonically increasing times at which the application
-    ** experiences a fault and has to restart.
-    */
-    next_interrupt= rMPI(verbose, fp_ints, fp_faults, elapsed_time, soft_time_to_reboot,
-			soft_reboot_success_rate, hotswap);
 
-    while (next_interrupt < (last_event + ras_delay))   {
-	/*
-	** Often a whole bunch of faults occur at almost the same time while the
-	** application is dying. Wait here for a moment until the (some of) the
-	** burst has passed.
+	/* 
+	** Generate monotonically increasing times at which the application
+	** experiences a fault and has to restart.
 	*/
-	next_interrupt= rMPI(verbose, fp_ints, fp_faults, elapsed_time, soft_time_to_reboot,
+	next_interrupt= rMPI(verbose, w_ints, w_faults, elapsed_time, soft_time_to_reboot,
 			    soft_reboot_success_rate, hotswap);
-    }
-    elapsed_time= elapsed_time + ras_delay;
-    total_ras_delay= total_ras_delay + ras_delay;
 
-    /* We expect the input to be monotonically increasing (and be > 0) */
-    assert(next_interrupt >= last_event);
+	while (next_interrupt < (last_event + ras_delay))   {
+	    /*
+	    ** Often a whole bunch of faults occur at almost the same time while the
+	    ** application is dying. Wait here for a moment until the (some of) the
+	    ** burst has passed.
+	    */
+	    next_interrupt= rMPI(verbose, w_ints, w_faults, elapsed_time, soft_time_to_reboot,
+				soft_reboot_success_rate, hotswap);
+	}
+	if (ras_delay > 0.0)   {
+	    event_phase(EVENT_RAS_DELAY, elapsed_time, elapsed_time + ras_delay, EVENT_DONE);
+	}
+	elapsed_time= elapsed_time + ras_delay;
+	total_ras_delay= total_ras_delay + ras_delay;
+
+	/* We expect the input to be monotonically increasing (and be > 0) */
+	assert(next_interrupt >= last_event);
 
-    /* Remember the last interrupt */
-    last_event= next_interrupt;
-    interrupt_cnt++;
+	/* Remember the last interrupt */
+	last_event= next_interrupt;
+	interrupt_cnt++;
 
-    if (verbose > 1)   {
-	fprintf(stderr, "%12.1f\" ------- Next interrupt (number %d) at %12.1f\" (%12.2f hours)\n",
+	TRACE2(verbose, "%12.1f\" ------- Next interrupt (number %d) at %12.1f\" (%12.2f hours)\n",
 	    elapsed_time, interrupt_cnt, next_interrupt, next_interrupt / 60.0);
-    }
 
-    done= do_work(next_interrupt, work_time, &rework_time, tau, tau, checkpoint_time, verbose, &elapsed_time);
+	done= do_work(next_interrupt, work_time, &rework_time, tau, tau, checkpoint_time, verbose, &elapsed_time);
+    }
 
 
 
@@ -91,8 +198,30 @@ int dead_nodes;
     */
     while (!done)   {
 
+	/* Time for a --snapshot_every snapshot? */
+	if ((snapshot_every > 0.0) && (get_clock_value() >= next_snapshot))   {
+	    state.params= params;
+	    state.elapsed_time= elapsed_time;
+	    state.last_event= last_event;
+	    state.rework_time= rework_time;
+	    snapshot_write(snapshot_fname, &state);
+	    next_snapshot= get_clock_value() + snapshot_every;
+	}
+
+	/* Time to --branch? The branches finish the run in child processes */
+	if (branch_due(elapsed_time))   {
+	    state.params= params;
+	    state.elapsed_time= elapsed_time;
+	    state.last_event= last_event;
+	    state.rework_time= rework_time;
+	    branch_run(&state, verbose);
+	    return elapsed_time;
+	}
+
+	perf_phase_iterations++;
+
 	/* When will the next interrupt occur? */
-	next_interrupt= rMPI(verbose, fp_ints, fp_faults, elapsed_time, soft_time_to_reboot,
+	next_interrupt= rMPI(verbose, w_ints, w_faults, elapsed_time, soft_time_to_reboot,
 			    soft_reboot_success_rate, hotswap);
 	while (next_interrupt < (last_event + ras_delay))   {
 	    /*
@@ -100,9 +229,12 @@ int dead_nodes;
 	    ** application is dying. Wait here for a moment until the (some of) the
 	    ** burst has passed.
 	    */
-	    next_interrupt= rMPI(verbose, fp_ints, fp_faults, elapsed_time, soft_time_to_reboot,
+	    next_interrupt= rMPI(verbose, w_ints, w_faults, elapsed_time, soft_time_to_reboot,
 				soft_reboot_success_rate, hotswap);
 	}
+	if (ras_delay > 0.0)   {
+	    event_phase(EVENT_RAS_DELAY, elapsed_time, elapsed_time + ras_delay, EVENT_DONE);
+	}
 	elapsed_time= elapsed_time + ras_delay;
 	total_ras_delay= total_ras_delay + ras_delay;
 
@@ -110,9 +242,18 @@ int dead_nodes;
 	last_event= next_interrupt;
 	interrupt_cnt++;
 
-	if (verbose > 1)   {
-	    fprintf(stderr, "%12.1f\" ------- Next interrupt (number %d) at %12.1f\" (%12.2f hours)\n",
-		elapsed_time, interrupt_cnt, next_interrupt, next_interrupt / 60.0);
+	TRACE2(verbose, "%12.1f\" ------- Next interrupt (number %d) at %12.1f\" (%12.2f hours)\n",
+	    elapsed_time, interrupt_cnt, next_interrupt, next_interrupt / 60.0);
+
+	/* A SIGUSR1, or time for a --progress line or a --stats_shm update */
+	if (progress_pending)   {
+	    progress_poll(elapsed_time, work_time);
+	}
+
+	/* Out of --time_budget? Stop here; the report extrapolates the rest */
+	if ((deadline > 0.0) && (get_clock_value() > deadline))   {
+	    stopped_early= TRUE;
+	    break;
 	}
 
 
@@ -124,7 +265,10 @@ int dead_nodes;
 
 	rework_done= do_rework(next_interrupt, rework_time, verbose, &elapsed_time);
 	time_left= tau - rework_done;
-	assert(time_left >= 0.0);
+	if (time_left < 0.0)   {
+	    /* A --branch shortened tau. Checkpoint as soon as the rework is done. */
+	    time_left= 0.0;
+	}
 
 	if (elapsed_time >= next_interrupt)   {
 	    /* Enter next cycle */
@@ -136,27 +280,27 @@ int dead_nodes;
     }
 
     /* Correct for overshooting */
-    if ((work_time - total_work_time)  < 0.0)   {
-	fprintf(stderr, "We have to correct elapsed time by %.3g\"\n", work_time - total_work_time);
+    if (stopped_early)   {
+	/* We know we did not work enough */
+    } else if ((work_time - total_work_time)  < 0.0)   {
+	sim_warning("We have to correct elapsed time by %.3g\"\n", work_time - total_work_time);
 	elapsed_time= elapsed_time - (work_time - total_work_time);
 	total_work_time= work_time;
     } else if ((work_time - total_work_time)  > 0.0)   {
-	fprintf(stderr, "We did not work enough by %.3g\"\n", work_time - total_work_time);
-    }
-    if (verbose > 1)   {
-	fprintf(stderr, "%12.1f\" Work DONE:               %12.1f\" (%12.1fh)\n", elapsed_time,
-	    total_work_time, total_work_time / 60.0);
+	sim_warning("We did not work enough by %.3g\"\n", work_time - total_work_time);
     }
+    TRACE2(verbose, "%12.1f\" Work DONE:               %12.1f\" (%12.1fh)\n", elapsed_time,
+	total_work_time, total_work_time / 60.0);
 
     /* Count how many faults we had in the last phase.  */
-    dead_nodes= count_dead_nodes(elapsed_time, fp_faults);
+    dead_nodes= count_dead_nodes(elapsed_time, w_faults);
 
     /*
     ** The last interrupt is really the end of the job, but we want to record
     ** the number of faults in the last phase.
     */
-    if (fp_ints)   {
-	fprintf(fp_ints, "%15.3f %d\n", last_event, dead_nodes);
+    if (w_ints)   {
+	writer_interrupt(w_ints, last_event, dead_nodes);
     }
 
     return elapsed_time;
@@ -14,9 +14,13 @@
 #ifndef _APP_H_
 #define _APP_H_
 
+void app_time_budget(double seconds);
+void app_snapshot(double seconds, char *fname);
+void app_continue(snapshot_state_t *state);
+
 double
 app_model(int verbose, double tau, double checkpoint_time, double restart_time,
-	double work_time, double ras_delay, FILE *fp, FILE *fp_faults,
+	double work_time, double ras_delay, writer_t *w_ints, writer_t *w_faults,
 	float soft_time_to_reboot, float soft_reboot_success_rate,
 	int hotswap);
 
@@ -0,0 +1,147 @@
+/*
+** $Id$
+**
+** Show the progress of a two_step run that was started with
+** --stats_shm name. Prints one line, or with an interval a line every
+** that many seconds until the run ends.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "globals.h"
+#include "progress.h"
+
+
+static void snapshot(const progress_shm_t *shared, progress_shm_t *copy);
+static void usage(char *prog);
+
+
+
+int
+main(int argc, char *argv[])
+{
+
+char *name;
+int fd;
+const progress_shm_t *shared;
+progress_shm_t s;
+double interval;
+struct timespec pause;
+
+
+    if ((argc < 2) || (argc > 3))   {
+	usage(argv[0]);
+	exit(1);
+    }
+
+    interval= 0.0;
+    if (argc == 3)   {
+	interval= strtod(argv[2], (char **)NULL);
+	if (interval <= 0.0)   {
+	    usage(argv[0]);
+	    exit(1);
+	}
+    }
+
+    /* POSIX shared memory names start with a slash */
+    name= (char *)malloc(strlen(argv[1]) + 2);
+    if (name == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    sprintf(name, "%s%s", (argv[1][0] == '/') ? "" : "/", argv[1]);
+
+    fd= shm_open(name, O_RDONLY, 0);
+    if (fd < 0)   {
+	fprintf(stderr, "Could not open shared memory \"%s\": %s\n", name, strerror(errno));
+	exit(2);
+    }
+    shared= (const progress_shm_t *)mmap(NULL, sizeof(progress_shm_t), PROT_READ, MAP_SHARED,
+		fd, 0);
+    if (shared == MAP_FAILED)   {
+	fprintf(stderr, "Could not map shared memory \"%s\": %s\n", name, strerror(errno));
+	exit(2);
+    }
+    close(fd);
+
+    if ((memcmp(shared->magic, PROGRESS_MAGIC, sizeof(shared->magic)) != 0) ||
+	    (shared->version != PROGRESS_VERSION))   {
+	fprintf(stderr, "ERROR: \"%s\" is not a version %d two_step stats segment\n", name,
+	    PROGRESS_VERSION);
+	exit(8);
+    }
+
+    pause.tv_sec= (time_t)interval;
+    pause.tv_nsec= (long)((interval - (time_t)interval) * 1000000000.0);
+    while (1)   {
+	snapshot(shared, &s);
+	printf("pid %ld %.1f s: %d interrupts, %d faults, %.2f of %.2f hours of work "
+	    "(%.2f%%), elapsed %.2f hours%s\n", (long)s.pid, s.wall_sec, s.interrupt_cnt,
+	    s.fault_cnt, s.work_done / 60.0, s.work_time / 60.0,
+	    (s.work_time > 0.0) ? 100.0 / s.work_time * s.work_done : 0.0, s.elapsed / 60.0,
+	    s.done ? ", done" : "");
+	fflush(stdout);
+
+	if ((interval <= 0.0) || s.done)   {
+	    break;
+	}
+	nanosleep(&pause, NULL);
+    }
+
+    munmap((void *)shared, sizeof(progress_shm_t));
+    free(name);
+    return 0;
+
+}  /* end of main() */
+
+
+
+/*
+** A consistent copy of the segment. See the sequence lock in progress.h.
+*/
+static void
+snapshot(const progress_shm_t *shared, progress_shm_t *copy)
+{
+
+uint32_t seq;
+
+
+    while (1)   {
+	seq= __atomic_load_n(&shared->seq, __ATOMIC_ACQUIRE);
+	if (seq & 1)   {
+	    continue;
+	}
+	memcpy(copy, shared, sizeof(progress_shm_t));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (seq == __atomic_load_n(&shared->seq, __ATOMIC_RELAXED))   {
+	    return;
+	}
+    }
+
+}  /* end of snapshot() */
+
+
+
+static void
+usage(char *prog)
+{
+
+    fprintf(stderr, "Usage: %s name [seconds]\n", prog);
+    fprintf(stderr, "    Show the progress of a two_step run started with --stats_shm name.\n");
+    fprintf(stderr, "    With seconds, show it every that many seconds until the run ends.\n");
+
+}  /* end of usage() */
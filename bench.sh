@@ -0,0 +1,174 @@
+#!/bin/sh
+#
+## $Id$
+##
+## Run a fixed matrix of two_step scenarios, record how fast each one
+## ran, and compare the numbers against an earlier baseline. "make bench"
+## runs this script; see COMPILING in the README.
+##
+## This file is part of app_model. App_model is free software and
+## is distributed under the terms of the GNU General Public License
+## Version 3. See the file LICENSE for details.
+#
+
+usage()
+{
+    echo "Usage: $0 [-o results] [-b baseline] [-m max_nodes] [-t tolerance_pct]" >&2
+    echo "    -o results       Write the results to this CSV file. (Default bench_results.csv)" >&2
+    echo "    -b baseline      Compare against this earlier results file, if it exists" >&2
+    echo "    -m max_nodes     Largest -n to run, 1000 to 100000000. (Default 1000000)" >&2
+    echo "    -t tolerance     Report a regression, if a scenario is this many percent" >&2
+    echo "                     slower than in the baseline. (Default 10)" >&2
+    exit 1
+}
+
+results=bench_results.csv
+baseline=
+max_nodes=1000000
+tolerance=10
+
+while getopts "o:b:m:t:h" opt; do
+    case $opt in
+	o) results=$OPTARG ;;
+	b) baseline=$OPTARG ;;
+	m) max_nodes=$OPTARG ;;
+	t) tolerance=$OPTARG ;;
+	*) usage ;;
+    esac
+done
+
+here=$(cd "$(dirname "$0")" && pwd)
+two_step=$here/two_step
+if [ ! -x "$two_step" ]; then
+    echo "$two_step not found. Run make first." >&2
+    exit 2
+fi
+
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/bench.XXXXXX") || exit 2
+trap 'rm -rf "$tmp"' EXIT INT TERM
+
+#
+## The node MTBF grows with -n, so every size sees about the same number
+## of faults (a system MTBF of 26 minutes). A run then measures the cost
+## per event at that size, plus the setup of the nodes.
+#
+SYS_MTBF=0.438		# hours
+WORK=720		# hours
+
+#
+## Run one scenario and append a line to the results.
+## run name nodes two_step_options...
+#
+run()
+{
+    name=$1
+    nodes=$2
+    shift 2
+
+    start=$(date +%s.%N)
+    "$two_step" -s -p --format csv "$@" > "$tmp/out.csv" 2> "$tmp/err.txt"
+    rc=$?
+    end=$(date +%s.%N)
+
+    if [ $rc -ne 0 ]; then
+	echo "$name,$nodes,,failed,,,,,,," >> "$results"
+	printf "  %-22s %10s  FAILED (exit %d)\n" "$name" "$nodes" $rc
+	return
+    fi
+
+    # The command line is the only field that can contain commas. Look
+    # up the other fields from the end of the line.
+    awk -F, -v name="$name" -v nodes="$nodes" -v start="$start" -v end="$end" '
+	NR == 1 {
+	    for (i= 1; i <= NF; i++) col[$i]= i
+	    hdr= NF
+	    next
+	}
+	function get(key) { return $(col[key] + NF - hdr) }
+	NR == 2 {
+	    model= get("performance.time_setup_sec") + get("performance.time_phases_sec") + \
+		get("performance.time_rMPI_sec") + get("performance.time_input_sec") + \
+		get("performance.time_output_sec") + get("performance.time_other_sec")
+	    events= get("simulation.faults") + get("simulation.interrupts")
+	    draws= get("performance.random_numbers") + get("performance.random_probabilities")
+	    printf "%s,%s,%s,ok,%.6f,%.6f,%d,%.0f,%d,%.0f,%d\n", name, nodes, $1,
+		end - start, model, events, (model > 0) ? events / model : 0,
+		draws, (model > 0) ? draws / model : 0, get("performance.peak_rss_kb")
+	}' "$tmp/out.csv" >> "$results"
+
+    tail -n 1 "$results" | awk -F, '{printf "  %-22s %10s %10.3f s %12s events/s %12s draws/s %9s kB\n", \
+	$1, $2, $5, $8, $10, $11}'
+}
+
+echo "scenario,nodes,version,status,wall_sec,model_sec,events,events_per_sec,rng_draws,rng_draws_per_sec,peak_rss_kb" > "$results"
+
+#
+## A trace to replay: faults on nodes 0 to 999,999 over 8000 hours. An
+## application on 1000 nodes sees one every four hours; most of the
+## trace is read and thrown away.
+#
+awk 'BEGIN {
+    srand(1)
+    t= 0
+    for (i= 0; i < 2000000; i++)   {
+	t= t + 14.4 * -log(1 - rand())
+	printf "%d %d ERR\n", t, int(rand() * 1000000)
+    }
+}' > "$tmp/trace.txt"
+
+echo "Benchmarks up to -n $max_nodes. Results in $results"
+nodes=1000
+while [ $nodes -le $max_nodes ]; do
+    mtbf=$(awk -v n=$nodes -v m=$SYS_MTBF 'BEGIN {printf "%.0f", n * m}')
+    half=$((nodes / 2))
+
+    run exp_r0 $nodes -n $nodes -w $WORK -m $mtbf
+    run exp_rhalf $nodes -n $nodes -r $half -w $WORK -m $mtbf
+    run exp_rfull $nodes -n $nodes -r $nodes -w $WORK -m $mtbf
+    run weibull_r0 $nodes -n $nodes -w $WORK --distrib weibull --shape 0.7 --scale $mtbf
+    run gamma_r0 $nodes -n $nodes -w $WORK --distrib gamma --shape 0.7 --scale $mtbf
+    run soft_reboot_rfull $nodes -n $nodes -r $nodes -w $WORK -m $mtbf --soft_reboot 0.5,10
+    run ffaults_r0 $nodes -n $nodes -w $WORK -m $mtbf --ff "$tmp/faults.txt" --fi "$tmp/ints.txt"
+    if [ $nodes -eq 1000 ]; then
+	run input_r0 $nodes -n $nodes -w $WORK --input "$tmp/trace.txt"
+	run input_rfull $nodes -n $nodes -r $nodes -w $WORK --input "$tmp/trace.txt"
+    fi
+
+    nodes=$((nodes * 10))
+done
+
+if [ -z "$baseline" ] || [ ! -f "$baseline" ]; then
+    exit 0
+fi
+
+#
+## Compare the model times. Very short runs are mostly noise; they are
+## only compared, if either side took at least 10 ms.
+#
+echo
+echo "Compared to $baseline (more than $tolerance% slower is a regression):"
+awk -F, -v tol="$tolerance" '
+    FNR == 1 { next }
+    NR == FNR {
+	if ($4 == "ok") base[$1 "," $2]= $6
+	next
+    }
+    {
+	key= $1 "," $2
+	if (!(key in base) || ($4 != "ok")) next
+	old= base[key]
+	if ((old < 0.01) && ($6 < 0.01)) next
+	change= (old > 0) ? 100.0 * ($6 - old) / old : 0
+	flag= ""
+	if (change > tol) {
+	    flag= "  REGRESSION"
+	    bad++
+	}
+	printf "  %-22s %10s %10.3f s -> %10.3f s %+8.1f%%%s\n", $1, $2, old, $6, change, flag
+    }
+    END {
+	if (bad > 0) {
+	    printf "%d scenario(s) got slower\n", bad
+	    exit 1
+	}
+    }' "$baseline" "$results"
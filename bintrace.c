@@ -0,0 +1,349 @@
+/*
+** $Id$
+**
+** Read fault times from a binary trace file. The file is mapped into
+** memory, so opening even a very large trace costs only a few system
+** calls. A trace on a pipe cannot be mapped; its records are read one
+** after the other instead. See bintrace.h for the layout. trace_conv.c
+** creates these files.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "globals.h"
+#include "bintrace.h"
+
+
+struct bintrace_t   {
+    void *map;			/* Start of the mapped file, NULL for a stream */
+    size_t map_len;
+    const bintrace_hdr_t *hdr;
+    const bintrace_rec_t *rec;	/* First record */
+    const double *index;	/* Sparse time index */
+    uint64_t pos;		/* Next record to be returned */
+    FILE *fp;			/* A stream is read from here */
+    bintrace_hdr_t stream_hdr;
+    bintrace_rec_t next;	/* Read ahead by bintrace_seek() on a stream */
+    int have_next;
+};
+
+
+/* Local functions */
+static bintrace_t *stream_open(FILE *fp);
+static int stream_read(bintrace_t *bt);
+static void check_hdr(const bintrace_hdr_t *hdr);
+
+
+
+/*
+** Does this stream look like a binary trace? A seekable stream is
+** rewound afterwards. Only one byte of a pipe can be put back, so there
+** we go by the first byte of the magic; a text trace starts with a
+** number. bintrace_open() checks the rest.
+*/
+int
+bintrace_probe(FILE *fp)
+{
+
+char magic[sizeof(((bintrace_hdr_t *)0)->magic)];
+int rc;
+
+
+    if (fseek(fp, 0L, SEEK_SET) != 0)   {
+	return ungetc(getc(fp), fp) == BINTRACE_MAGIC[0];
+    }
+
+    rc= fread(magic, 1, sizeof(magic), fp);
+    rewind(fp);
+    if ((rc == sizeof(magic)) && (memcmp(magic, BINTRACE_MAGIC, sizeof(magic)) == 0))   {
+	return TRUE;
+    }
+
+    return FALSE;
+
+}  /* end of bintrace_probe() */
+
+
+
+/*
+** Map the trace file into memory and check the header, and that all
+** sections are within the file. Errors are fatal, since the file claims
+** to be a binary trace.
+*/
+bintrace_t *
+bintrace_open(FILE *fp)
+{
+
+bintrace_t *bt;
+struct stat sb;
+const bintrace_hdr_t *hdr;
+const char *names;
+uint64_t len;
+uint64_t i;
+uint64_t n;
+
+
+    if (fseek(fp, 0L, SEEK_SET) != 0)   {
+	return stream_open(fp);
+    }
+
+    if (fstat(fileno(fp), &sb) != 0)   {
+	fprintf(stderr, "ERROR: Cannot stat binary trace: %s\n", strerror(errno));
+	exit(2);
+    }
+
+    if ((size_t)sb.st_size < sizeof(bintrace_hdr_t))   {
+	fprintf(stderr, "ERROR: Binary trace is truncated\n");
+	exit(2);
+    }
+
+    bt= (bintrace_t *)malloc(sizeof(bintrace_t));
+    if (bt == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    bt->map_len= sb.st_size;
+    bt->map= mmap(NULL, bt->map_len, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (bt->map == MAP_FAILED)   {
+	fprintf(stderr, "ERROR: Cannot map binary trace: %s\n", strerror(errno));
+	exit(2);
+    }
+    madvise(bt->map, bt->map_len, MADV_SEQUENTIAL);
+
+    hdr= (const bintrace_hdr_t *)bt->map;
+    check_hdr(hdr);
+
+    /* Divide instead of multiply, so a damaged count cannot overflow */
+    len= bt->map_len;
+    if ((hdr->num_records > (len - sizeof(bintrace_hdr_t)) / sizeof(bintrace_rec_t)) ||
+	    (hdr->index_offset > len) || ((hdr->index_offset % sizeof(double)) != 0) ||
+	    (hdr->num_index > (len - hdr->index_offset) / sizeof(double)) ||
+	    ((hdr->num_index > 0) && (hdr->index_stride == 0)) ||
+	    (hdr->class_offset > len))   {
+	fprintf(stderr, "ERROR: Binary trace is truncated\n");
+	exit(2);
+    }
+
+    /* Each class name must end within the file */
+    names= (const char *)bt->map + hdr->class_offset;
+    n= 0;
+    for (i= 0; (i < len - hdr->class_offset) && (n < hdr->num_classes); i++)   {
+	if (names[i] == '\0')   {
+	    n++;
+	}
+    }
+    if (n < hdr->num_classes)   {
+	fprintf(stderr, "ERROR: Binary trace is truncated\n");
+	exit(2);
+    }
+
+    bt->hdr= hdr;
+    bt->rec= (const bintrace_rec_t *)((const char *)bt->map + sizeof(bintrace_hdr_t));
+    bt->index= (const double *)((const char *)bt->map + hdr->index_offset);
+    bt->pos= 0;
+    bt->fp= NULL;
+    bt->have_next= FALSE;
+
+    return bt;
+
+}  /* end of bintrace_open() */
+
+
+
+void
+bintrace_close(bintrace_t *bt)
+{
+
+    if (bt == NULL)   {
+	return;
+    }
+
+    if (bt->map)   {
+	munmap(bt->map, bt->map_len);
+    }
+    free(bt);
+
+}  /* end of bintrace_close() */
+
+
+
+/*
+** Return the next record. Same return values as fscanf() on the
+** text format: 3 on success, EOF at the end of the trace.
+*/
+int
+bintrace_next(bintrace_t *bt, double *t, int *node)
+{
+
+    if (bt->map == NULL)   {
+	if (!bt->have_next)   {
+	    if (bt->pos >= bt->hdr->num_records)   {
+		return EOF;
+	    }
+	    if (!stream_read(bt))   {
+		/* Truncated. Same as a line that cannot be parsed. */
+		return 0;
+	    }
+	}
+	bt->have_next= FALSE;
+	*t= bt->next.t;
+	*node= bt->next.node;
+	return 3;
+    }
+
+    if (bt->pos >= bt->hdr->num_records)   {
+	return EOF;
+    }
+
+    *t= bt->rec[bt->pos].t;
+    *node= bt->rec[bt->pos].node;
+    bt->pos++;
+
+    return 3;
+
+}  /* end of bintrace_next() */
+
+
+
+/*
+** Position the trace so that the next record returned is the first
+** one at or after time t (in seconds). A binary search over the sparse
+** index gets us to within index_stride records. A stream can only skip
+** ahead.
+*/
+void
+bintrace_seek(bintrace_t *bt, double t)
+{
+
+uint64_t lo, hi, mid;
+
+
+    if (bt->map == NULL)   {
+	while (TRUE)   {
+	    if (!bt->have_next)   {
+		if ((bt->pos >= bt->hdr->num_records) || !stream_read(bt))   {
+		    return;
+		}
+		bt->have_next= TRUE;
+	    }
+	    if (bt->next.t >= t)   {
+		return;
+	    }
+	    bt->have_next= FALSE;
+	}
+    }
+
+    lo= 0;
+    hi= bt->hdr->num_index;
+    while (lo < hi)   {
+	mid= lo + (hi - lo) / 2;
+	if (bt->index[mid] < t)   {
+	    lo= mid + 1;
+	} else   {
+	    hi= mid;
+	}
+    }
+
+    /* Index entry lo is the first >= t; the record we want is after entry lo - 1 */
+    bt->pos= (lo > 0) ? (lo - 1) * bt->hdr->index_stride : 0;
+    while ((bt->pos < bt->hdr->num_records) && (bt->rec[bt->pos].t < t))   {
+	bt->pos++;
+    }
+
+}  /* end of bintrace_seek() */
+
+
+
+const bintrace_hdr_t *
+bintrace_hdr(bintrace_t *bt)
+{
+    return bt->hdr;
+}  /* end of bintrace_hdr() */
+
+
+
+/*
+** A binary trace on a pipe. Read the header; the records follow it.
+** The index and the class names at the end are not needed.
+*/
+static bintrace_t *
+stream_open(FILE *fp)
+{
+
+bintrace_t *bt;
+
+
+    bt= (bintrace_t *)calloc(1, sizeof(bintrace_t));
+    if (bt == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    if ((fread(&bt->stream_hdr, sizeof(bintrace_hdr_t), 1, fp) != 1) ||
+	    (memcmp(bt->stream_hdr.magic, BINTRACE_MAGIC, sizeof(bt->stream_hdr.magic)) != 0))   {
+	/* bintrace_probe() only saw the first byte */
+	fprintf(stderr, "ERROR: Input file unparsable\n");
+	exit(8);
+    }
+    check_hdr(&bt->stream_hdr);
+
+    bt->map= NULL;
+    bt->hdr= &bt->stream_hdr;
+    bt->fp= fp;
+    bt->pos= 0;
+    bt->have_next= FALSE;
+
+    return bt;
+
+}  /* end of stream_open() */
+
+
+
+/*
+** Read the next record of a stream into bt->next. FALSE, if it is not
+** all there.
+*/
+static int
+stream_read(bintrace_t *bt)
+{
+
+    if (fread(&bt->next, sizeof(bintrace_rec_t), 1, bt->fp) != 1)   {
+	return FALSE;
+    }
+    bt->pos++;
+
+    return TRUE;
+
+}  /* end of stream_read() */
+
+
+
+static void
+check_hdr(const bintrace_hdr_t *hdr)
+{
+
+    if (hdr->byte_order != BINTRACE_BYTE_ORDER)   {
+	fprintf(stderr, "ERROR: Binary trace was written on a machine with different byte order\n");
+	exit(2);
+    }
+
+    if (hdr->version != BINTRACE_VERSION)   {
+	fprintf(stderr, "ERROR: Binary trace version %d, expected %d\n", hdr->version, BINTRACE_VERSION);
+	exit(2);
+    }
+
+}  /* end of check_hdr() */
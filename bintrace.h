@@ -0,0 +1,66 @@
+/*
+** $Id$
+**
+** Binary fault trace format. Fixed-width records that can be mapped
+** into memory and read without any parsing.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _BINTRACE_H_
+#define _BINTRACE_H_
+
+#include <stdint.h>
+
+/*
+** File layout:
+**     bintrace_hdr_t		header
+**     bintrace_rec_t[]		num_records records, ascending in time
+**     double[]			sparse time index: time of every index_stride'th record
+**     char[]			num_classes NUL terminated error class names
+** All values are stored in the byte order of the machine that wrote the
+** file. byte_order lets the reader detect a mismatch.
+*/
+#define BINTRACE_MAGIC		"APPMTRC1"
+#define BINTRACE_VERSION	(1)
+#define BINTRACE_BYTE_ORDER	(0x01020304)
+#define BINTRACE_INDEX_STRIDE	(4096)
+
+typedef struct bintrace_hdr_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t num_records;
+    uint64_t index_stride;	/* Records between index entries */
+    uint64_t num_index;		/* Number of index entries */
+    uint64_t index_offset;	/* Byte offset of the index from start of file */
+    uint64_t num_classes;	/* Number of distinct error strings */
+    uint64_t class_offset;	/* Byte offset of the class name table */
+    int32_t num_nodes;		/* Highest node ID + 1 */
+    int32_t unused;
+    double t_first;		/* Time of first and last record in seconds */
+    double t_last;
+} bintrace_hdr_t;
+
+typedef struct bintrace_rec_t   {
+    double t;			/* Seconds, as in the text format */
+    int32_t node;
+    int32_t err_class;		/* Index into the class name table */
+} bintrace_rec_t;
+
+typedef struct bintrace_t bintrace_t;
+
+
+int bintrace_probe(FILE *fp);
+bintrace_t *bintrace_open(FILE *fp);
+void bintrace_close(bintrace_t *bt);
+int bintrace_next(bintrace_t *bt, double *t, int *node);
+void bintrace_seek(bintrace_t *bt, double t);
+const bintrace_hdr_t *bintrace_hdr(bintrace_t *bt);
+
+#endif /* _BINTRACE_H_ */
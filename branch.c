@@ -0,0 +1,281 @@
+/*
+** $Id$
+**
+** What-if branches. See branch.h.
+**
+** When app_model() reaches --branch_at, it hands its loop variables to
+** branch_run(). That starts one task per branch through run_tasks(), so
+** each branch is a forked child with a copy-on-write copy of the nodes,
+** the search tree, and the time keepers. The child changes the
+** parameters, gives itself its own random number stream, and calls
+** app_model() again to continue where its parent stopped. The parent
+** collects the results and app_model() returns without finishing the
+** run itself.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+#include "writer.h"
+#include "rnd.h"
+#include "tasks.h"
+#include "snapshot.h"
+#include "app.h"
+#include "branch.h"
+
+
+/* What branch_task() needs to know */
+typedef struct branch_arg_t   {
+    snapshot_state_t state;
+    int verbose;
+} branch_arg_t;
+
+
+static double branch_at= -1.0;
+static int num;
+static branch_t *list;
+static int jobs;
+
+static int taken= FALSE;
+static branch_point_t point;
+static branch_result_t *results;
+static int *status;
+
+
+/* Local functions */
+static void branch_task(int task, void *arg, void *result);
+
+
+
+/*
+** Parse a --branch spec: a comma separated list of tau=, checkpoint=,
+** restart=, and ras_delay= in minutes, soft_reboot=<success>:<reboot time>
+** or soft_reboot=off, and hotswap=on or off. "unchanged" changes nothing.
+** Returns FALSE, if the spec is invalid.
+*/
+int
+branch_parse(char *spec, branch_t *b)
+{
+
+char *copy;
+char *item;
+char *value;
+char *endptr;
+int ok;
+
+
+    memset(b, 0, sizeof(branch_t));
+    b->spec= spec;
+    if (strcmp(spec, "unchanged") == 0)   {
+	return TRUE;
+    }
+
+    copy= strdup(spec);
+    if (copy == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    ok= TRUE;
+    for (item= strtok(copy, ","); ok && item; item= strtok(NULL, ","))   {
+	value= strchr(item, '=');
+	if (value == NULL)   {
+	    ok= FALSE;
+	    break;
+	}
+	*value++= '\0';
+
+	if (strcmp(item, "tau") == 0)   {
+	    b->tau= strtod(value, &endptr);
+	    ok= (endptr != value) && (*endptr == '\0') && (b->tau > 0.0);
+	    b->set|= BRANCH_TAU;
+	} else if (strcmp(item, "checkpoint") == 0)   {
+	    b->checkpoint_time= strtod(value, &endptr);
+	    ok= (endptr != value) && (*endptr == '\0') && (b->checkpoint_time > 0.0);
+	    b->set|= BRANCH_CHECKPOINT;
+	} else if (strcmp(item, "restart") == 0)   {
+	    b->restart_time= strtod(value, &endptr);
+	    ok= (endptr != value) && (*endptr == '\0') && (b->restart_time > 0.0);
+	    b->set|= BRANCH_RESTART;
+	} else if (strcmp(item, "ras_delay") == 0)   {
+	    b->ras_delay= strtod(value, &endptr);
+	    ok= (endptr != value) && (*endptr == '\0') && (b->ras_delay >= 0.0);
+	    b->set|= BRANCH_RAS_DELAY;
+	} else if (strcmp(item, "soft_reboot") == 0)   {
+	    if (strcmp(value, "off") == 0)   {
+		b->soft_reboot_success_rate= -1.0;
+		b->soft_time_to_reboot= 0.0;
+	    } else   {
+		ok= (sscanf(value, "%f:%f", &b->soft_reboot_success_rate,
+			&b->soft_time_to_reboot) == 2) &&
+		    (b->soft_reboot_success_rate >= 0.0) &&
+		    (b->soft_reboot_success_rate <= 100.0) && (b->soft_time_to_reboot >= 0.0);
+	    }
+	    b->set|= BRANCH_SOFT_REBOOT;
+	} else if (strcmp(item, "hotswap") == 0)   {
+	    if (strcmp(value, "on") == 0)   {
+		b->hotswap= TRUE;
+	    } else if (strcmp(value, "off") == 0)   {
+		b->hotswap= FALSE;
+	    } else   {
+		ok= FALSE;
+	    }
+	    b->set|= BRANCH_HOTSWAP;
+	} else   {
+	    ok= FALSE;
+	}
+    }
+
+    free(copy);
+    return ok;
+
+}  /* end of branch_parse() */
+
+
+
+/*
+** Branch the next app_model() call at "at" minutes of elapsed time.
+** An unchanged branch is added in front of the ones given, so the
+** others can be compared to it. At most max_jobs branches run at the
+** same time.
+*/
+void
+branch_setup(double at, int num_branches, branch_t *branches, int max_jobs)
+{
+
+    branch_at= at;
+    jobs= max_jobs;
+    num= num_branches + 1;
+    list= (branch_t *)malloc(num * sizeof(branch_t));
+    if (list == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    branch_parse("unchanged", &list[0]);
+    memcpy(&list[1], branches, num_branches * sizeof(branch_t));
+
+}  /* end of branch_setup() */
+
+
+
+/*
+** TRUE, if app_model() should call branch_run() now
+*/
+int
+branch_due(double elapsed_time)
+{
+
+    return (branch_at >= 0.0) && (elapsed_time >= branch_at);
+
+}  /* end of branch_due() */
+
+
+
+/*
+** Run all branches from the app_model() state. Returns when they are
+** done.
+*/
+void
+branch_run(snapshot_state_t *state, int verbose)
+{
+
+branch_arg_t arg;
+
+
+    /* Only once; the branches do not branch again */
+    branch_at= -1.0;
+
+    /* The one we are on was counted already */
+    point.elapsed_time= state->elapsed_time;
+    point.work_done= total_work_time;
+    point.interrupt_cnt= interrupt_cnt - 1;
+
+    results= (branch_result_t *)malloc(num * sizeof(branch_result_t));
+    status= (int *)malloc(num * sizeof(int));
+    if ((results == NULL) || (status == NULL))   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    arg.state= *state;
+    arg.verbose= verbose;
+    run_tasks(num, jobs, branch_task, &arg, results, sizeof(branch_result_t), status);
+    taken= TRUE;
+
+}  /* end of branch_run() */
+
+
+
+/*
+** The branches, their results, and where they started. Returns the
+** number of branches, or 0 if the run did not get to --branch_at.
+*/
+int
+branch_results(branch_t **branches, branch_result_t **res, int **stat, branch_point_t *p)
+{
+
+    if (!taken)   {
+	return 0;
+    }
+
+    *branches= list;
+    *res= results;
+    *stat= status;
+    *p= point;
+    return num;
+
+}  /* end of branch_results() */
+
+
+
+/*
+** Finish the run with the parameters of one branch. This runs in a
+** child process.
+*/
+static void
+branch_task(int task, void *arg, void *result)
+{
+
+branch_arg_t *a= arg;
+branch_result_t *res= result;
+branch_t *b= &list[task];
+snapshot_state_t state;
+snapshot_params_t *p;
+double elapsed;
+
+
+    state= a->state;
+    p= &state.params;
+    if (b->set & BRANCH_TAU)		p->tau= b->tau;
+    if (b->set & BRANCH_CHECKPOINT)	p->checkpoint_time= b->checkpoint_time;
+    if (b->set & BRANCH_RESTART)	p->restart_time= b->restart_time;
+    if (b->set & BRANCH_RAS_DELAY)	p->ras_delay= b->ras_delay;
+    if (b->set & BRANCH_SOFT_REBOOT)   {
+	p->soft_reboot_success_rate= b->soft_reboot_success_rate;
+	p->soft_time_to_reboot= b->soft_time_to_reboot;
+    }
+    if (b->set & BRANCH_HOTSWAP)	p->hotswap= b->hotswap;
+    res->params= *p;
+
+    /* Same state, but not the same random numbers as the other branches */
+    rnd_split(task);
+    app_snapshot(0.0, NULL);
+    app_continue(&state);
+    elapsed= app_model(a->verbose, p->tau, p->checkpoint_time, p->restart_time, p->work_time,
+		p->ras_delay, NULL, NULL, p->soft_time_to_reboot, p->soft_reboot_success_rate,
+		p->hotswap);
+
+    /* At this point we're one over */
+    interrupt_cnt--;
+    save_results(&res->r, elapsed);
+
+}  /* end of branch_task() */
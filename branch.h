@@ -0,0 +1,61 @@
+/*
+** $Id$
+**
+** What-if branches: at --branch_at, the simulation forks into one
+** child process per --branch, and each one finishes the run with its
+** own parameters.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _BRANCH_H_
+#define _BRANCH_H_
+
+/* Which parameters a branch changes */
+#define BRANCH_TAU		(1 << 0)
+#define BRANCH_CHECKPOINT	(1 << 1)
+#define BRANCH_RESTART		(1 << 2)
+#define BRANCH_RAS_DELAY	(1 << 3)
+#define BRANCH_SOFT_REBOOT	(1 << 4)
+#define BRANCH_HOTSWAP		(1 << 5)
+
+/* A --branch. Times in minutes */
+typedef struct branch_t   {
+    char *spec;			/* As given on the command line */
+    int set;			/* BRANCH_* bits of the values below */
+    double tau;
+    double checkpoint_time;
+    double restart_time;
+    double ras_delay;
+    float soft_reboot_success_rate;	/* < 0 turns soft reboots off */
+    float soft_time_to_reboot;
+    int hotswap;
+} branch_t;
+
+/* The results of one branch, and the parameters it finished the run with */
+typedef struct branch_result_t   {
+    snapshot_params_t params;
+    result_t r;
+} branch_result_t;
+
+/* Where the simulation was when it branched */
+typedef struct branch_point_t   {
+    double elapsed_time;
+    double work_done;
+    int interrupt_cnt;
+} branch_point_t;
+
+
+int branch_parse(char *spec, branch_t *b);
+void branch_setup(double at, int num_branches, branch_t *branches, int max_jobs);
+int branch_due(double elapsed_time);
+void branch_run(snapshot_state_t *state, int verbose);
+int branch_results(branch_t **branches, branch_result_t **results, int **status,
+	branch_point_t *point);
+
+#endif /* _BRANCH_H_ */
@@ -0,0 +1,240 @@
+/*
+** $Id$
+**
+** The --cache directory. See cache.h.
+**
+** Lookups and stores happen in the process that hands out the work; the
+** forked children of a sweep never touch the cache. Several two_step
+** processes can share a directory: an entry only appears, complete,
+** when rename() puts it in place, and two processes that simulate the
+** same point write the same bytes.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "globals.h"
+#include "hist.h"
+#include "cache.h"
+
+
+static char *cache_dir= NULL;
+
+
+/* Local functions */
+static void entry_name(cache_key_t *key, char *path, size_t size, int dir_only);
+static int read_hist(FILE *fp);
+
+
+
+/*
+** Add size bytes to the hash h. Start with CACHE_HASH_INIT.
+*/
+uint64_t
+cache_hash(uint64_t h, const void *buf, size_t size)
+{
+
+const unsigned char *p= buf;
+
+
+    while (size-- > 0)   {
+	h= (h ^ *p++) * 1099511628211ULL;
+    }
+
+    return h;
+
+}  /* end of cache_hash() */
+
+
+
+/*
+** Use this directory, and create it, if it does not exist yet
+*/
+void
+cache_open(char *dir)
+{
+
+    if ((mkdir(dir, 0777) != 0) && (errno != EEXIST))   {
+	fprintf(stderr, "Could not create cache directory \"%s\": %s\n", dir, strerror(errno));
+	exit(2);
+    }
+    cache_dir= dir;
+
+}  /* end of cache_open() */
+
+
+
+/*
+** Look up the result for this key. For a CACHE_RUN this loads the
+** histograms as well. Returns FALSE, if there is no such entry, or it
+** cannot be read; the histograms are empty then.
+*/
+int
+cache_get(cache_key_t *key, result_t *r)
+{
+
+char path[4096];
+FILE *fp;
+cache_hdr_t hdr;
+cache_key_t stored;
+uint32_t end;
+int ok;
+
+
+    entry_name(key, path, sizeof(path), FALSE);
+    fp= fopen(path, "r");
+    if (fp == NULL)   {
+	return FALSE;
+    }
+
+    ok= (fread(&hdr, sizeof(hdr), 1, fp) == 1) &&
+	(memcmp(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic)) == 0) &&
+	(hdr.version == CACHE_VERSION) && (hdr.byte_order == CACHE_BYTE_ORDER) &&
+	(hdr.key_size == sizeof(cache_key_t)) && (hdr.result_size == sizeof(result_t)) &&
+	(fread(&stored, sizeof(stored), 1, fp) == 1) &&
+	(memcmp(&stored, key, sizeof(stored)) == 0) &&
+	(fread(r, sizeof(result_t), 1, fp) == 1);
+
+    if (ok && (key->kind == CACHE_RUN))   {
+	ok= read_hist(fp);
+    }
+    ok= ok && (fread(&end, sizeof(end), 1, fp) == 1) && (end == CACHE_END);
+    fclose(fp);
+
+    if (!ok && (key->kind == CACHE_RUN))   {
+	hist_reset();
+    }
+    return ok;
+
+}  /* end of cache_get() */
+
+
+
+/*
+** Store the result for this key. For a CACHE_RUN, the histograms are
+** stored with it. Returns FALSE, if that did not work.
+*/
+int
+cache_put(cache_key_t *key, result_t *r)
+{
+
+char path[4096];
+char tmp[4096 + 32];
+FILE *fp;
+cache_hdr_t hdr;
+uint32_t end;
+int rc;
+
+
+    entry_name(key, path, sizeof(path), TRUE);
+    if ((mkdir(path, 0777) != 0) && (errno != EEXIST))   {
+	fprintf(stderr, "Warning: Could not create cache directory \"%s\": %s\n", path,
+	    strerror(errno));
+	return FALSE;
+    }
+
+    /* Each process writes its own temporary file */
+    entry_name(key, path, sizeof(path), FALSE);
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+    fp= fopen(tmp, "w");
+    if (fp == NULL)   {
+	fprintf(stderr, "Warning: Could not write cache entry \"%s\": %s\n", tmp, strerror(errno));
+	return FALSE;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version= CACHE_VERSION;
+    hdr.byte_order= CACHE_BYTE_ORDER;
+    hdr.key_size= sizeof(cache_key_t);
+    hdr.result_size= sizeof(result_t);
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(key, sizeof(cache_key_t), 1, fp);
+    fwrite(r, sizeof(result_t), 1, fp);
+    if (key->kind == CACHE_RUN)   {
+	hist_save(fp);
+    }
+    end= CACHE_END;
+    fwrite(&end, sizeof(end), 1, fp);
+
+    rc= ferror(fp);
+    if ((fclose(fp) != 0) || rc)   {
+	fprintf(stderr, "Warning: Could not write cache entry \"%s\"\n", tmp);
+	remove(tmp);
+	return FALSE;
+    }
+
+    if (rename(tmp, path) != 0)   {
+	fprintf(stderr, "Warning: Could not rename \"%s\" to \"%s\": %s\n", tmp, path,
+	    strerror(errno));
+	remove(tmp);
+	return FALSE;
+    }
+
+    return TRUE;
+
+}  /* end of cache_put() */
+
+
+
+/*
+** The file of an entry, or the directory it is in. The first byte of
+** the hash is the directory, so none of them gets too large.
+*/
+static void
+entry_name(cache_key_t *key, char *path, size_t size, int dir_only)
+{
+
+uint64_t h;
+
+
+    h= cache_hash(CACHE_HASH_INIT, key, sizeof(cache_key_t));
+    if (dir_only)   {
+	snprintf(path, size, "%s/%02x", cache_dir, (unsigned int)(h >> 56));
+    } else   {
+	snprintf(path, size, "%s/%02x/%014llx", cache_dir, (unsigned int)(h >> 56),
+	    (unsigned long long)(h & 0x00ffffffffffffffULL));
+    }
+
+}  /* end of entry_name() */
+
+
+
+/*
+** hist_load() ends the program, if the file is short. A damaged entry
+** is only a miss.
+*/
+static int
+read_hist(FILE *fp)
+{
+
+jmp_buf env;
+jmp_buf *outer;
+volatile int ok;
+
+
+    outer= sim_jmp;
+    sim_jmp= &env;
+    ok= FALSE;
+    if (setjmp(env) == 0)   {
+	hist_load(fp);
+	ok= TRUE;
+    }
+    sim_jmp= outer;
+
+    return ok;
+
+}  /* end of read_hist() */
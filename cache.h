@@ -0,0 +1,84 @@
+/*
+** $Id$
+**
+** --cache: results of earlier runs on disk, so a run with the same
+** parameters, engine version, and seed is not simulated again.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <stdint.h>
+
+/*
+** Each result is a file DIR/xx/yyyyyyyyyyyyyy, named after the 64-bit
+** hash of its key:
+**     cache_hdr_t		header
+**     cache_key_t		the key, compared on lookup, so a hash collision is a miss
+**     result_t			the time keepers and counters of globals.c, as reported
+**     hist_save()		histograms, CACHE_RUN only
+**     CACHE_END		marks a complete file
+** Files are written under a temporary name and renamed, so processes
+** that share a directory never see half an entry. All values are in the
+** byte order of the machine that wrote the file. Change CACHE_VERSION,
+** when any of the sections change.
+*/
+#define CACHE_MAGIC		"APPMCAC1"
+#define CACHE_VERSION		(2)	/* 1 kept one interrupt too many for CACHE_RUN */
+#define CACHE_BYTE_ORDER	(0x01020304)
+#define CACHE_END		(0x454e4421)
+
+/* FNV-1a */
+#define CACHE_HASH_INIT		(14695981039346656037ULL)
+
+/* A complete single run, or one size or window of a sweep */
+#define CACHE_RUN		(1)
+#define CACHE_POINT		(2)
+
+typedef struct cache_hdr_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t key_size;		/* sizeof(cache_key_t) */
+    uint32_t result_size;	/* sizeof(result_t) */
+} cache_hdr_t;
+
+/*
+** Everything the result depends on, after the defaults have been
+** calculated. Clear it with memset() before filling it in; it is hashed
+** and compared as bytes. Times in minutes.
+*/
+typedef struct cache_key_t   {
+    char version[16];		/* VERSION of two_step */
+    int32_t kind;		/* CACHE_RUN or CACHE_POINT */
+    int32_t num_bundles;
+    int32_t num_redundant;
+    int32_t hotswap;
+    double tau;
+    double sys_mtbf;
+    double app_mtbf;
+    double checkpoint_time;
+    double restart_time;
+    double work_time;
+    double ras_delay;
+    float soft_time_to_reboot;
+    float soft_reboot_success_rate;
+    double offset;		/* Into the --input */
+    uint64_t rnd;		/* rnd_hash(): distribution, generator, and its state */
+    uint64_t input;		/* input_hash(): the faults replayed from --input */
+} cache_key_t;
+
+
+uint64_t cache_hash(uint64_t h, const void *buf, size_t size);
+void cache_open(char *dir);
+int cache_get(cache_key_t *key, result_t *r);
+int cache_put(cache_key_t *key, result_t *r);
+
+#endif /* _CACHE_H_ */
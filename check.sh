@@ -0,0 +1,78 @@
+#!/bin/sh
+#
+## $Id$
+##
+## Run two_step on option combinations with a known outcome and check
+## the exit code. "make check" runs this script; see COMPILING in the
+## README.
+##
+## This file is part of app_model. App_model is free software and
+## is distributed under the terms of the GNU General Public License
+## Version 3. See the file LICENSE for details.
+#
+
+here=$(cd "$(dirname "$0")" && pwd)
+two_step=$here/two_step
+if [ ! -x "$two_step" ]; then
+    echo "$two_step not found. Run make first." >&2
+    exit 2
+fi
+
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/check.XXXXXX") || exit 2
+trap 'rm -rf "$tmp"' EXIT INT TERM
+
+failed=0
+
+#
+## Run two_step and compare its exit code to the expected one.
+## expect name exit_code two_step_options...
+#
+expect()
+{
+    name=$1
+    want=$2
+    shift 2
+
+    "$two_step" "$@" > "$tmp/out.txt" 2> "$tmp/err.txt"
+    rc=$?
+    if [ $rc -eq $want ]; then
+	printf "  %-40s ok\n" "$name"
+    else
+	printf "  %-40s FAILED (exit %d, expected %d)\n" "$name" $rc $want
+	sed 's/^/    /' "$tmp/err.txt"
+	failed=$((failed + 1))
+    fi
+}
+
+#
+## A short trace: faults on nodes 0 to 199 over 20,000 hours
+#
+awk 'BEGIN {
+    srand(1)
+    t= 0
+    for (i= 0; i < 2000; i++)   {
+	t= t + 36000 * -log(1 - rand())
+	printf "%d %d ERR\n", t, int(rand() * 200)
+    }
+}' > "$tmp/trace.txt"
+
+echo "Checking $two_step"
+expect input_r0 0 -n 100 -w 100 --input "$tmp/trace.txt"
+expect input_rfull 0 -n 100 -r 100 -w 100 --input "$tmp/trace.txt"
+expect soft_reboot_rfull 0 -n 100 -r 100 -w 100 -m 100000 --soft_reboot 0.5,10
+expect sizes_r0 0 -n 100 -w 100 --input "$tmp/trace.txt" --sizes 25,50,100
+expect sizes_rhalf 0 -n 100 -r 50 -w 100 --input "$tmp/trace.txt" --sizes 25,50,100
+# Traces do not model soft reboots
+expect input_soft_reboot 1 -n 100 -w 100 --input "$tmp/trace.txt" --soft_reboot 0.5,10
+expect input_rfull_soft_reboot 1 -n 100 -r 100 -w 100 --input "$tmp/trace.txt" \
+    --soft_reboot 0.5,10
+expect input_rfull_branch_soft_reboot 1 -n 100 -r 100 -w 100 --input "$tmp/trace.txt" \
+    --branch_at 10 --branch soft_reboot=50:10
+expect input_rfull_branch_soft_reboot_off 0 -n 100 -r 100 -w 100 --input "$tmp/trace.txt" \
+    --branch_at 10 --branch soft_reboot=off
+
+if [ $failed -gt 0 ]; then
+    echo "$failed check(s) failed"
+    exit 1
+fi
+exit 0
@@ -0,0 +1,175 @@
+/*
+** $Id$
+**
+** Convert a columnar result file, as written by two_step --columnar,
+** into CSV. The layout of the file is described in colfile.h.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "globals.h"
+#include "colfile.h"
+#include "record.h"
+
+
+static void read_or_die(void *buf, size_t size, FILE *fp, char *what);
+static void usage(char *prog);
+
+
+
+int
+main(int argc, char *argv[])
+{
+
+FILE *fp_in;
+colfile_hdr_t hdr;
+colfile_col_t *cols;
+colfile_group_t group;
+char **data;
+unsigned long num_rows;
+uint32_t i, row;
+int32_t iv;
+double dv;
+char str[RECORD_DOUBLE_SIZE];
+
+
+    if (argc != 2)   {
+	usage(argv[0]);
+	exit(1);
+    }
+
+    if (strcmp(argv[1], "-") == 0)   {
+	fp_in= stdin;
+    } else   {
+	fp_in= fopen(argv[1], "r");
+	if (fp_in == NULL)   {
+	    fprintf(stderr, "Could not open input file \"%s\": %s\n", argv[1], strerror(errno));
+	    exit(2);
+	}
+    }
+
+    read_or_die(&hdr, sizeof(hdr), fp_in, "header");
+    if (memcmp(hdr.magic, COLFILE_MAGIC, sizeof(hdr.magic)) != 0)   {
+	fprintf(stderr, "ERROR: \"%s\" is not a columnar result file\n", argv[1]);
+	exit(8);
+    }
+    if (hdr.byte_order != COLFILE_BYTE_ORDER)   {
+	fprintf(stderr, "ERROR: \"%s\" was written on a machine with a different byte order\n",
+	    argv[1]);
+	exit(8);
+    }
+    if (hdr.version != COLFILE_VERSION)   {
+	fprintf(stderr, "ERROR: \"%s\" is version %u. I can only read version %d\n",
+	    argv[1], hdr.version, COLFILE_VERSION);
+	exit(8);
+    }
+
+    cols= (colfile_col_t *)malloc(hdr.num_columns * sizeof(colfile_col_t));
+    data= (char **)malloc(hdr.num_columns * sizeof(char *));
+    if ((cols == NULL) || (data == NULL))   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    read_or_die(cols, hdr.num_columns * sizeof(colfile_col_t), fp_in, "schema");
+    for (i= 0; i < hdr.num_columns; i++)   {
+	cols[i].name[COLFILE_NAME_LEN - 1]= '\0';
+	if (((cols[i].type != COLFILE_INT32) || (cols[i].size != sizeof(int32_t))) &&
+		((cols[i].type != COLFILE_DOUBLE) || (cols[i].size != sizeof(double))))   {
+	    fprintf(stderr, "ERROR: Column \"%s\" has unknown type %u\n", cols[i].name,
+		cols[i].type);
+	    exit(8);
+	}
+	data[i]= (char *)malloc((size_t)hdr.rows_per_group * cols[i].size);
+	if (data[i] == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	printf("%s%s", (i > 0) ? "," : "", cols[i].name);
+    }
+    printf("\n");
+
+    num_rows= 0;
+    while (fread(&group, sizeof(group), 1, fp_in) == 1)   {
+	if ((memcmp(group.magic, COLFILE_GROUP_MAGIC, sizeof(group.magic)) != 0) ||
+		(group.num_rows > hdr.rows_per_group))   {
+	    fprintf(stderr, "ERROR: Bad row group after %lu rows\n", num_rows);
+	    exit(8);
+	}
+
+	for (i= 0; i < hdr.num_columns; i++)   {
+	    read_or_die(data[i], (size_t)group.num_rows * cols[i].size, fp_in, "row group");
+	}
+
+	for (row= 0; row < group.num_rows; row++)   {
+	    for (i= 0; i < hdr.num_columns; i++)   {
+		if (i > 0)   {
+		    putchar(',');
+		}
+		if (cols[i].type == COLFILE_INT32)   {
+		    memcpy(&iv, data[i] + row * sizeof(iv), sizeof(iv));
+		    printf("%d", iv);
+		} else   {
+		    memcpy(&dv, data[i] + row * sizeof(dv), sizeof(dv));
+		    if (isfinite(dv))   {
+			record_fmt_double(str, dv);
+			fputs(str, stdout);
+		    }
+		}
+	    }
+	    putchar('\n');
+	}
+	num_rows= num_rows + group.num_rows;
+    }
+
+    if (ferror(fp_in))   {
+	fprintf(stderr, "Read of \"%s\" failed: %s\n", argv[1], strerror(errno));
+	exit(2);
+    }
+    if (fp_in != stdin)   {
+	fclose(fp_in);
+    }
+
+    for (i= 0; i < hdr.num_columns; i++)   {
+	free(data[i]);
+    }
+    free(data);
+    free(cols);
+
+    return 0;
+
+}  /* end of main() */
+
+
+
+static void
+read_or_die(void *buf, size_t size, FILE *fp, char *what)
+{
+
+    if ((size > 0) && (fread(buf, size, 1, fp) != 1))   {
+	fprintf(stderr, "ERROR: Columnar result file ends in the %s\n", what);
+	exit(8);
+    }
+
+}  /* end of read_or_die() */
+
+
+
+static void
+usage(char *prog)
+{
+    fprintf(stderr, "Usage: %s result_file\n", prog);
+    fprintf(stderr, "    Convert a columnar result file written by two_step --columnar into CSV\n");
+    fprintf(stderr, "    on stdout. Use - to read from stdin.\n");
+}  /* end of usage() */
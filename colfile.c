@@ -0,0 +1,237 @@
+/*
+** $Id$
+**
+** Write columnar result files. Rows are collected column by column,
+** and every COLFILE_ROWS_PER_GROUP rows the group is handed to a
+** writer thread, so the simulation never waits for the disk. The
+** layout is described in colfile.h.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>		/* For offsetof() */
+#include <string.h>
+#include <errno.h>
+
+#include "globals.h"
+#include "writer.h"
+#include "colfile.h"
+
+
+typedef struct col_def_t   {
+    const char *name;
+    int type;
+    size_t offset;		/* Of the value in colfile_row_t */
+} col_def_t;
+
+#define INT_COL(name, field)	{name, COLFILE_INT32, offsetof(colfile_row_t, field)}
+#define DBL_COL(name, field)	{name, COLFILE_DOUBLE, offsetof(colfile_row_t, field)}
+
+/*
+** The schema. Names and units are the same as the columns of the sweep
+** records of --format csv, so the two can be joined. A --sizes record
+** has no sweep.offset_min, and a window record no sweep.nodes. The
+** performance.* columns are in the records with -p.
+*/
+static const col_def_t columns[]=   {
+    INT_COL("sweep.nodes", active_nodes),
+    INT_COL("parameters.redundant_nodes", redundant_nodes),
+    DBL_COL("sweep.offset_min", offset),
+    DBL_COL("sweep.checkpoint_interval_min", tau),
+    DBL_COL("parameters.checkpoint_min", checkpoint_time),
+    DBL_COL("parameters.restart_min", restart_time),
+    DBL_COL("parameters.work_min", work_time),
+    DBL_COL("parameters.node_mtbf_min", node_mtbf),
+    DBL_COL("parameters.ras_delay_min", ras_delay),
+    DBL_COL("parameters.soft_reboot_min", soft_time_to_reboot),
+    DBL_COL("parameters.soft_reboot_success_rate", soft_reboot_success_rate),
+    INT_COL("sweep.status", status),
+    DBL_COL("simulation.completed_work_min", r.total_work_time),
+    DBL_COL("simulation.elapsed_min", r.elapsed_time),
+    DBL_COL("simulation.restart_min", restart),
+    DBL_COL("simulation.rework_min", rework),
+    DBL_COL("simulation.work_min", work),
+    DBL_COL("simulation.checkpoint_min", checkpoint),
+    DBL_COL("simulation.ras_delay_min", r.total_ras_delay),
+    DBL_COL("simulation.wasted_restart_min", r.wasted_restart_time),
+    DBL_COL("simulation.wasted_rework_min", r.wasted_rework_time),
+    DBL_COL("simulation.wasted_work_min", r.wasted_work_time),
+    DBL_COL("simulation.wasted_checkpoint_min", r.wasted_checkpoint_time),
+    INT_COL("simulation.restarts", r.restart_cnt),
+    INT_COL("simulation.failed_restarts", r.failed_restart_cnt),
+    INT_COL("simulation.reworks", r.rework_cnt),
+    INT_COL("simulation.failed_reworks", r.failed_rework_cnt),
+    INT_COL("simulation.work_segments", r.work_cnt),
+    INT_COL("simulation.failed_work_segments", r.failed_work_cnt),
+    INT_COL("simulation.checkpoints", r.checkpoint_cnt),
+    INT_COL("simulation.failed_checkpoints", r.failed_checkpoint_cnt),
+    INT_COL("simulation.interrupts", r.interrupt_cnt),
+    INT_COL("simulation.faults", r.fault_cnt),
+    INT_COL("simulation.failed_nodes", r.node_failure_cnt),
+    INT_COL("simulation.repaired_nodes", r.total_repaired),
+    INT_COL("simulation.soft_reboots", r.soft_reboot_success_cnt),
+    INT_COL("simulation.failed_soft_reboots", r.soft_reboot_failure_cnt),
+    INT_COL("simulation.stopped_early", r.stopped_early),
+    INT_COL("performance.random_numbers", r.rnd_gen_cnt),
+    INT_COL("performance.random_probabilities", r.rnd_prob_cnt),
+    INT_COL("performance.rmpi_calls", r.calls_rMPI),
+    INT_COL("performance.input_faults_read", r.read_input_cnt),
+    INT_COL("performance.input_faults_accepted", r.read_input_accepted),
+};
+
+#define NUM_COLUMNS	((int)(sizeof(columns) / sizeof(columns[0])))
+
+
+struct colfile_t   {
+    FILE *fp;
+    writer_t *w;
+    char *data[NUM_COLUMNS];	/* COLFILE_ROWS_PER_GROUP values per column */
+    int num_rows;		/* In the current group */
+};
+
+
+/* Local functions */
+static int col_size(const col_def_t *col);
+static void write_group(colfile_t *c);
+
+
+
+colfile_t *
+colfile_open(char *fname)
+{
+
+colfile_t *c;
+colfile_hdr_t hdr;
+colfile_col_t col;
+int i;
+
+
+    c= (colfile_t *)malloc(sizeof(colfile_t));
+    if (c == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    c->fp= fopen(fname, "w");
+    if (c->fp == NULL)   {
+	fprintf(stderr, "Could not open output file \"%s\": %s\n", fname, strerror(errno));
+	exit(2);
+    }
+    c->w= writer_open(c->fp, TRUE, TRUE);
+    c->num_rows= 0;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, COLFILE_MAGIC, sizeof(hdr.magic));
+    hdr.version= COLFILE_VERSION;
+    hdr.byte_order= COLFILE_BYTE_ORDER;
+    hdr.num_columns= NUM_COLUMNS;
+    hdr.rows_per_group= COLFILE_ROWS_PER_GROUP;
+    writer_data(c->w, &hdr, sizeof(hdr));
+
+    for (i= 0; i < NUM_COLUMNS; i++)   {
+	memset(&col, 0, sizeof(col));
+	strncpy(col.name, columns[i].name, COLFILE_NAME_LEN - 1);
+	col.type= columns[i].type;
+	col.size= col_size(&columns[i]);
+	writer_data(c->w, &col, sizeof(col));
+
+	c->data[i]= (char *)malloc(COLFILE_ROWS_PER_GROUP * col.size);
+	if (c->data[i] == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+    }
+
+    return c;
+
+}  /* end of colfile_open() */
+
+
+
+void
+colfile_row(colfile_t *c, colfile_row_t *row)
+{
+
+int size;
+int i;
+
+
+    for (i= 0; i < NUM_COLUMNS; i++)   {
+	size= col_size(&columns[i]);
+	memcpy(c->data[i] + c->num_rows * size, (char *)row + columns[i].offset, size);
+    }
+
+    c->num_rows++;
+    if (c->num_rows == COLFILE_ROWS_PER_GROUP)   {
+	write_group(c);
+    }
+
+}  /* end of colfile_row() */
+
+
+
+void
+colfile_close(colfile_t *c)
+{
+
+int i;
+
+
+    if (c == NULL)   {
+	return;
+    }
+
+    if (c->num_rows > 0)   {
+	write_group(c);
+    }
+    writer_close(c->w);
+    if (fclose(c->fp) != 0)   {
+	fprintf(stderr, "Write to result file failed: %s\n", strerror(errno));
+	exit(2);
+    }
+
+    for (i= 0; i < NUM_COLUMNS; i++)   {
+	free(c->data[i]);
+    }
+    free(c);
+
+}  /* end of colfile_close() */
+
+
+
+static int
+col_size(const col_def_t *col)
+{
+    return (col->type == COLFILE_INT32) ? sizeof(int32_t) : sizeof(double);
+}  /* end of col_size() */
+
+
+
+/*
+** Hand the current row group to the writer and start a new one
+*/
+static void
+write_group(colfile_t *c)
+{
+
+colfile_group_t group;
+int i;
+
+
+    memcpy(group.magic, COLFILE_GROUP_MAGIC, sizeof(group.magic));
+    group.num_rows= c->num_rows;
+    writer_data(c->w, &group, sizeof(group));
+
+    for (i= 0; i < NUM_COLUMNS; i++)   {
+	writer_data(c->w, c->data[i], c->num_rows * col_size(&columns[i]));
+    }
+    c->num_rows= 0;
+
+}  /* end of write_group() */
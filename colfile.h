@@ -0,0 +1,96 @@
+/*
+** $Id$
+**
+** Columnar binary result files. Each row is one run, or one size or
+** window of a sweep. col2csv converts them to CSV.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _COLFILE_H_
+#define _COLFILE_H_
+
+#include <stdint.h>
+
+/*
+** File layout:
+**     colfile_hdr_t		header
+**     colfile_col_t[]		num_columns column descriptions (the schema)
+**     row groups, each:
+**         colfile_group_t	group header
+**         column 0 values	num_rows values of the size in its colfile_col_t
+**         column 1 values
+**         ...
+** The last group may have fewer than rows_per_group rows. All values
+** are stored in the byte order of the machine that wrote the file.
+** byte_order lets the reader detect a mismatch.
+*/
+#define COLFILE_MAGIC		"APPMCOL1"
+#define COLFILE_GROUP_MAGIC	"RGRP"
+#define COLFILE_VERSION		(1)
+#define COLFILE_BYTE_ORDER	(0x01020304)
+#define COLFILE_ROWS_PER_GROUP	(1024)
+#define COLFILE_NAME_LEN	(48)
+
+#define COLFILE_INT32		(1)
+#define COLFILE_DOUBLE		(2)
+
+typedef struct colfile_hdr_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t num_columns;
+    uint32_t rows_per_group;
+} colfile_hdr_t;
+
+typedef struct colfile_col_t   {
+    char name[COLFILE_NAME_LEN];	/* NUL terminated */
+    uint32_t type;			/* COLFILE_INT32 or COLFILE_DOUBLE */
+    uint32_t size;			/* Bytes per value */
+} colfile_col_t;
+
+typedef struct colfile_group_t   {
+    char magic[4];
+    uint32_t num_rows;
+} colfile_group_t;
+
+
+/*
+** One row. Times are in minutes. Values that do not apply are NaN. The
+** totals in r do not include the wasted times; restart, rework, work,
+** and checkpoint do, like --format csv. For a task that failed, status
+** is its exit code and all results are 0.
+*/
+typedef struct colfile_row_t   {
+    int active_nodes;
+    int redundant_nodes;
+    double offset;
+    double tau;
+    double checkpoint_time;
+    double restart_time;
+    double work_time;
+    double node_mtbf;
+    double ras_delay;
+    double soft_time_to_reboot;
+    double soft_reboot_success_rate;
+    int status;
+    double restart;
+    double rework;
+    double work;
+    double checkpoint;
+    result_t r;
+} colfile_row_t;
+
+typedef struct colfile_t colfile_t;
+
+
+colfile_t *colfile_open(char *fname);
+void colfile_row(colfile_t *c, colfile_row_t *row);
+void colfile_close(colfile_t *c);
+
+#endif /* _COLFILE_H_ */
@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "globals.h"
+#include "perf.h"
 #include "data_structs.h"
 
 
@@ -28,9 +30,9 @@ nodelist_t *new;
     /* Get a new entry */
     new= (nodelist_t *)malloc(sizeof(nodelist_t));
     if (!new)   {
-	fprintf(stderr, "Out of memory\n");
-	exit(-1);
+	sim_error(10, "Out of memory!\n");
     }
+    perf_allocs++;
 
     new->node= node;
     new->next= NULL;
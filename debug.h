@@ -0,0 +1,65 @@
+/*
+** $Id$
+**
+** Trace output for -v. TRACE1() to TRACE5() print when the -v count is
+** at least 1 to 5. TRACE_LEVEL is the highest level compiled in; the
+** trace statements above it, including their arguments, are removed by
+** the preprocessor. "make release" builds with TRACE_LEVEL 0, so the
+** hot loops carry no trace code at all. Include fmt.h first.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _DEBUG_H_
+#define _DEBUG_H_
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL		(5)
+#endif
+
+#define TRACE_AT(verbose, level, ...) \
+	do   { \
+	    if ((verbose) >= (level))   { \
+		fmt_print(stderr, __VA_ARGS__); \
+	    } \
+	} while (0)
+
+/* Compiled out: only keep the compiler quiet about an unused verbose */
+#define TRACE_OFF(verbose)	((void)(verbose))
+
+#if TRACE_LEVEL >= 1
+#define TRACE1(verbose, ...)	TRACE_AT(verbose, 1, __VA_ARGS__)
+#else
+#define TRACE1(verbose, ...)	TRACE_OFF(verbose)
+#endif
+
+#if TRACE_LEVEL >= 2
+#define TRACE2(verbose, ...)	TRACE_AT(verbose, 2, __VA_ARGS__)
+#else
+#define TRACE2(verbose, ...)	TRACE_OFF(verbose)
+#endif
+
+#if TRACE_LEVEL >= 3
+#define TRACE3(verbose, ...)	TRACE_AT(verbose, 3, __VA_ARGS__)
+#else
+#define TRACE3(verbose, ...)	TRACE_OFF(verbose)
+#endif
+
+#if TRACE_LEVEL >= 4
+#define TRACE4(verbose, ...)	TRACE_AT(verbose, 4, __VA_ARGS__)
+#else
+#define TRACE4(verbose, ...)	TRACE_OFF(verbose)
+#endif
+
+#if TRACE_LEVEL >= 5
+#define TRACE5(verbose, ...)	TRACE_AT(verbose, 5, __VA_ARGS__)
+#else
+#define TRACE5(verbose, ...)	TRACE_OFF(verbose)
+#endif
+
+#endif /* _DEBUG_H_ */
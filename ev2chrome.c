@@ -0,0 +1,135 @@
+/*
+** $Id$
+**
+** Convert an event log, as written by two_step --events, into the
+** Chrome trace event format (JSON). Load the output in chrome://tracing
+** or Perfetto to see the simulated timeline. The viewer shows simulated
+** time: one simulated minute is 60 seconds on the time line.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "globals.h"
+#include "events.h"
+
+/* Trace timestamps are in microseconds */
+#define US_PER_MINUTE	(60.0 * 1000.0 * 1000.0)
+
+
+static const char *type_name(int type);
+static void usage(char *prog);
+
+
+
+int
+main(int argc, char *argv[])
+{
+
+FILE *fp_in;
+event_hdr_t hdr;
+event_rec_t rec;
+uint64_t num;
+
+
+    if (argc != 2)   {
+	usage(argv[0]);
+	exit(1);
+    }
+
+    if (strcmp(argv[1], "-") == 0)   {
+	fp_in= stdin;
+    } else   {
+	fp_in= fopen(argv[1], "r");
+	if (fp_in == NULL)   {
+	    fprintf(stderr, "Could not open input file \"%s\": %s\n", argv[1], strerror(errno));
+	    exit(2);
+	}
+    }
+
+    if ((fread(&hdr, sizeof(hdr), 1, fp_in) != 1) ||
+	    (memcmp(hdr.magic, EVENT_MAGIC, sizeof(hdr.magic)) != 0))   {
+	fprintf(stderr, "ERROR: \"%s\" is not an event log\n", argv[1]);
+	exit(8);
+    }
+    if (hdr.byte_order != EVENT_BYTE_ORDER)   {
+	fprintf(stderr, "ERROR: \"%s\" was written on a machine with a different byte order\n",
+	    argv[1]);
+	exit(8);
+    }
+    if (hdr.version != EVENT_VERSION)   {
+	fprintf(stderr, "ERROR: \"%s\" is version %u. I can only read version %d\n",
+	    argv[1], hdr.version, EVENT_VERSION);
+	exit(8);
+    }
+
+    printf("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"total_events\":%lu,"
+	"\"sample_every\":%lu,\"keep_last\":%lu},\n", (unsigned long)hdr.total_events,
+	(unsigned long)hdr.sample_every, (unsigned long)hdr.keep_last);
+    printf("\"traceEvents\":[\n");
+    printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"application\"}}");
+
+    for (num= 0; num < hdr.num_events; num++)   {
+	if (fread(&rec, sizeof(rec), 1, fp_in) != 1)   {
+	    fprintf(stderr, "ERROR: Event log ends after %lu of %lu events\n",
+		(unsigned long)num, (unsigned long)hdr.num_events);
+	    exit(8);
+	}
+
+	if (rec.type == EVENT_INTERRUPT)   {
+	    printf(",\n{\"name\":\"interrupt\",\"cat\":\"interrupt\",\"ph\":\"i\",\"s\":\"p\","
+		"\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{\"faults\":%d}}",
+		rec.start * US_PER_MINUTE, rec.faults);
+	} else   {
+	    printf(",\n{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+		"\"pid\":1,\"tid\":1,\"args\":{\"outcome\":\"%s\",\"faults\":%d}}",
+		type_name(rec.type), rec.start * US_PER_MINUTE,
+		(rec.end - rec.start) * US_PER_MINUTE,
+		(rec.outcome == EVENT_INTERRUPTED) ? "interrupted" : "done", rec.faults);
+	}
+    }
+    printf("\n]}\n");
+
+    if (fp_in != stdin)   {
+	fclose(fp_in);
+    }
+
+    return 0;
+
+}  /* end of main() */
+
+
+
+static const char *
+type_name(int type)
+{
+
+    switch (type)   {
+	case EVENT_RESTART:	return "restart";
+	case EVENT_REWORK:	return "rework";
+	case EVENT_WORK:	return "work";
+	case EVENT_CHECKPOINT:	return "checkpoint";
+	case EVENT_RAS_DELAY:	return "RAS delay";
+	default:		return "unknown";
+    }
+
+}  /* end of type_name() */
+
+
+
+static void
+usage(char *prog)
+{
+    fprintf(stderr, "Usage: %s event_log\n", prog);
+    fprintf(stderr, "    Convert an event log written by two_step --events into Chrome trace\n");
+    fprintf(stderr, "    JSON on stdout. Use - to read from stdin.\n");
+}  /* end of usage() */
@@ -0,0 +1,244 @@
+/*
+** $Id$
+**
+** Log the phases of the simulation to a binary file. Long runs produce
+** billions of phases, so the log can keep only every k'th event, and
+** only the last n of those in a ring buffer that is written at the end.
+** The layout of the file is described in events.h.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "globals.h"
+#include "writer.h"
+#include "events.h"
+
+
+static int log_on= FALSE;
+static FILE *fp_events;
+static writer_t *w_events;
+static event_hdr_t hdr;
+static event_rec_t *ring;		/* keep_last events, if keep_last > 0 */
+
+/*
+** The interrupt that cut a phase short is counted later, by rMPI().
+** Until then the phase waits here.
+*/
+static event_rec_t pending;
+static int pending_keep;
+static int have_pending= FALSE;
+
+
+/* Local functions */
+static void add_event(event_rec_t *rec, int keep);
+static int sample(void);
+
+
+
+void
+events_open(char *fname, uint64_t keep_last, uint64_t sample_every)
+{
+
+    fp_events= fopen(fname, "w");
+    if (fp_events == NULL)   {
+	fprintf(stderr, "Could not open output file \"%s\": %s\n", fname, strerror(errno));
+	exit(2);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, EVENT_MAGIC, sizeof(hdr.magic));
+    hdr.version= EVENT_VERSION;
+    hdr.byte_order= EVENT_BYTE_ORDER;
+    hdr.sample_every= (sample_every > 0) ? sample_every : 1;
+    hdr.keep_last= keep_last;
+
+    /* The header gets rewritten at the end, once we know the counts */
+    if (fwrite(&hdr, sizeof(hdr), 1, fp_events) != 1)   {
+	fprintf(stderr, "Write to \"%s\" failed: %s\n", fname, strerror(errno));
+	exit(2);
+    }
+
+    if (keep_last > 0)   {
+	ring= (event_rec_t *)malloc(keep_last * sizeof(event_rec_t));
+	if (ring == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	w_events= NULL;
+    } else   {
+	ring= NULL;
+	w_events= writer_open(fp_events, TRUE, TRUE);
+    }
+
+    log_on= TRUE;
+
+}  /* end of events_open() */
+
+
+
+void
+events_close(void)
+{
+
+uint64_t first;
+uint64_t n;
+
+
+    if (!log_on)   {
+	return;
+    }
+
+    if (have_pending)   {
+	add_event(&pending, pending_keep);
+	have_pending= FALSE;
+    }
+
+    if (ring)   {
+	/* Oldest first */
+	n= hdr.num_events;
+	if (n > hdr.keep_last)   {
+	    first= n % hdr.keep_last;
+	    n= hdr.keep_last;
+	} else   {
+	    first= 0;
+	}
+	if ((fwrite(ring + first, sizeof(event_rec_t), n - first, fp_events) != n - first) ||
+		(fwrite(ring, sizeof(event_rec_t), first, fp_events) != first))   {
+	    fprintf(stderr, "Write to event log failed: %s\n", strerror(errno));
+	    exit(2);
+	}
+	hdr.num_events= n;
+	free(ring);
+    } else   {
+	writer_close(w_events);
+    }
+
+    rewind(fp_events);
+    if ((fwrite(&hdr, sizeof(hdr), 1, fp_events) != 1) || (fclose(fp_events) != 0))   {
+	fprintf(stderr, "Write to event log failed: %s\n", strerror(errno));
+	exit(2);
+    }
+    log_on= FALSE;
+
+}  /* end of events_close() */
+
+
+
+/*
+** A phase of this type ran from start to end, and either finished or
+** was interrupted
+*/
+void
+event_phase(int type, double start, double end, int outcome)
+{
+
+event_rec_t rec;
+int keep;
+
+
+    if (!log_on)   {
+	return;
+    }
+
+    if (have_pending)   {
+	add_event(&pending, pending_keep);
+	have_pending= FALSE;
+    }
+
+    keep= sample();
+    rec.start= start;
+    rec.end= end;
+    rec.type= type;
+    rec.outcome= outcome;
+    rec.faults= 0;
+    rec.unused= 0;
+
+    if (outcome == EVENT_INTERRUPTED)   {
+	pending= rec;
+	pending_keep= keep;
+	have_pending= TRUE;
+    } else   {
+	add_event(&rec, keep);
+    }
+
+}  /* end of event_phase() */
+
+
+
+/*
+** The application was interrupted at time t by this many faults
+*/
+void
+event_interrupt(double t, int faults)
+{
+
+event_rec_t rec;
+
+
+    if (!log_on)   {
+	return;
+    }
+
+    if (have_pending)   {
+	pending.faults= faults;
+	add_event(&pending, pending_keep);
+	have_pending= FALSE;
+    }
+
+    rec.start= t;
+    rec.end= t;
+    rec.type= EVENT_INTERRUPT;
+    rec.outcome= EVENT_DONE;
+    rec.faults= faults;
+    rec.unused= 0;
+    add_event(&rec, sample());
+
+}  /* end of event_interrupt() */
+
+
+
+static void
+add_event(event_rec_t *rec, int keep)
+{
+
+    if (!keep)   {
+	return;
+    }
+
+    if (ring)   {
+	ring[hdr.num_events % hdr.keep_last]= *rec;
+    } else   {
+	writer_data(w_events, rec, sizeof(event_rec_t));
+    }
+    hdr.num_events++;
+
+}  /* end of add_event() */
+
+
+
+/*
+** Count an event, and return TRUE if it is one we keep
+*/
+static int
+sample(void)
+{
+
+int keep;
+
+
+    keep= (hdr.total_events % hdr.sample_every) == 0;
+    hdr.total_events++;
+
+    return keep;
+
+}  /* end of sample() */
@@ -0,0 +1,71 @@
+/*
+** $Id$
+**
+** Binary log of the phases the application went through: restarts,
+** rework, work segments, checkpoints, RAS delays, and interrupts.
+** ev2chrome converts it to the Chrome trace format.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+#include <stdint.h>
+
+/*
+** File layout:
+**     event_hdr_t		header
+**     event_rec_t[]		num_events records, in the order they happened
+** All values are stored in the byte order of the machine that wrote the
+** file. byte_order lets the reader detect a mismatch.
+*/
+#define EVENT_MAGIC		"APPMEVT1"
+#define EVENT_VERSION		(1)
+#define EVENT_BYTE_ORDER	(0x01020304)
+
+#define EVENT_RESTART		(1)
+#define EVENT_REWORK		(2)
+#define EVENT_WORK		(3)
+#define EVENT_CHECKPOINT	(4)
+#define EVENT_RAS_DELAY		(5)
+#define EVENT_INTERRUPT		(6)	/* start == end */
+
+#define EVENT_DONE		(0)
+#define EVENT_INTERRUPTED	(1)
+
+typedef struct event_hdr_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t num_events;	/* In this file */
+    uint64_t total_events;	/* Events that happened */
+    uint64_t sample_every;	/* Only every sample_every'th event was kept */
+    uint64_t keep_last;		/* Only the last keep_last of those; 0 for all */
+} event_hdr_t;
+
+/*
+** Times are in minutes. faults is the number of faults that caused the
+** interrupt, for an interrupt and for the phase it cut short.
+*/
+typedef struct event_rec_t   {
+    double start;
+    double end;
+    int32_t type;
+    int32_t outcome;
+    int32_t faults;
+    int32_t unused;
+} event_rec_t;
+
+
+void events_open(char *fname, uint64_t keep_last, uint64_t sample_every);
+void events_close(void);
+void event_phase(int type, double start, double end, int outcome);
+void event_interrupt(double t, int faults);
+
+#endif /* _EVENTS_H_ */
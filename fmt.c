@@ -0,0 +1,338 @@
+/*
+** $Id$
+**
+** Fast number formatting. printf() handles every possible format,
+** which makes it slow for the millions of "%15.3f" records a large
+** simulation writes. The functions here only know fixed point and
+** integer conversions, and produce the same bytes printf() does.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "globals.h"
+#include "fmt.h"
+
+#define FMT_MAX_PREC	(9)
+#define FMT_MAX_SCALED	(1.0e15)	/* Well below 2^53, so the scaled value is exact enough */
+
+
+static const double pow10_tab[FMT_MAX_PREC + 1]=   {
+    1.0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7, 1.0e8, 1.0e9
+};
+
+static const char digit_pairs[]=
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+
+/* Local functions */
+static char *put_digits(char *end, uint64_t u, int min_digits);
+static int pad(char *buf, char *digits, int len, int width);
+static int fit(int len);
+
+
+
+/*
+** Same as sprintf(buf, "%*.*f", width, prec, v). buf must hold at
+** least FMT_BUF_SIZE bytes. Returns the length of the string, which is
+** truncated to FMT_BUF_SIZE - 1, if it does not fit.
+*/
+int
+fmt_fixed(char *buf, double v, int width, int prec)
+{
+
+char tmp[64];
+char *pos;
+double scaled;
+double r;
+double frac;
+uint64_t u;
+uint64_t p;
+
+
+    if ((prec < 0) || (prec > FMT_MAX_PREC) || (width >= FMT_BUF_SIZE - 32))   {
+	return fit(snprintf(buf, FMT_BUF_SIZE, "%*.*f", width, prec, v));
+    }
+
+    scaled= fabs(v) * pow10_tab[prec];
+    if (!(scaled < FMT_MAX_SCALED))   {
+	/* Too large, infinite, or NaN */
+	return fit(snprintf(buf, FMT_BUF_SIZE, "%*.*f", width, prec, v));
+    }
+
+    /*
+    ** printf() rounds the exact binary value to nearest, ties to even.
+    ** fma() gives us what the multiplication above rounded away. Only
+    ** when the value is very close to halfway between two results do we
+    ** need printf() to decide.
+    */
+    r= nearbyint(scaled);
+    frac= fma(fabs(v), pow10_tab[prec], -r);
+    if (fabs(fabs(frac) - 0.5) < 1.0e-6)   {
+	return fit(snprintf(buf, FMT_BUF_SIZE, "%*.*f", width, prec, v));
+    }
+    if (frac > 0.5)   {
+	r= r + 1.0;
+    } else if (frac < -0.5)   {
+	r= r - 1.0;
+    }
+
+    u= (uint64_t)r;
+    p= (uint64_t)pow10_tab[prec];
+    pos= tmp + sizeof(tmp);
+    if (prec > 0)   {
+	pos= put_digits(pos, u % p, prec);
+	*--pos= '.';
+    }
+    pos= put_digits(pos, u / p, 1);
+    if (signbit(v))   {
+	/* printf() keeps the sign of values that round to 0 */
+	*--pos= '-';
+    }
+
+    return pad(buf, pos, tmp + sizeof(tmp) - pos, width);
+
+}  /* end of fmt_fixed() */
+
+
+
+/*
+** Same as sprintf(buf, "%*d", width, v). buf must hold at least
+** FMT_BUF_SIZE bytes. Returns the length of the string, which is
+** truncated to FMT_BUF_SIZE - 1, if it does not fit.
+*/
+int
+fmt_int(char *buf, int v, int width)
+{
+
+char tmp[32];
+char *pos;
+uint64_t u;
+
+
+    if (width >= FMT_BUF_SIZE - 32)   {
+	return fit(snprintf(buf, FMT_BUF_SIZE, "%*d", width, v));
+    }
+
+    u= (v < 0) ? -(int64_t)v : v;
+    pos= put_digits(tmp + sizeof(tmp), u, 1);
+    if (v < 0)   {
+	*--pos= '-';
+    }
+
+    return pad(buf, pos, tmp + sizeof(tmp) - pos, width);
+
+}  /* end of fmt_int() */
+
+
+
+/*
+** A fprintf() replacement for the verbose traces. It handles %d, %f, %s,
+** and %% with optional width and precision. Anything else goes to
+** vfprintf().
+*/
+void
+fmt_print(FILE *fp, const char *format, ...)
+{
+
+va_list ap;
+char line[1024];
+char num[FMT_BUF_SIZE];
+const char *f;
+const char *s;
+int len;
+int n;
+int width;
+int prec;
+int wide;
+
+
+    /* Make sure we know all the conversions before we use any arguments */
+    for (f= format; *f; f++)   {
+	if (*f != '%')   {
+	    continue;
+	}
+	f++;
+	while ((*f >= '0') && (*f <= '9'))   {
+	    f++;
+	}
+	if (*f == '.')   {
+	    f++;
+	    while ((*f >= '0') && (*f <= '9'))   {
+		f++;
+	    }
+	}
+	if ((*f != 'd') && (*f != 'f') && (*f != 's') && (*f != '%'))   {
+	    va_start(ap, format);
+	    vfprintf(fp, format, ap);
+	    va_end(ap);
+	    return;
+	}
+    }
+
+    va_start(ap, format);
+    len= 0;
+    for (f= format; *f; f++)   {
+	if (len > (int)sizeof(line) - FMT_BUF_SIZE)   {
+	    fwrite(line, 1, len, fp);
+	    len= 0;
+	}
+
+	if (*f != '%')   {
+	    line[len++]= *f;
+	    continue;
+	}
+
+	f++;
+	width= 0;
+	while ((*f >= '0') && (*f <= '9'))   {
+	    width= width * 10 + (*f - '0');
+	    f++;
+	}
+	prec= -1;
+	if (*f == '.')   {
+	    f++;
+	    prec= 0;
+	    while ((*f >= '0') && (*f <= '9'))   {
+		prec= prec * 10 + (*f - '0');
+		f++;
+	    }
+	}
+
+	/* Conversions that may not fit into num go straight to fp */
+	wide= (width >= FMT_BUF_SIZE - 32) || ((*f == 'f') && (prec > FMT_MAX_PREC));
+	if (wide && ((*f == 'd') || (*f == 'f')))   {
+	    fwrite(line, 1, len, fp);
+	    len= 0;
+	}
+
+	switch (*f)   {
+	    case 'd':
+		if (wide)   {
+		    fprintf(fp, "%*d", width, va_arg(ap, int));
+		    break;
+		}
+		n= fmt_int(num, va_arg(ap, int), width);
+		memcpy(line + len, num, n);
+		len= len + n;
+		break;
+	    case 'f':
+		if (wide)   {
+		    fprintf(fp, "%*.*f", width, (prec < 0) ? 6 : prec, va_arg(ap, double));
+		    break;
+		}
+		n= fmt_fixed(num, va_arg(ap, double), width, (prec < 0) ? 6 : prec);
+		memcpy(line + len, num, n);
+		len= len + n;
+		break;
+	    case 's':
+		s= va_arg(ap, const char *);
+		fwrite(line, 1, len, fp);
+		len= 0;
+		fprintf(fp, "%*.*s", width, (prec < 0) ? (int)strlen(s) : prec, s);
+		break;
+	    default:
+		line[len++]= '%';
+		break;
+	}
+    }
+    va_end(ap);
+
+    fwrite(line, 1, len, fp);
+
+}  /* end of fmt_print() */
+
+
+
+/*
+** The length of what snprintf() put into a buffer of FMT_BUF_SIZE bytes
+*/
+static int
+fit(int len)
+{
+
+    if (len < 0)   {
+	return 0;
+    }
+
+    return (len < FMT_BUF_SIZE) ? len : FMT_BUF_SIZE - 1;
+
+}  /* end of fit() */
+
+
+
+/*
+** Write the decimal digits of u, at least min_digits of them, so that
+** the last one is just before end. Returns the first digit.
+*/
+static char *
+put_digits(char *end, uint64_t u, int min_digits)
+{
+
+char *pos;
+int i;
+
+
+    pos= end;
+    while (u >= 100)   {
+	i= (u % 100) * 2;
+	u= u / 100;
+	*--pos= digit_pairs[i + 1];
+	*--pos= digit_pairs[i];
+    }
+    if (u >= 10)   {
+	i= u * 2;
+	*--pos= digit_pairs[i + 1];
+	*--pos= digit_pairs[i];
+    } else   {
+	*--pos= '0' + u;
+    }
+
+    while (end - pos < min_digits)   {
+	*--pos= '0';
+    }
+
+    return pos;
+
+}  /* end of put_digits() */
+
+
+
+/*
+** Right justify len characters in a field of width characters
+*/
+static int
+pad(char *buf, char *digits, int len, int width)
+{
+
+int spaces;
+
+
+    spaces= (width > len) ? width - len : 0;
+    memset(buf, ' ', spaces);
+    memcpy(buf + spaces, digits, len);
+    buf[spaces + len]= '\0';
+
+    return spaces + len;
+
+}  /* end of pad() */
@@ -0,0 +1,32 @@
+/*
+** $Id$
+**
+** Fast number formatting for the output files and verbose traces.
+** The output is the same as that of printf().
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _FMT_H_
+#define _FMT_H_
+
+#include <stdio.h>
+
+/*
+** Large enough for any number fmt_fixed() and fmt_int() produce with a
+** width below FMT_BUF_SIZE - 32 and at most 9 decimals. Longer ones are
+** truncated; fmt_print() prints those with fprintf() instead.
+*/
+#define FMT_BUF_SIZE	(512)
+
+int fmt_fixed(char *buf, double v, int width, int prec);
+int fmt_int(char *buf, int v, int width);
+void fmt_print(FILE *fp, const char *format, ...)
+	__attribute__ ((format (printf, 2, 3)));
+
+#endif /* _FMT_H_ */
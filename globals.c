@@ -12,40 +12,49 @@
 **
 */
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
 
 #include "globals.h"
+#include "hist.h"
 
 
 
 /* Some global time keepers */
-double total_restart_time;
-double total_rework_time;
-double total_work_time;
-double total_checkpoint_time;
-double total_ras_delay;
+SIM_LOCAL double total_restart_time;
+SIM_LOCAL double total_rework_time;
+SIM_LOCAL double total_work_time;
+SIM_LOCAL double total_checkpoint_time;
+SIM_LOCAL double total_ras_delay;
 
-double wasted_restart_time;
-double wasted_rework_time;
-double wasted_work_time;
-double wasted_checkpoint_time;
+SIM_LOCAL double wasted_restart_time;
+SIM_LOCAL double wasted_rework_time;
+SIM_LOCAL double wasted_work_time;
+SIM_LOCAL double wasted_checkpoint_time;
 
 /* Global counters */
-int checkpoint_cnt, failed_checkpoint_cnt;
-int restart_cnt, failed_restart_cnt;
-int rework_cnt, failed_rework_cnt;
-int work_cnt, failed_work_cnt;
-int interrupt_cnt;
-int fault_cnt;
-int node_failure_cnt;
-int total_repaired;
-int soft_reboot_success_cnt;
-int soft_reboot_failure_cnt;
+SIM_LOCAL int checkpoint_cnt, failed_checkpoint_cnt;
+SIM_LOCAL int restart_cnt, failed_restart_cnt;
+SIM_LOCAL int rework_cnt, failed_rework_cnt;
+SIM_LOCAL int work_cnt, failed_work_cnt;
+SIM_LOCAL int interrupt_cnt;
+SIM_LOCAL int fault_cnt;
+SIM_LOCAL int node_failure_cnt;
+SIM_LOCAL int total_repaired;
+SIM_LOCAL int soft_reboot_success_cnt;
+SIM_LOCAL int soft_reboot_failure_cnt;
 
-int rnd_gen_cnt;
-int rnd_prob_cnt;
-int calls_rMPI;
-int read_input_cnt;
-int read_input_accepted;
+SIM_LOCAL int rnd_gen_cnt;
+SIM_LOCAL int rnd_prob_cnt;
+SIM_LOCAL int calls_rMPI;
+SIM_LOCAL int read_input_cnt;
+SIM_LOCAL int read_input_accepted;
+
+SIM_LOCAL int stopped_early;
+
+SIM_LOCAL jmp_buf *sim_jmp= NULL;
+SIM_LOCAL char sim_errmsg[256];
 
 
 
@@ -87,4 +96,138 @@ init_globals(void)
     read_input_cnt= 0;
     read_input_accepted= 0;
 
+    stopped_early= FALSE;
+
+    hist_reset();
+
 }  /* end of init_globals() */
+
+
+
+void
+save_results(result_t *r, double elapsed_time)
+{
+    r->elapsed_time= elapsed_time;
+    r->total_restart_time= total_restart_time;
+    r->total_rework_time= total_rework_time;
+    r->total_work_time= total_work_time;
+    r->total_checkpoint_time= total_checkpoint_time;
+    r->total_ras_delay= total_ras_delay;
+    r->wasted_restart_time= wasted_restart_time;
+    r->wasted_rework_time= wasted_rework_time;
+    r->wasted_work_time= wasted_work_time;
+    r->wasted_checkpoint_time= wasted_checkpoint_time;
+
+    r->checkpoint_cnt= checkpoint_cnt;
+    r->failed_checkpoint_cnt= failed_checkpoint_cnt;
+    r->restart_cnt= restart_cnt;
+    r->failed_restart_cnt= failed_restart_cnt;
+    r->rework_cnt= rework_cnt;
+    r->failed_rework_cnt= failed_rework_cnt;
+    r->work_cnt= work_cnt;
+    r->failed_work_cnt= failed_work_cnt;
+    r->interrupt_cnt= interrupt_cnt;
+    r->fault_cnt= fault_cnt;
+    r->node_failure_cnt= node_failure_cnt;
+    r->total_repaired= total_repaired;
+    r->soft_reboot_success_cnt= soft_reboot_success_cnt;
+    r->soft_reboot_failure_cnt= soft_reboot_failure_cnt;
+    r->rnd_gen_cnt= rnd_gen_cnt;
+    r->rnd_prob_cnt= rnd_prob_cnt;
+    r->calls_rMPI= calls_rMPI;
+    r->read_input_cnt= read_input_cnt;
+    r->read_input_accepted= read_input_accepted;
+    r->stopped_early= stopped_early;
+
+}  /* end of save_results() */
+
+
+
+/*
+** The reverse of save_results(), for a run that continues from a snapshot
+*/
+void
+restore_results(result_t *r)
+{
+    total_restart_time= r->total_restart_time;
+    total_rework_time= r->total_rework_time;
+    total_work_time= r->total_work_time;
+    total_checkpoint_time= r->total_checkpoint_time;
+    total_ras_delay= r->total_ras_delay;
+    wasted_restart_time= r->wasted_restart_time;
+    wasted_rework_time= r->wasted_rework_time;
+    wasted_work_time= r->wasted_work_time;
+    wasted_checkpoint_time= r->wasted_checkpoint_time;
+
+    checkpoint_cnt= r->checkpoint_cnt;
+    failed_checkpoint_cnt= r->failed_checkpoint_cnt;
+    restart_cnt= r->restart_cnt;
+    failed_restart_cnt= r->failed_restart_cnt;
+    rework_cnt= r->rework_cnt;
+    failed_rework_cnt= r->failed_rework_cnt;
+    work_cnt= r->work_cnt;
+    failed_work_cnt= r->failed_work_cnt;
+    interrupt_cnt= r->interrupt_cnt;
+    fault_cnt= r->fault_cnt;
+    node_failure_cnt= r->node_failure_cnt;
+    total_repaired= r->total_repaired;
+    soft_reboot_success_cnt= r->soft_reboot_success_cnt;
+    soft_reboot_failure_cnt= r->soft_reboot_failure_cnt;
+    rnd_gen_cnt= r->rnd_gen_cnt;
+    rnd_prob_cnt= r->rnd_prob_cnt;
+    calls_rMPI= r->calls_rMPI;
+    read_input_cnt= r->read_input_cnt;
+    read_input_accepted= r->read_input_accepted;
+
+}  /* end of restore_results() */
+
+
+
+/*
+** Print the message and exit, or end the libapp_model run. The message
+** is kept in sim_errmsg, without the newline.
+*/
+void
+sim_error(int code, const char *fmt, ...)
+{
+
+va_list ap;
+size_t len;
+
+
+    va_start(ap, fmt);
+    vsnprintf(sim_errmsg, sizeof(sim_errmsg), fmt, ap);
+    va_end(ap);
+
+    len= strlen(sim_errmsg);
+    if ((len > 0) && (sim_errmsg[len - 1] == '\n'))   {
+	sim_errmsg[len - 1]= '\0';
+    }
+
+    if (sim_jmp)   {
+	longjmp(*sim_jmp, code);
+    }
+
+    fprintf(stderr, "%s\n", sim_errmsg);
+    exit(code);
+
+}  /* end of sim_error() */
+
+
+
+void
+sim_warning(const char *fmt, ...)
+{
+
+va_list ap;
+
+
+    if (sim_jmp)   {
+	return;
+    }
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+
+}  /* end of sim_warning() */
@@ -14,44 +14,103 @@
 #ifndef _GLOBALS_H_
 #define _GLOBALS_H_
 
+#include <setjmp.h>
+
 #define FALSE			(0)
 #define TRUE			(1)
 
+/*
+** The state of a simulation is per thread, so libapp_model can run
+** simulations on several threads at the same time
+*/
+#define SIM_LOCAL		_Thread_local
+
 void init_globals(void);
 
+/*
+** Errors end the program with an exit code. In a libapp_model run,
+** sim_jmp is set, and the run ends there instead. Warnings are not
+** printed then.
+*/
+extern SIM_LOCAL jmp_buf *sim_jmp;
+extern SIM_LOCAL char sim_errmsg[256];
+void sim_error(int code, const char *fmt, ...) __attribute__((noreturn, format(printf, 2, 3)));
+void sim_warning(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
 /* Turn assertions on (NDEBUG) or off (!NDEBUG) */
 #define NDEBUG
 #undef NDEBUG
 
 /* Some global time keepers */
-extern double total_restart_time;
-extern double total_rework_time;
-extern double total_work_time;
-extern double total_checkpoint_time;
-extern double total_ras_delay;
+extern SIM_LOCAL double total_restart_time;
+extern SIM_LOCAL double total_rework_time;
+extern SIM_LOCAL double total_work_time;
+extern SIM_LOCAL double total_checkpoint_time;
+extern SIM_LOCAL double total_ras_delay;
 
-extern double wasted_restart_time;
-extern double wasted_rework_time;
-extern double wasted_work_time;
-extern double wasted_checkpoint_time;
+extern SIM_LOCAL double wasted_restart_time;
+extern SIM_LOCAL double wasted_rework_time;
+extern SIM_LOCAL double wasted_work_time;
+extern SIM_LOCAL double wasted_checkpoint_time;
 
 /* Global counters */
-extern int checkpoint_cnt, failed_checkpoint_cnt;
-extern int restart_cnt, failed_restart_cnt;
-extern int rework_cnt, failed_rework_cnt;
-extern int work_cnt, failed_work_cnt;
-extern int interrupt_cnt;
-extern int fault_cnt;
-extern int node_failure_cnt;
-extern int total_repaired;
-extern int soft_reboot_success_cnt;
-extern int soft_reboot_failure_cnt;
-extern int rnd_gen_cnt;
-extern int rnd_prob_cnt;
-
-extern int calls_rMPI;
-extern int read_input_cnt;
-extern int read_input_accepted;
+extern SIM_LOCAL int checkpoint_cnt, failed_checkpoint_cnt;
+extern SIM_LOCAL int restart_cnt, failed_restart_cnt;
+extern SIM_LOCAL int rework_cnt, failed_rework_cnt;
+extern SIM_LOCAL int work_cnt, failed_work_cnt;
+extern SIM_LOCAL int interrupt_cnt;
+extern SIM_LOCAL int fault_cnt;
+extern SIM_LOCAL int node_failure_cnt;
+extern SIM_LOCAL int total_repaired;
+extern SIM_LOCAL int soft_reboot_success_cnt;
+extern SIM_LOCAL int soft_reboot_failure_cnt;
+extern SIM_LOCAL int rnd_gen_cnt;
+extern SIM_LOCAL int rnd_prob_cnt;
+
+extern SIM_LOCAL int calls_rMPI;
+extern SIM_LOCAL int read_input_cnt;
+extern SIM_LOCAL int read_input_accepted;
+
+/* TRUE, if app_model() ran out of --time_budget before the work was done */
+extern SIM_LOCAL int stopped_early;
+
+
+/*
+** A copy of the time keepers and counters above, so the results of a run
+** can be passed around; e.g., from a child process to its parent.
+*/
+typedef struct result_t   {
+    double elapsed_time;
+    double total_restart_time;
+    double total_rework_time;
+    double total_work_time;
+    double total_checkpoint_time;
+    double total_ras_delay;
+    double wasted_restart_time;
+    double wasted_rework_time;
+    double wasted_work_time;
+    double wasted_checkpoint_time;
+
+    int checkpoint_cnt, failed_checkpoint_cnt;
+    int restart_cnt, failed_restart_cnt;
+    int rework_cnt, failed_rework_cnt;
+    int work_cnt, failed_work_cnt;
+    int interrupt_cnt;
+    int fault_cnt;
+    int node_failure_cnt;
+    int total_repaired;
+    int soft_reboot_success_cnt;
+    int soft_reboot_failure_cnt;
+    int rnd_gen_cnt;
+    int rnd_prob_cnt;
+    int calls_rMPI;
+    int read_input_cnt;
+    int read_input_accepted;
+    int stopped_early;
+} result_t;
+
+void save_results(result_t *r, double elapsed_time);
+void restore_results(result_t *r);
 
 
 #endif /* _GLOBALS_H_ */
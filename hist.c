@@ -0,0 +1,583 @@
+/*
+** $Id$
+**
+** Log-bucketed histograms, similar to HdrHistogram. They summarize
+** millions of values in fixed memory and answer quantile queries with
+** a small, bounded relative error. Used to report the distribution of
+** fault and interrupt inter-arrival times, faults per interrupt, and
+** lost work per interrupt, without writing every event to a file.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "globals.h"
+#include "hist.h"
+#include "record.h"
+#include "snapshot.h"
+
+
+/*
+** A histogram takes about 115 kB. They are allocated when the first value
+** is added, so threads that do not simulate do not pay for them, and
+** kept for the next run on the same thread. NULL means empty.
+*/
+static SIM_LOCAL hist_t *fault_gap= NULL;	/* Time between faults */
+static SIM_LOCAL hist_t *interrupt_gap= NULL;	/* Time between interrupts */
+static SIM_LOCAL hist_t *faults_per_int= NULL;
+static SIM_LOCAL hist_t *lost_work= NULL;	/* Work that had to be redone after each interrupt */
+
+/* < 0 before the first fault or interrupt; there is no gap before it */
+static SIM_LOCAL double last_fault;
+static SIM_LOCAL double last_interrupt;
+
+/* Faults since the last interrupt. They are not always recorded in time order. */
+static SIM_LOCAL double *pending= NULL;
+static SIM_LOCAL int pending_cnt= 0;
+static SIM_LOCAL int pending_size= 0;
+
+
+/* Local functions */
+static void add(hist_t **h, double v);
+static int bucket_index(double v);
+static double bucket_value(int index);
+static void flush_faults(void);
+static int compare_doubles(const void *pa, const void *pb);
+static void report_line(char *name, hist_t *h);
+static void record_hist(const char *name, hist_t *h);
+static void save_hist(FILE *fp, hist_t *h);
+static void load_hist(FILE *fp, hist_t **h);
+
+
+
+void
+hist_init(hist_t *h)
+{
+
+    memset(h->bucket, 0, sizeof(h->bucket));
+    h->count= 0;
+    h->min= 0.0;
+    h->max= 0.0;
+    h->sum= 0.0;
+
+}  /* end of hist_init() */
+
+
+
+void
+hist_add(hist_t *h, double v)
+{
+
+    if (v < 0.0)   {
+	v= 0.0;
+    }
+
+    h->bucket[bucket_index(v)]++;
+    if ((h->count == 0) || (v < h->min))   {
+	h->min= v;
+    }
+    if ((h->count == 0) || (v > h->max))   {
+	h->max= v;
+    }
+    h->count++;
+    h->sum= h->sum + v;
+
+}  /* end of hist_add() */
+
+
+
+/*
+** Smallest value that at least q (0.0 - 1.0) of all values are less
+** than or equal to, within the resolution of the buckets
+*/
+double
+hist_quantile(hist_t *h, double q)
+{
+
+uint64_t rank;
+uint64_t seen;
+double v;
+int i;
+
+
+    if (h->count == 0)   {
+	return 0.0;
+    }
+
+    rank= (uint64_t)ceil(q * h->count);
+    if (rank < 1)   {
+	rank= 1;
+    }
+
+    seen= 0;
+    for (i= 0; i < HIST_BUCKETS - 1; i++)   {
+	seen= seen + h->bucket[i];
+	if (seen >= rank)   {
+	    break;
+	}
+    }
+
+    /* The exact extremes are known */
+    v= bucket_value(i);
+    if (v < h->min)   {
+	v= h->min;
+    }
+    if (v > h->max)   {
+	v= h->max;
+    }
+
+    return v;
+
+}  /* end of hist_quantile() */
+
+
+
+/*
+** Start over for a new run. Called from init_globals().
+*/
+void
+hist_reset(void)
+{
+
+    if (fault_gap)		hist_init(fault_gap);
+    if (interrupt_gap)		hist_init(interrupt_gap);
+    if (faults_per_int)		hist_init(faults_per_int);
+    if (lost_work)		hist_init(lost_work);
+    last_fault= -1.0;
+    last_interrupt= -1.0;
+    pending_cnt= 0;
+
+}  /* end of hist_reset() */
+
+
+
+/*
+** Release the memory of the histograms of this thread. Called from
+** am_thread_end().
+*/
+void
+hist_free(void)
+{
+
+    free(fault_gap);
+    free(interrupt_gap);
+    free(faults_per_int);
+    free(lost_work);
+    fault_gap= NULL;
+    interrupt_gap= NULL;
+    faults_per_int= NULL;
+    lost_work= NULL;
+    free(pending);
+    pending= NULL;
+    pending_cnt= 0;
+    pending_size= 0;
+
+}  /* end of hist_free() */
+
+
+
+/*
+** A node failed at time t. The faults that lead to an interrupt are
+** not recorded in time order, so we sort them before measuring the
+** gaps between them.
+*/
+void
+hist_fault(double t)
+{
+
+    if (pending_cnt >= pending_size)   {
+	pending_size= (pending_size > 0) ? 2 * pending_size : 1024;
+	pending= (double *)realloc(pending, pending_size * sizeof(double));
+	if (pending == NULL)   {
+	    sim_error(10, "Out of memory!\n");
+	}
+    }
+    pending[pending_cnt++]= t;
+
+}  /* end of hist_fault() */
+
+
+
+/*
+** The application was interrupted at time t, by this many faults
+*/
+void
+hist_interrupt(double t, int faults)
+{
+
+    flush_faults();
+    if (last_interrupt >= 0.0)   {
+	add(&interrupt_gap, t - last_interrupt);
+    }
+    add(&faults_per_int, faults);
+    last_interrupt= t;
+
+}  /* end of hist_interrupt() */
+
+
+
+/*
+** An interrupt destroyed this much work (or rework) that had not been
+** saved in a checkpoint yet
+*/
+void
+hist_lost_work(double lost)
+{
+    add(&lost_work, lost);
+}  /* end of hist_lost_work() */
+
+
+
+void
+hist_report(void)
+{
+
+    flush_faults();
+    printf("\n");
+    printf("DISTRIBUTIONS                       Count       Mean        p50        p90        p99      p99.9        Max\n");
+    report_line("Fault interarrival (min)", fault_gap);
+    report_line("Interrupt interarrival (min)", interrupt_gap);
+    report_line("Faults per interrupt", faults_per_int);
+    report_line("Lost work per int. (min)", lost_work);
+
+}  /* end of hist_report() */
+
+
+
+/*
+** The DISTRIBUTIONS block as a record section
+*/
+void
+hist_record(void)
+{
+
+    flush_faults();
+    record_section("distributions");
+    record_hist("fault_gap_min", fault_gap);
+    record_hist("interrupt_gap_min", interrupt_gap);
+    record_hist("faults_per_interrupt", faults_per_int);
+    record_hist("lost_work_min", lost_work);
+
+}  /* end of hist_record() */
+
+
+
+/*
+** Save the distributions of this run in a snapshot
+*/
+void
+hist_save(FILE *fp)
+{
+
+    save_hist(fp, fault_gap);
+    save_hist(fp, interrupt_gap);
+    save_hist(fp, faults_per_int);
+    save_hist(fp, lost_work);
+    snap_put(fp, &last_fault, sizeof(last_fault));
+    snap_put(fp, &last_interrupt, sizeof(last_interrupt));
+    snap_put(fp, &pending_cnt, sizeof(pending_cnt));
+    snap_put(fp, pending, pending_cnt * sizeof(double));
+
+}  /* end of hist_save() */
+
+
+
+void
+hist_load(FILE *fp)
+{
+
+int cnt;
+int i;
+double t;
+
+
+    load_hist(fp, &fault_gap);
+    load_hist(fp, &interrupt_gap);
+    load_hist(fp, &faults_per_int);
+    load_hist(fp, &lost_work);
+    snap_get(fp, &last_fault, sizeof(last_fault));
+    snap_get(fp, &last_interrupt, sizeof(last_interrupt));
+    snap_get(fp, &cnt, sizeof(cnt));
+    pending_cnt= 0;
+    for (i= 0; i < cnt; i++)   {
+	snap_get(fp, &t, sizeof(t));
+	hist_fault(t);
+    }
+
+}  /* end of hist_load() */
+
+
+
+/*
+** Add the gaps between the faults since the last interrupt. Gaps to a
+** fault earlier than the last one of the previous interrupt count as 0.
+** The first fault of the run only starts the first gap.
+*/
+static void
+flush_faults(void)
+{
+
+int i;
+
+
+    qsort(pending, pending_cnt, sizeof(double), compare_doubles);
+    for (i= 0; i < pending_cnt; i++)   {
+	if (last_fault < 0.0)   {
+	    last_fault= pending[i];
+	} else if (pending[i] > last_fault)   {
+	    add(&fault_gap, pending[i] - last_fault);
+	    last_fault= pending[i];
+	} else   {
+	    add(&fault_gap, 0.0);
+	}
+    }
+    pending_cnt= 0;
+
+}  /* end of flush_faults() */
+
+
+
+/*
+** Add a value to one of the histograms of this thread, and allocate it
+** first, if it does not exist yet
+*/
+static void
+add(hist_t **h, double v)
+{
+
+    if (*h == NULL)   {
+	*h= (hist_t *)malloc(sizeof(hist_t));
+	if (*h == NULL)   {
+	    sim_error(10, "Out of memory!\n");
+	}
+	hist_init(*h);
+    }
+    hist_add(*h, v);
+
+}  /* end of add() */
+
+
+
+static int
+compare_doubles(const void *pa, const void *pb)
+{
+
+const double *a= pa;
+const double *b= pb;
+
+
+    return (*a > *b) - (*a < *b);
+
+}  /* end of compare_doubles() */
+
+
+
+/*
+** Bucket 0 holds everything below HIST_MIN_VALUE. After that, octave
+** e (counting from 0) starts at HIST_MIN_VALUE * 2^e.
+*/
+static int
+bucket_index(double v)
+{
+
+double m;
+int e;
+int index;
+
+
+    if (v < HIST_MIN_VALUE)   {
+	return 0;
+    }
+
+    /* v / HIST_MIN_VALUE = m * 2^e, 0.5 <= m < 1 */
+    m= frexp(v / HIST_MIN_VALUE, &e);
+    index= 1 + (e - 1) * HIST_SUB_BUCKETS + (int)((m - 0.5) * 2.0 * HIST_SUB_BUCKETS);
+    if (index >= HIST_BUCKETS)   {
+	index= HIST_BUCKETS - 1;
+    }
+
+    return index;
+
+}  /* end of bucket_index() */
+
+
+
+/*
+** Lower end of a bucket
+*/
+static double
+bucket_value(int index)
+{
+
+int e;
+int sub;
+
+
+    if (index == 0)   {
+	return 0.0;
+    }
+
+    e= (index - 1) / HIST_SUB_BUCKETS;
+    sub= (index - 1) % HIST_SUB_BUCKETS;
+
+    return ldexp(HIST_MIN_VALUE * (1.0 + (double)sub / HIST_SUB_BUCKETS), e);
+
+}  /* end of bucket_value() */
+
+
+
+static void
+report_line(char *name, hist_t *h)
+{
+
+    if ((h == NULL) || (h->count == 0))   {
+	printf("  %-28s %9lu %10s %10s %10s %10s %10s %10s\n", name, 0UL,
+	    "-", "-", "-", "-", "-", "-");
+	return;
+    }
+
+    printf("  %-28s %9lu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", name,
+	(unsigned long)h->count, h->sum / h->count,
+	hist_quantile(h, 0.50), hist_quantile(h, 0.90),
+	hist_quantile(h, 0.99), hist_quantile(h, 0.999), h->max);
+
+}  /* end of report_line() */
+
+
+
+/*
+** Most buckets are empty. Save the others as index and count pairs.
+*/
+static void
+save_hist(FILE *fp, hist_t *h)
+{
+
+uint64_t none= 0;
+double zero= 0.0;
+int32_t used;
+int32_t i;
+
+
+    if (h == NULL)   {
+	/* Same as an empty one */
+	snap_put(fp, &none, sizeof(none));
+	snap_put(fp, &zero, sizeof(zero));
+	snap_put(fp, &zero, sizeof(zero));
+	snap_put(fp, &zero, sizeof(zero));
+	used= 0;
+	snap_put(fp, &used, sizeof(used));
+	return;
+    }
+
+    snap_put(fp, &h->count, sizeof(h->count));
+    snap_put(fp, &h->min, sizeof(h->min));
+    snap_put(fp, &h->max, sizeof(h->max));
+    snap_put(fp, &h->sum, sizeof(h->sum));
+
+    used= 0;
+    for (i= 0; i < HIST_BUCKETS; i++)   {
+	if (h->bucket[i] > 0)   {
+	    used++;
+	}
+    }
+    snap_put(fp, &used, sizeof(used));
+    for (i= 0; i < HIST_BUCKETS; i++)   {
+	if (h->bucket[i] > 0)   {
+	    snap_put(fp, &i, sizeof(i));
+	    snap_put(fp, &h->bucket[i], sizeof(h->bucket[i]));
+	}
+    }
+
+}  /* end of save_hist() */
+
+
+
+static void
+load_hist(FILE *fp, hist_t **hp)
+{
+
+hist_t *h;
+uint64_t count;
+double min, max, sum;
+int32_t used;
+int32_t i;
+
+
+    snap_get(fp, &count, sizeof(count));
+    snap_get(fp, &min, sizeof(min));
+    snap_get(fp, &max, sizeof(max));
+    snap_get(fp, &sum, sizeof(sum));
+    snap_get(fp, &used, sizeof(used));
+
+    if ((count == 0) && (used == 0))   {
+	if (*hp)   {
+	    hist_init(*hp);
+	}
+	return;
+    }
+
+    /* Allocate it, if this thread did not need it yet */
+    if (*hp == NULL)   {
+	*hp= (hist_t *)malloc(sizeof(hist_t));
+	if (*hp == NULL)   {
+	    sim_error(10, "Out of memory!\n");
+	}
+    }
+    h= *hp;
+    hist_init(h);
+    h->count= count;
+    h->min= min;
+    h->max= max;
+    h->sum= sum;
+
+    while (used-- > 0)   {
+	snap_get(fp, &i, sizeof(i));
+	if ((i < 0) || (i >= HIST_BUCKETS))   {
+	    sim_error(8, "ERROR: Snapshot has a histogram bucket out of range\n");
+	}
+	snap_get(fp, &h->bucket[i], sizeof(h->bucket[i]));
+    }
+
+}  /* end of load_hist() */
+
+
+
+static void
+record_hist(const char *name, hist_t *h)
+{
+
+static const char *stat[]= {"count", "mean", "p50", "p90", "p99", "p999", "max"};
+char key[128];
+double v[7];
+int i;
+
+
+    v[0]= h ? h->count : 0;
+    if (h && (h->count > 0))   {
+	v[1]= h->sum / h->count;
+	v[2]= hist_quantile(h, 0.50);
+	v[3]= hist_quantile(h, 0.90);
+	v[4]= hist_quantile(h, 0.99);
+	v[5]= hist_quantile(h, 0.999);
+	v[6]= h->max;
+    } else   {
+	for (i= 1; i < 7; i++)   {
+	    v[i]= NAN;
+	}
+    }
+
+    for (i= 0; i < 7; i++)   {
+	snprintf(key, sizeof(key), "%s_%s", name, stat[i]);
+	record_double(key, v[i]);
+    }
+
+}  /* end of record_hist() */
@@ -0,0 +1,56 @@
+/*
+** $Id$
+**
+** Log-bucketed histograms that summarize the faults and interrupts of
+** a run in fixed memory.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _HIST_H_
+#define _HIST_H_
+
+#include <stdint.h>
+
+/*
+** Each power of two between HIST_MIN_VALUE and HIST_MIN_VALUE *
+** 2^HIST_OCTAVES is split into HIST_SUB_BUCKETS equal buckets. A value
+** is reported as the lower end of its bucket, which is less than 1/256
+** (0.4%) below the actual value. Integers up to 256 are exact. Smaller
+** values share bucket 0, larger ones the last bucket.
+*/
+#define HIST_SUB_BUCKETS	(256)
+#define HIST_OCTAVES		(56)
+#define HIST_BUCKETS		(1 + HIST_OCTAVES * HIST_SUB_BUCKETS)
+#define HIST_MIN_VALUE		(1.0 / (1024.0 * 1024.0))
+
+typedef struct hist_t   {
+    uint64_t bucket[HIST_BUCKETS];
+    uint64_t count;
+    double min;
+    double max;
+    double sum;
+} hist_t;
+
+
+void hist_init(hist_t *h);
+void hist_add(hist_t *h, double v);
+double hist_quantile(hist_t *h, double q);
+
+/* The distributions of one run */
+void hist_reset(void);
+void hist_free(void);
+void hist_fault(double t);
+void hist_interrupt(double t, int faults);
+void hist_lost_work(double lost);
+void hist_report(void);
+void hist_record(void);
+void hist_save(FILE *fp);
+void hist_load(FILE *fp);
+
+#endif /* _HIST_H_ */
@@ -12,30 +12,273 @@
 ** retains certain rights in this software.
 **
 */
+#define _GNU_SOURCE		/* For fopencookie() */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <glob.h>
+#include <zlib.h>
 
 #include "globals.h"
+#include "fmt.h"
+#include "debug.h"
 #include "input.h"
+#include "bintrace.h"
+#include "cache.h"
 
 #define MAX_ERR_STR_LEN	(2 * 1024)
+#define GZ_BUF_SIZE	(1024 * 1024)
+#define GZ_MAGIC	(0x1f)	/* First byte of every gzip file */
+#define RING_SIZE	(8 * 1024)	/* Prefetched faults. Must be a power of 2 */
+#define RING_SPINS	(100)		/* Yields before read_next() sleeps on an empty ring */
+
+
+/*
+** A thread reads ahead in the input and passes the faults on to read_next()
+** through a ring buffer.
+*/
+typedef enum {EV_FAULT, EV_EOF, EV_UNPARSABLE, EV_NOT_ASCENDING} ev_status_t;
+
+typedef struct input_event_t   {
+    double t;			/* Minutes since the first line of the input */
+    int node;
+    int read_cnt;		/* Lines read from the input so far */
+    ev_status_t status;
+} input_event_t;
+
+
+/*
+** Compressed input is inflated by a separate thread into one of two
+** buffers, while the parser reads from the other one.
+*/
+typedef struct gz_buf_t   {
+    char data[GZ_BUF_SIZE];
+    size_t len;
+    int full;
+} gz_buf_t;
+
+typedef struct gz_stream_t   {
+    FILE *fp;			/* Compressed file */
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    gz_buf_t buf[2];
+    int fill;			/* Buffer the inflate thread works on */
+    int drain;			/* Buffer the parser reads from */
+    size_t pos;			/* Parser position in buf[drain] */
+    int eof;			/* No more data after the full buffers */
+    int error;
+    int stop;			/* Tell the thread to quit early */
+} gz_stream_t;
+
+
+/*
+** Each input file is a source. Sources are merged by time through a
+** binary min-heap, so several logs that are each sorted can be read as
+** one. A single input file is just a merge of one source.
+*/
+typedef struct source_t   {
+    FILE *fp;			/* Text input, or the inflated stream of a compressed file */
+    int inflated;		/* fp was created by gz_open() */
+    bintrace_t *bt;		/* Binary trace, instead of fp */
+    double t;			/* Next record of this source */
+    int node;
+} source_t;
 
 
 static int max_nodes= 0;
-static FILE *fp_in= NULL;
+
+/* Files opened by open_input() */
+static FILE **input_files= NULL;
+static int num_input_files= 0;
+
+static source_t *src= NULL;
+static int num_src= 0;
+static int *heap= NULL;		/* Indices into src[]. The source with the earliest record is first */
+static int heap_len;
+static int merge_rc;		/* Returned by next_fault() once the heap is empty */
+
+static input_event_t ring[RING_SIZE];
+static atomic_uint ring_head;	/* Next entry prefetch_thread() fills */
+static atomic_uint ring_tail;	/* Next entry read_next() consumes */
+static atomic_int prefetch_stop;
+static atomic_int ring_waiting;	/* ring_pop() sleeps on ring_cond */
+static pthread_mutex_t ring_lock= PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ring_cond= PTHREAD_COND_INITIALIZER;
+static pthread_t prefetch_tid;
+static int prefetch_running= FALSE;
+
+/* Faults loaded into memory by load_input(), to be replayed several times */
+static input_event_t *replay= NULL;
+static int replay_cnt;
+static int replay_pos;
+static double replay_offset= 0.0;	/* Replay starts this many minutes into the input */
+
+/* read_next() has returned the end of the input. Cleared by init_input() */
+static int input_done= FALSE;
+
+
+/* Local functions */
+static void open_source(source_t *s, FILE *fp);
+static void merge_start(void);
+static int read_source(source_t *s);
+static int source_before(int a, int b);
+static void heap_down(int pos);
+static int next_fault(double *t, int *node);
+static void *prefetch_thread(void *arg);
+static int ring_push(input_event_t *ev);
+static void ring_pop(input_event_t *ev);
+static int find_replay_pos(double t);
+static FILE *gz_open(FILE *fp);
+static void *gz_inflate_thread(void *arg);
+static ssize_t gz_read(void *cookie, char *buf, size_t size);
+static int gz_close(void *cookie);
+
+
+
+/*
+** Open the fault logs named in spec: a file name, "-" for stdin, or a
+** comma separated list of file names and glob patterns. Each file must
+** be in ascending time order; init_input() merges them. Returns the
+** first stream, which stands for all of them in calls to init_input()
+** and load_input().
+*/
+FILE *
+open_input(char *spec)
+{
+
+char *names;
+char *name;
+char *saveptr;
+glob_t g;
+size_t i;
+
+
+    names= strdup(spec);
+    if (names == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    for (name= strtok_r(names, ",", &saveptr); name; name= strtok_r(NULL, ",", &saveptr))   {
+	/* A name that is not a pattern, or matches nothing, is used as is */
+	if (glob(name, GLOB_NOCHECK, NULL, &g) != 0)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+
+	input_files= (FILE **)realloc(input_files,
+	    (num_input_files + g.gl_pathc) * sizeof(FILE *));
+	if (input_files == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+
+	for (i= 0; i < g.gl_pathc; i++)   {
+	    if (strcmp(g.gl_pathv[i], "-") == 0)   {
+		input_files[num_input_files]= stdin;
+	    } else   {
+		input_files[num_input_files]= fopen(g.gl_pathv[i], "r");
+		if (input_files[num_input_files] == NULL)   {
+		    fprintf(stderr, "Could not open input file \"%s\": %s\n", g.gl_pathv[i],
+			strerror(errno));
+		    exit(2);
+		}
+	    }
+	    num_input_files++;
+	}
+	globfree(&g);
+    }
+    free(names);
+
+    if (num_input_files < 1)   {
+	fprintf(stderr, "No input file in \"%s\"\n", spec);
+	exit(2);
+    }
+
+    return input_files[0];
+
+}  /* end of open_input() */
+
+
+
+/*
+** Close the files opened by open_input()
+*/
+void
+close_input(void)
+{
+
+int i;
+
+
+    for (i= 0; i < num_input_files; i++)   {
+	if (input_files[i] != stdin)   {
+	    fclose(input_files[i]);
+	}
+    }
+    free(input_files);
+    input_files= NULL;
+    num_input_files= 0;
+
+}  /* end of close_input() */
 
 
 
 int
-init_input(FILE *fp_input, int num_bundles)
+init_input(FILE *fp_input, int num_nodes)
 {
+
+int i;
+
+
     if (fp_input == NULL)   {
 	/* We are not reading from a file */
 	return FALSE;
     }
 
-    /* Store the file point and max number of nodes */
-    max_nodes= num_bundles;
-    fp_in= fp_input;
+    /* Store the max number of nodes */
+    max_nodes= num_nodes;
+    input_done= FALSE;
+
+    if (replay)   {
+	/* The input is already in memory. Start over at the offset. */
+	replay_pos= find_replay_pos(replay_offset);
+	return TRUE;
+    }
+
+    /* All files from open_input(), or just the one we were given */
+    if ((num_input_files > 0) && (fp_input == input_files[0]))   {
+	num_src= num_input_files;
+    } else   {
+	num_src= 1;
+    }
+    src= (source_t *)calloc(num_src, sizeof(source_t));
+    heap= (int *)malloc(num_src * sizeof(int));
+    if ((src == NULL) || (heap == NULL))   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    for (i= 0; i < num_src; i++)   {
+	open_source(&src[i], (num_src > 1) ? input_files[i] : fp_input);
+    }
+
+    /* Start reading ahead */
+    atomic_store(&ring_head, 0);
+    atomic_store(&ring_tail, 0);
+    atomic_store(&prefetch_stop, FALSE);
+    atomic_store(&ring_waiting, FALSE);
+    if (pthread_create(&prefetch_tid, NULL, prefetch_thread, NULL) != 0)   {
+	fprintf(stderr, "ERROR: Cannot start thread to read input file\n");
+	exit(2);
+    }
+    prefetch_running= TRUE;
 
     return TRUE;
 
@@ -44,70 +287,777 @@ init_input(FILE *fp_input, int num_bundles)
 
 
 /*
-** Extract the next time value from the input file.
+** Release resources held by the input stage. Does not close the file
+** passed to init_input().
+*/
+void
+end_input(void)
+{
+
+int i;
+
+
+    if (prefetch_running)   {
+	atomic_store(&prefetch_stop, TRUE);
+	pthread_join(prefetch_tid, NULL);
+	prefetch_running= FALSE;
+    }
+
+    for (i= 0; i < num_src; i++)   {
+	if (src[i].inflated)   {
+	    fclose(src[i].fp);
+	}
+	bintrace_close(src[i].bt);
+    }
+    free(src);
+    free(heap);
+    src= NULL;
+    heap= NULL;
+    num_src= 0;
+
+}  /* end of end_input() */
+
+
+
+
+/*
+** Read all faults on nodes below max_nodes into memory. Subsequent calls
+** to init_input(), with the same or a smaller number of nodes, replay
+** them without reading the file again. Returns the number of faults.
+*/
+int
+load_input(FILE *fp_input, int num_nodes)
+{
+
+int size;
+int cnt;
+
+
+    init_input(fp_input, num_nodes);
+
+    size= 1024;
+    replay= (input_event_t *)malloc(size * sizeof(input_event_t));
+    if (replay == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    cnt= 0;
+    while (TRUE)   {
+	if (cnt >= size)   {
+	    size= size * 2;
+	    replay= (input_event_t *)realloc(replay, size * sizeof(input_event_t));
+	    if (replay == NULL)   {
+		fprintf(stderr, "Out of memory!\n");
+		exit(10);
+	    }
+	}
+
+	/* The last entry says why the input ended */
+	ring_pop(&replay[cnt]);
+	if (replay[cnt].status != EV_FAULT)   {
+	    break;
+	}
+	cnt++;
+    }
+    end_input();
+    replay_cnt= cnt;
+
+    return cnt;
+
+}  /* end of load_input() */
+
+
+
+/*
+** Replays of an input file loaded with load_input() start this many
+** minutes after the first line of the input. That point in time becomes
+** time 0 of the application. Takes effect at the next init_input().
+*/
+void
+set_replay_offset(double offset)
+{
+    replay_offset= offset;
+}  /* end of set_replay_offset() */
+
+
+
+/*
+** A hash of what a replay on num_nodes nodes reads from the faults
+** load_input() loaded, for the --cache key. The faults on other nodes
+** do not change the run. 0, if nothing was loaded.
+*/
+uint64_t
+input_hash(int num_nodes)
+{
+
+uint64_t h;
+int i;
+
+
+    if (replay == NULL)   {
+	return 0;
+    }
+
+    h= cache_hash(CACHE_HASH_INIT, &num_nodes, sizeof(num_nodes));
+    for (i= 0; i < replay_cnt; i++)   {
+	if (replay[i].node < num_nodes)   {
+	    h= cache_hash(h, &replay[i].t, sizeof(replay[i].t));
+	    h= cache_hash(h, &replay[i].node, sizeof(replay[i].node));
+	    h= cache_hash(h, &replay[i].read_cnt, sizeof(replay[i].read_cnt));
+	}
+    }
+
+    /* Why the input ended */
+    h= cache_hash(h, &replay[replay_cnt].read_cnt, sizeof(replay[replay_cnt].read_cnt));
+    h= cache_hash(h, &replay[replay_cnt].status, sizeof(replay[replay_cnt].status));
+
+    return h;
+
+}  /* end of input_hash() */
+
+
+
+/*
+** Time of the last fault loaded by load_input(), in minutes
+*/
+double
+input_span(void)
+{
+
+    if (replay_cnt < 1)   {
+	return 0.0;
+    }
+
+    return replay[replay_cnt - 1].t;
+
+}  /* end of input_span() */
+
+
+
+/*
+** Binary search for the first loaded fault at or after time t. The
+** loaded faults are in ascending order, which the reader thread checked.
+*/
+static int
+find_replay_pos(double t)
+{
+
+int lo, hi, mid;
+
+
+    lo= 0;
+    hi= replay_cnt;
+    while (lo < hi)   {
+	mid= lo + (hi - lo) / 2;
+	if (replay[mid].t < t)   {
+	    lo= mid + 1;
+	} else   {
+	    hi= mid;
+	}
+    }
+
+    return lo;
+
+}  /* end of find_replay_pos() */
+
+
+
+/*
+** Return the next fault time from the input, in minutes since the first
+** line of the input, and the node that failed. The values are produced
+** by prefetch_thread() below.
+** A negative return value means the input has ended or is broken.
+*/
+double
+read_next(int verbose, int *node)
+{
+
+input_event_t ev;
+
+
+    if (input_done)   {
+	return -1;
+    }
+
+    if (replay)   {
+	/* Skip faults on nodes beyond the ones we are using this time */
+	do   {
+	    ev= replay[replay_pos++];
+	} while ((ev.status == EV_FAULT) && (ev.node >= max_nodes));
+    } else   {
+	ring_pop(&ev);
+    }
+
+    read_input_cnt= ev.read_cnt;
+    switch (ev.status)   {
+	case EV_FAULT:
+	    break;
+	case EV_EOF:
+	    input_done= TRUE;
+	    return -1;
+	case EV_UNPARSABLE:
+	    fprintf(stderr, "ERROR: Input file unparsable\n");
+	    input_done= TRUE;
+	    return -1;
+	case EV_NOT_ASCENDING:
+	    fprintf(stderr, "ERROR: Fault times read from input file are not ascending!\n");
+	    exit(8);
+	default:
+	    assert(FALSE);
+    }
+
+    if (replay)   {
+	ev.t= ev.t - replay_offset;
+    }
+
+    TRACE3(verbose, "Input file %12.3f\"\n", ev.t);
+
+    read_input_accepted++;
+    *node= ev.node;
+    return ev.t;
+
+}  /* end of read_next() */
+
+
+
+/*
+** Read ahead in the input file and place the faults that concern us
+** into the prefetch ring.
 ** The file is supposed to contain three fields: time node error
 ** Time is in seconds, node is a rank number >= 0, and error
 ** is a single word error indication.
+** The file may also be a binary trace produced by trace_conv.
+** Records from several files are merged by next_fault().
 */
-double
-read_next(int verbose)
+static void *
+prefetch_thread(void *arg)
 {
 
 int rc;
 double t;
-static double start;
+double start;
+double last;
 int node;
-char err[MAX_ERR_STR_LEN];
-static int first_time= TRUE;
+input_event_t ev;
 
 
-    if (first_time)   {
-	/*
-	** The first time around we read the first line and use that time as an offset.
-	** That way the fault data and the application both start at 0.
-	*/
-	first_time= FALSE;
-	rc= fscanf(fp_in, "%lf %d %s", &start, &node, err);
+    (void)arg;
+    merge_start();
+    ev.read_cnt= 0;
+    ev.node= -1;
+    ev.t= -1.0;
+
+    /*
+    ** The first line is used as an offset. That way the fault data and
+    ** the application both start at 0.
+    */
+    rc= next_fault(&start, &node);
+    if (rc == EOF)   {
+	ev.status= EV_EOF;
+	ring_push(&ev);
+	return NULL;
+    } else if (rc != 3)   {
+	ev.status= EV_UNPARSABLE;
+	ring_push(&ev);
+	return NULL;
+    }
+
+    last= 0.0;
+    while (TRUE)   {
+	rc= next_fault(&t, &node);
 	if (rc == EOF)   {
-	    return -1;
+	    ev.status= EV_EOF;
+	    ring_push(&ev);
+	    break;
 	} else if (rc != 3)   {
-	    fprintf(stderr, "ERROR: Input file unparsable\n");
-	    return -1;
+	    ev.status= EV_UNPARSABLE;
+	    ring_push(&ev);
+	    break;
+	}
+
+	ev.read_cnt++;
+
+	/*
+	** Make sure the node is within our node count.
+	** Basically, the simulator runs an application on num_bundles nodes,
+	** plus any redundant nodes. The input file represents a machine that
+	** may have more than that many nodes. The simulator "runs" the
+	** application on the first num_bundles + num_redundant nodes.
+	*/
+	if (node >= max_nodes)   {
+	    continue;
+	}
+
+	/* Convert to minutes */
+	ev.t= (t - start) / 60.0;
+	ev.node= node;
+	if (ev.t < last)   {
+	    ev.status= EV_NOT_ASCENDING;
+	    ring_push(&ev);
+	    break;
+	}
+	last= ev.t;
+
+	ev.status= EV_FAULT;
+	if (!ring_push(&ev))   {
+	    /* We have been told to stop */
+	    break;
 	}
     }
 
+    return NULL;
+
+}  /* end of prefetch_thread() */
+
+
+
+/*
+** Append an event to the prefetch ring. There is only one producer
+** (prefetch_thread()) and one consumer (read_next()), so no locks
+** are needed, unless the consumer is asleep on an empty ring. Returns
+** FALSE if the reader should stop.
+*/
+static int
+ring_push(input_event_t *ev)
+{
+
+unsigned int head;
+struct timespec pause;
+
+
+    head= atomic_load_explicit(&ring_head, memory_order_relaxed);
+    while ((head - atomic_load_explicit(&ring_tail, memory_order_acquire)) >= RING_SIZE)   {
+	/* The ring is full. The simulation is busy; don't compete with it. */
+	if (atomic_load(&prefetch_stop))   {
+	    return FALSE;
+	}
+	pause.tv_sec= 0;
+	pause.tv_nsec= 100 * 1000;
+	nanosleep(&pause, NULL);
+    }
+
+    ring[head & (RING_SIZE - 1)]= *ev;
+    atomic_store(&ring_head, head + 1);
+
+    /* ring_pop() sets ring_waiting before it checks ring_head one last time */
+    if (atomic_load(&ring_waiting))   {
+	pthread_mutex_lock(&ring_lock);
+	pthread_cond_signal(&ring_cond);
+	pthread_mutex_unlock(&ring_lock);
+    }
+
+    return TRUE;
+
+}  /* end of ring_push() */
+
+
+
+
+/*
+** Take the next event out of the prefetch ring. Wait for the reader, if
+** it has not caught up yet. Usually it is only a moment behind; a slow
+** input, like a pipe or a compressed file, may take longer, and then we
+** sleep instead of keeping a CPU busy.
+*/
+static void
+ring_pop(input_event_t *ev)
+{
+
+unsigned int tail;
+int spins;
+
+
+    tail= atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    spins= 0;
+    while (tail == atomic_load_explicit(&ring_head, memory_order_acquire))   {
+	if (spins++ < RING_SPINS)   {
+	    sched_yield();
+	    continue;
+	}
+
+	pthread_mutex_lock(&ring_lock);
+	atomic_store(&ring_waiting, TRUE);
+	while (tail == atomic_load(&ring_head))   {
+	    pthread_cond_wait(&ring_cond, &ring_lock);
+	}
+	atomic_store(&ring_waiting, FALSE);
+	pthread_mutex_unlock(&ring_lock);
+    }
+    *ev= ring[tail & (RING_SIZE - 1)];
+    atomic_store_explicit(&ring_tail, tail + 1, memory_order_release);
+
+}  /* end of ring_pop() */
+
+
+
+/*
+** Figure out what kind of file this is
+*/
+static void
+open_source(source_t *s, FILE *fp)
+{
+
+    s->fp= fp;
+    s->inflated= FALSE;
+    s->bt= NULL;
 
     /*
-    ** Make sure the node is within our node count.
-    ** Basically, the simulator runs an application on num_bundles nodes.
-    ** The input file represents a machine that may have more than that
-    ** many nodes. The simulator "runs" the application on the first num_bundles
-    ** nodes.
+    ** gzip compressed logs are inflated on the fly. This works on pipes
+    ** too, since we only need to peek at the first byte.
     */
-    while (TRUE)   {
-	rc= fscanf(fp_in, "%lf %d %s", &t, &node, err);
-	if (rc == EOF)   {
-	    return -1;
-	} else if (rc != 3)   {
-	    fprintf(stderr, "ERROR: Input file unparsable\n");
-	    return -1;
+    if (ungetc(getc(fp), fp) == GZ_MAGIC)   {
+	s->fp= gz_open(fp);
+	s->inflated= TRUE;
+    } else if (bintrace_probe(fp))   {
+	/* Binary traces are mapped into memory instead of being parsed */
+	s->bt= bintrace_open(fp);
+    }
+
+}  /* end of open_source() */
+
+
+
+/*
+** Read the first record of each source and build the heap. Called by
+** the prefetch thread, since reading may block.
+*/
+static void
+merge_start(void)
+{
+
+int i;
+int rc;
+
+
+    merge_rc= EOF;
+    heap_len= 0;
+    for (i= 0; i < num_src; i++)   {
+	rc= read_source(&src[i]);
+	if (rc == 3)   {
+	    heap[heap_len++]= i;
+	} else if (rc != EOF)   {
+	    /* Report it right away */
+	    merge_rc= rc;
+	    heap_len= 0;
+	    return;
 	}
+    }
+
+    for (i= heap_len / 2 - 1; i >= 0; i--)   {
+	heap_down(i);
+    }
+
+}  /* end of merge_start() */
+
+
+
+/*
+** Read one line (or record) of a source. Returns the number of
+** fields converted, like fscanf().
+*/
+static int
+read_source(source_t *s)
+{
+
+char err[MAX_ERR_STR_LEN];
 
-	read_input_cnt++;
 
-	if (node < max_nodes)   {
-	    /* Acceptable node */
+    if (s->bt)   {
+	return bintrace_next(s->bt, &s->t, &s->node);
+    }
+
+    return fscanf(s->fp, "%lf %d %s", &s->t, &s->node, err);
+
+}  /* end of read_source() */
+
+
+
+/*
+** Order of the sources in the heap. Sources with records at the same
+** time are taken in the order they were given.
+*/
+static int
+source_before(int a, int b)
+{
+
+    if (src[a].t < src[b].t)   {
+	return TRUE;
+    } else if (src[a].t > src[b].t)   {
+	return FALSE;
+    }
+
+    return a < b;
+
+}  /* end of source_before() */
+
+
+
+static void
+heap_down(int pos)
+{
+
+int child;
+int tmp;
+
+
+    while ((child= 2 * pos + 1) < heap_len)   {
+	if ((child + 1 < heap_len) && source_before(heap[child + 1], heap[child]))   {
+	    child++;
+	}
+	if (!source_before(heap[child], heap[pos]))   {
 	    break;
 	}
+	tmp= heap[pos];
+	heap[pos]= heap[child];
+	heap[child]= tmp;
+	pos= child;
     }
 
-    /* Convert to minutes */
-    t= (t - start) / 60.0;
-    if (verbose > 2)   {
-	fprintf(stderr, "Input file %12.3f\"\n", t);
+}  /* end of heap_down() */
+
+
+
+/*
+** Return the earliest record of all sources, and replace it with the
+** next record from the same source. Returns the number of fields
+** converted, like fscanf().
+*/
+static int
+next_fault(double *t, int *node)
+{
+
+source_t *s;
+int rc;
+
+
+    if (heap_len == 0)   {
+	return merge_rc;
     }
 
-    read_input_accepted++;
-    return t;
+    s= &src[heap[0]];
+    *t= s->t;
+    *node= s->node;
 
-}  /* end of read_next() */
+    rc= read_source(s);
+    if (rc == EOF)   {
+	heap[0]= heap[--heap_len];
+    } else if (rc != 3)   {
+	/* Hand out this record, then the error */
+	merge_rc= rc;
+	heap_len= 0;
+	return 3;
+    }
+    heap_down(0);
+
+    return 3;
+
+}  /* end of next_fault() */
+
+
+
+/*
+** Wrap a gzip compressed stream into a FILE that delivers the
+** inflated data. A thread does the inflating ahead of the parser.
+*/
+static FILE *
+gz_open(FILE *fp)
+{
+
+cookie_io_functions_t io_funcs;
+gz_stream_t *gz;
+FILE *fp_gz;
+
+
+    gz= (gz_stream_t *)calloc(1, sizeof(gz_stream_t));
+    if (gz == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    gz->fp= fp;
+    gz->fill= 0;
+    gz->drain= 0;
+    pthread_mutex_init(&gz->lock, NULL);
+    pthread_cond_init(&gz->cond, NULL);
+
+    if (pthread_create(&gz->thread, NULL, gz_inflate_thread, gz) != 0)   {
+	fprintf(stderr, "ERROR: Cannot start thread to read compressed input\n");
+	exit(2);
+    }
+
+    memset(&io_funcs, 0, sizeof(io_funcs));
+    io_funcs.read= gz_read;
+    io_funcs.close= gz_close;
+    fp_gz= fopencookie(gz, "r", io_funcs);
+    if (fp_gz == NULL)   {
+	fprintf(stderr, "ERROR: Cannot open stream for compressed input\n");
+	exit(2);
+    }
+
+    return fp_gz;
+
+}  /* end of gz_open() */
+
+
+
+/*
+** Inflate the input file into whichever buffer the parser is not
+** using. Handles files with several concatenated gzip members.
+*/
+static void *
+gz_inflate_thread(void *arg)
+{
+
+gz_stream_t *gz= arg;
+unsigned char in[GZ_BUF_SIZE / 4];
+z_stream z;
+gz_buf_t *buf;
+int rc;
+int done;
+int in_member;
+
+
+    memset(&z, 0, sizeof(z));
+    in_member= FALSE;
+    /* 15 + 32: maximum window size, and expect a gzip header */
+    if (inflateInit2(&z, 15 + 32) != Z_OK)   {
+	fprintf(stderr, "ERROR: Cannot initialize zlib: %s\n", z.msg ? z.msg : "");
+	gz->error= TRUE;
+    }
+
+    done= gz->error;
+    while (!done)   {
+	/* Wait for an empty buffer */
+	pthread_mutex_lock(&gz->lock);
+	while (gz->buf[gz->fill].full && !gz->stop)   {
+	    pthread_cond_wait(&gz->cond, &gz->lock);
+	}
+	done= gz->stop;
+	pthread_mutex_unlock(&gz->lock);
+	if (done)   {
+	    break;
+	}
+
+	buf= &gz->buf[gz->fill];
+	buf->len= 0;
+	while ((buf->len < GZ_BUF_SIZE) && !done)   {
+	    if (z.avail_in == 0)   {
+		z.avail_in= fread(in, 1, sizeof(in), gz->fp);
+		z.next_in= in;
+		if (z.avail_in == 0)   {
+		    if (ferror(gz->fp))   {
+			fprintf(stderr, "ERROR: Read of compressed input failed\n");
+			gz->error= TRUE;
+		    } else if (in_member)   {
+			fprintf(stderr, "ERROR: Compressed input is truncated\n");
+			gz->error= TRUE;
+		    }
+		    done= TRUE;
+		    break;
+		}
+	    }
+
+	    z.next_out= (unsigned char *)buf->data + buf->len;
+	    z.avail_out= GZ_BUF_SIZE - buf->len;
+	    rc= inflate(&z, Z_NO_FLUSH);
+	    buf->len= GZ_BUF_SIZE - z.avail_out;
+	    in_member= TRUE;
+	    if (rc == Z_STREAM_END)   {
+		/* There may be another gzip member after this one */
+		inflateReset(&z);
+		in_member= FALSE;
+	    } else if ((rc != Z_OK) && (rc != Z_BUF_ERROR))   {
+		fprintf(stderr, "ERROR: Compressed input is corrupt: %s\n", z.msg ? z.msg : "");
+		gz->error= TRUE;
+		done= TRUE;
+	    }
+	}
+
+	/* Hand the buffer to the parser */
+	pthread_mutex_lock(&gz->lock);
+	buf->full= TRUE;
+	gz->fill= 1 - gz->fill;
+	if (done)   {
+	    gz->eof= TRUE;
+	}
+	pthread_cond_broadcast(&gz->cond);
+	pthread_mutex_unlock(&gz->lock);
+    }
+
+    inflateEnd(&z);
+    return NULL;
+
+}  /* end of gz_inflate_thread() */
+
+
+
+/*
+** Called by stdio when it needs more data from a compressed stream
+*/
+static ssize_t
+gz_read(void *cookie, char *data, size_t size)
+{
+
+gz_stream_t *gz= cookie;
+gz_buf_t *buf;
+size_t len;
+
+
+    buf= &gz->buf[gz->drain];
+    pthread_mutex_lock(&gz->lock);
+    while (!buf->full && !gz->eof)   {
+	pthread_cond_wait(&gz->cond, &gz->lock);
+    }
+    pthread_mutex_unlock(&gz->lock);
+    if (!buf->full)   {
+	/* End of data */
+	return gz->error ? -1 : 0;
+    }
+
+    len= buf->len - gz->pos;
+    if (len > size)   {
+	len= size;
+    }
+    memcpy(data, buf->data + gz->pos, len);
+    gz->pos= gz->pos + len;
+
+    if (gz->pos >= buf->len)   {
+	/* Give this buffer back to the inflate thread */
+	pthread_mutex_lock(&gz->lock);
+	buf->full= FALSE;
+	gz->drain= 1 - gz->drain;
+	gz->pos= 0;
+	pthread_cond_broadcast(&gz->cond);
+	pthread_mutex_unlock(&gz->lock);
+    }
+
+    if ((len == 0) && gz->error)   {
+	return -1;
+    }
+
+    return len;
+
+}  /* end of gz_read() */
+
+
+
+static int
+gz_close(void *cookie)
+{
+
+gz_stream_t *gz= cookie;
+
+
+    pthread_mutex_lock(&gz->lock);
+    gz->stop= TRUE;
+    pthread_cond_broadcast(&gz->cond);
+    pthread_mutex_unlock(&gz->lock);
+    pthread_join(gz->thread, NULL);
+
+    pthread_mutex_destroy(&gz->lock);
+    pthread_cond_destroy(&gz->cond);
+    free(gz);
+
+    return 0;
+
+}  /* end of gz_close() */
@@ -14,8 +14,17 @@
 #ifndef _INPUT_H
 #define _INPUT_H
 
+#include <stdint.h>
 
-int init_input(FILE *fp_input, int num_bundles);
-double read_next(int verbose);
+
+FILE *open_input(char *spec);
+void close_input(void);
+int init_input(FILE *fp_input, int num_nodes);
+void end_input(void);
+int load_input(FILE *fp_input, int num_nodes);
+void set_replay_offset(double offset);
+double input_span(void);
+uint64_t input_hash(int num_nodes);
+double read_next(int verbose, int *node);
 
 #endif /* _INPUT_H */
@@ -0,0 +1,405 @@
+/*
+** $Id$
+**
+** The library interface to the simulation. See libapp_model.h.
+**
+** am_run() and am_run_with() share run(), so two_step and the library
+** simulate the same way, and a run with the same seed gets the same
+** results. The state of the simulation is thread local (SIM_LOCAL in
+** globals.h). Errors deep inside the simulation call sim_error(), which
+** comes back to am_run() with longjmp() instead of ending the program,
+** because sim_jmp is set during the run.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <setjmp.h>
+
+#include "globals.h"
+#include "rnd.h"
+#include "perf.h"
+#include "writer.h"
+#include "snapshot.h"
+#include "rMPI_model.h"
+#include "predict.h"
+#include "app.h"
+#include "hist.h"
+#include "libapp_model.h"
+
+/* The same defaults as two_step */
+#define AM_DEFAULT_NODE_MTBF	(43800.0)	/* 5 years */
+#define AM_DEFAULT_NUM_BUNDLES	(512)
+
+
+struct am_ctx_t   {
+    am_config_t cfg;
+    int have_results;
+    am_results_t r;
+    char err[sizeof(sim_errmsg)];
+};
+
+
+/* Local functions */
+static void run(am_ctx_t *ctx, am_extra_t *x);
+static void set_error(am_ctx_t *ctx, const char *msg);
+static void fill_results(am_ctx_t *ctx, double elapsed, double tau, double sys_mtbf,
+		double app_mtbf, double fpi, double work_time);
+
+
+
+am_ctx_t *
+am_init(void)
+{
+
+am_ctx_t *ctx;
+
+
+    ctx= (am_ctx_t *)calloc(1, sizeof(am_ctx_t));
+    if (ctx == NULL)   {
+	return NULL;
+    }
+    am_defaults(&ctx->cfg);
+    return ctx;
+
+}  /* end of am_init() */
+
+
+
+/*
+** The configuration two_step runs without any options, except that the
+** seed is fixed, as with -s
+*/
+void
+am_defaults(am_config_t *cfg)
+{
+
+    memset(cfg, 0, sizeof(am_config_t));
+    cfg->active_nodes= AM_DEFAULT_NUM_BUNDLES;
+    cfg->redundant_nodes= 0;
+    cfg->node_mtbf= AM_DEFAULT_NODE_MTBF;
+    cfg->sys_mtbf= -1.0;
+    cfg->app_mtbf= -1.0;
+    cfg->work_time= 168.0;
+    cfg->checkpoint_time= 5.0;
+    cfg->restart_time= 10.0;
+    cfg->tau= -1.0;
+    cfg->ras_delay= 0.0;
+    cfg->distribution= AM_DIST_EXP;
+    cfg->shape= 0.5;
+    cfg->scale= AM_DEFAULT_NODE_MTBF;
+    cfg->soft_reboot_success= -1.0;
+    cfg->soft_reboot_time= 0.0;
+    cfg->hotswap= FALSE;
+    cfg->seed= 0;
+    cfg->time_budget= 0.0;
+
+}  /* end of am_defaults() */
+
+
+
+/*
+** Check the configuration and keep a copy for the next am_run(). It
+** accepts what the two_step options accept.
+*/
+int
+am_configure(am_ctx_t *ctx, const am_config_t *cfg)
+{
+
+const char *bad;
+
+
+    if ((ctx == NULL) || (cfg == NULL))   {
+	return AM_EINVAL;
+    }
+
+    bad= NULL;
+    if (cfg->active_nodes < 1)   {
+	bad= "active_nodes must be > 0";
+    } else if ((cfg->redundant_nodes < 0) || (cfg->redundant_nodes > cfg->active_nodes))   {
+	bad= "redundant_nodes must be between 0 and active_nodes";
+    } else if (cfg->node_mtbf <= 0.0)   {
+	bad= "node_mtbf must be > 0";
+    } else if (cfg->work_time <= 0.0)   {
+	bad= "work_time must be > 0";
+    } else if (cfg->checkpoint_time <= 0.0)   {
+	bad= "checkpoint_time must be > 0";
+    } else if (cfg->restart_time <= 0.0)   {
+	bad= "restart_time must be > 0";
+    } else if (cfg->ras_delay < 0.0)   {
+	bad= "ras_delay must be >= 0";
+    } else if ((cfg->distribution != AM_DIST_EXP) && (cfg->distribution != AM_DIST_GAMMA) &&
+	    (cfg->distribution != AM_DIST_WEIBULL))   {
+	bad= "Unknown distribution";
+    } else if ((cfg->shape <= 0.0) || (cfg->scale <= 0.0))   {
+	bad= "shape and scale must be > 0";
+    } else if (cfg->soft_reboot_success > 100.0)   {
+	bad= "soft_reboot_success must be 0% - 100%";
+    } else if (cfg->soft_reboot_time < 0.0)   {
+	bad= "soft_reboot_time must be >= 0";
+    }
+
+    if (bad)   {
+	set_error(ctx, bad);
+	return AM_EINVAL;
+    }
+
+    ctx->cfg= *cfg;
+    ctx->have_results= FALSE;
+    set_error(ctx, "");
+    return AM_OK;
+
+}  /* end of am_configure() */
+
+
+
+/*
+** Run the simulation. Returns AM_OK, or the exit code of two_step, if
+** the simulation failed.
+*/
+int
+am_run(am_ctx_t *ctx)
+{
+
+jmp_buf env;
+int rc;
+
+
+    if (ctx == NULL)   {
+	return AM_EINVAL;
+    }
+
+    sim_jmp= &env;
+    rc= setjmp(env);
+    if (rc == 0)   {
+	run(ctx, NULL);
+	rc= AM_OK;
+    } else   {
+	set_error(ctx, sim_errmsg);
+    }
+
+    sim_jmp= NULL;
+    rMPI_end();
+    rnd_end();
+    return rc;
+
+}  /* end of am_run() */
+
+
+
+/*
+** The run of two_step. See am_extra_t in libapp_model.h.
+*/
+int
+am_run_with(am_ctx_t *ctx, am_extra_t *x)
+{
+
+    if ((ctx == NULL) || (x == NULL))   {
+	return AM_EINVAL;
+    }
+
+    run(ctx, x);
+    rMPI_end();
+    rnd_end();
+    return AM_OK;
+
+}  /* end of am_run_with() */
+
+
+
+int
+am_results(am_ctx_t *ctx, am_results_t *r)
+{
+
+    if ((ctx == NULL) || (r == NULL))   {
+	return AM_EINVAL;
+    }
+    if (!ctx->have_results)   {
+	return AM_ENORUN;
+    }
+
+    *r= ctx->r;
+    return AM_OK;
+
+}  /* end of am_results() */
+
+
+
+/*
+** What went wrong in the last call on this context. Empty, if nothing did.
+*/
+const char *
+am_error(am_ctx_t *ctx)
+{
+
+    if (ctx == NULL)   {
+	return "No context";
+    }
+    return ctx->err;
+
+}  /* end of am_error() */
+
+
+
+void
+am_free(am_ctx_t *ctx)
+{
+
+    free(ctx);
+
+}  /* end of am_free() */
+
+
+
+/*
+** Release the memory the runs on this thread kept for the next one
+*/
+void
+am_thread_end(void)
+{
+
+    rMPI_free();
+    hist_free();
+
+}  /* end of am_thread_end() */
+
+
+
+/*
+** Set up the nodes and simulate, with the extras of two_step, if x is
+** not NULL. Everything else is in the configuration of ctx.
+*/
+static void
+run(am_ctx_t *ctx, am_extra_t *x)
+{
+
+am_config_t *c;
+rnd_t rnd;
+double node_mtbf;
+double work_time;
+double tau;
+double sys_mtbf;
+double app_mtbf;
+double fpi;
+double elapsed;
+FILE *fp_input;
+int verbose;
+
+
+    c= &ctx->cfg;
+    ctx->have_results= FALSE;
+    set_error(ctx, "");
+    fp_input= x ? x->fp_input : NULL;
+    verbose= x ? x->verbose : 0;
+
+    switch (c->distribution)   {
+	case AM_DIST_GAMMA:	rnd= RND_GAMMA; break;
+	case AM_DIST_WEIBULL:	rnd= RND_WEIBULL; break;
+	case AM_DIST_EXP:
+	default:		rnd= RND_EXP; break;
+    }
+
+    /* Minutes, like everything else */
+    node_mtbf= 60.0 * c->node_mtbf;
+    work_time= 60.0 * c->work_time;
+    tau= (c->tau > 0.0) ? c->tau : -1.0;
+    sys_mtbf= (c->sys_mtbf > 0.0) ? 60.0 * c->sys_mtbf : -1.0;
+    app_mtbf= (c->app_mtbf > 0.0) ? 60.0 * c->app_mtbf : -1.0;
+
+    init_rnd(rnd, node_mtbf, TRUE, c->shape, 60.0 * c->scale);
+    if (c->seed != 0)   {
+	rnd_seed(c->seed);
+    }
+    init_globals();
+    predict_tau(&tau, &sys_mtbf, &app_mtbf, &fpi, c->active_nodes, c->redundant_nodes,
+	node_mtbf, c->checkpoint_time);
+
+    perf_init(x ? x->timers : FALSE);
+    if (x && x->fname_resume)   {
+	/* Instead of setting up the nodes. It also restores the counters */
+	snapshot_resume(x->fname_resume, c->active_nodes, c->active_nodes + c->redundant_nodes,
+	    fp_input);
+    } else   {
+	rMPI_init(c->active_nodes, c->active_nodes + c->redundant_nodes, fp_input, verbose);
+    }
+
+    perf_switch(PERF_PHASES);
+    app_time_budget(c->time_budget);
+    elapsed= app_model(verbose, tau, c->checkpoint_time, c->restart_time, work_time,
+		c->ras_delay, x ? x->w_ints : NULL, x ? x->w_faults : NULL,
+		(float)c->soft_reboot_time, (float)c->soft_reboot_success, c->hotswap);
+    perf_switch(PERF_OTHER);
+
+    /* At this point we're one over */
+    interrupt_cnt--;
+    fill_results(ctx, elapsed, tau, sys_mtbf, app_mtbf, fpi, work_time);
+
+}  /* end of run() */
+
+
+
+static void
+set_error(am_ctx_t *ctx, const char *msg)
+{
+
+    snprintf(ctx->err, sizeof(ctx->err), "%s", msg);
+
+}  /* end of set_error() */
+
+
+
+static void
+fill_results(am_ctx_t *ctx, double elapsed, double tau, double sys_mtbf, double app_mtbf,
+	double fpi, double work_time)
+{
+
+am_results_t *r= &ctx->r;
+
+
+    memset(r, 0, sizeof(am_results_t));
+    r->elapsed= elapsed;
+    if (!stopped_early)   {
+	r->extrapolated_elapsed= elapsed;
+    } else if (total_work_time > 0.0)   {
+	/* If the rest of the work goes like the part that was done */
+	r->extrapolated_elapsed= elapsed / total_work_time * work_time;
+    } else   {
+	r->extrapolated_elapsed= -1.0;
+    }
+    r->tau= tau;
+    r->sys_mtbf= sys_mtbf;
+    r->app_mtbf= app_mtbf;
+
+    /* This is eq 20 from Daly:04:higher */
+    r->daly= app_mtbf *
+	    exp(ctx->cfg.restart_time / app_mtbf) *
+	    (exp((tau + ctx->cfg.checkpoint_time) / app_mtbf) - 1.0) *
+	    (work_time / tau);
+    r->faults_per_interrupt= fpi;
+
+    r->work_time= total_work_time;
+    r->checkpoint_time= total_checkpoint_time;
+    r->restart_time= total_restart_time;
+    r->rework_time= total_rework_time;
+    r->ras_delay= total_ras_delay;
+    r->interrupts= interrupt_cnt;
+    r->faults= fault_cnt;
+    r->node_failures= node_failure_cnt;
+    r->checkpoints= checkpoint_cnt;
+    r->failed_checkpoints= failed_checkpoint_cnt;
+    r->restarts= restart_cnt;
+    r->failed_restarts= failed_restart_cnt;
+    r->soft_reboot_successes= soft_reboot_success_cnt;
+    r->soft_reboot_failures= soft_reboot_failure_cnt;
+    r->stopped_early= stopped_early;
+    ctx->have_results= TRUE;
+
+}  /* end of fill_results() */
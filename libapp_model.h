@@ -0,0 +1,140 @@
+/*
+** $Id$
+**
+** libapp_model: run the checkpoint/restart simulation of two_step from
+** another program, without starting a process for each run.
+**
+**     am_ctx_t *ctx;
+**     am_config_t cfg;
+**     am_results_t r;
+**
+**     am_defaults(&cfg);
+**     cfg.active_nodes= 4096;
+**     cfg.seed= 42;
+**     ctx= am_init();
+**     if (ctx && (am_configure(ctx, &cfg) == AM_OK) && (am_run(ctx) == AM_OK))   {
+**         am_results(ctx, &r);
+**     }
+**     am_free(ctx);
+**
+** The simulation state is per thread: several threads can each run
+** their own context at the same time, but a context must only be used
+** by one thread at a time. The library does not print anything and
+** does not exit; errors are returned, and am_error() describes them.
+**
+** A thread keeps the memory for its nodes and histograms after a run,
+** so the next run of a similar size does not have to allocate it again.
+** Call am_thread_end() before a thread that ran simulations exits.
+**
+** The faults come from the random number generator only. Reading them
+** from --input files, the --fi and --ff files, --events, snapshots, and
+** --branch are two_step features that are not part of this API.
+** two_step runs its simulations through am_run_with() at the end of
+** this file, which takes the ones that happen inside the run.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _LIBAPP_MODEL_H_
+#define _LIBAPP_MODEL_H_
+
+#include <stdio.h>
+
+/*
+** Return codes. A run that fails returns the exit code two_step would
+** have ended with instead; e.g., 4 for a negative tau, or 10 when it
+** runs out of memory.
+*/
+#define AM_OK			(0)
+#define AM_EINVAL		(-1)	/* Bad configuration, or NULL context */
+#define AM_ENORUN		(-2)	/* am_results() before a successful am_run() */
+
+typedef enum {AM_DIST_EXP, AM_DIST_GAMMA, AM_DIST_WEIBULL} am_dist_t;
+
+/* The two_step options each field stands for are in parentheses */
+typedef struct am_config_t   {
+    int active_nodes;			/* (-n) */
+    int redundant_nodes;		/* (-r) <= active_nodes */
+    double node_mtbf;			/* (-m) hours */
+    double sys_mtbf;			/* (--mtbf_sys) hours, <= 0 to calculate */
+    double app_mtbf;			/* (--mtbf_app) hours, <= 0 to calculate */
+    double work_time;			/* (-w) hours */
+    double checkpoint_time;		/* (-c) minutes */
+    double restart_time;		/* (-R) minutes */
+    double tau;				/* (-t) minutes, <= 0 for Daly's optimum */
+    double ras_delay;			/* (-d) minutes */
+    am_dist_t distribution;		/* (--distrib) */
+    double shape;			/* (--shape) gamma and Weibull */
+    double scale;			/* (--scale) hours, Weibull */
+    double soft_reboot_success;		/* (--soft_reboot) percent, < 0 for none */
+    double soft_reboot_time;		/* (--soft_reboot) minutes */
+    int hotswap;			/* (--hotswap) */
+    unsigned long seed;			/* 0 for the fixed seed of -s */
+    double time_budget;			/* (--time_budget) seconds, <= 0 for none */
+} am_config_t;
+
+/* Times in minutes, like the two_step report */
+typedef struct am_results_t   {
+    double elapsed;			/* So far, if stopped_early */
+    double extrapolated_elapsed;	/* To complete all work. < 0 if no work was done */
+    double tau;				/* The one used */
+    double sys_mtbf;
+    double app_mtbf;
+    double daly;			/* Elapsed time predicted by Daly's model */
+    double faults_per_interrupt;	/* < 0 if not known */
+    double work_time;
+    double checkpoint_time;
+    double restart_time;
+    double rework_time;
+    double ras_delay;
+    int interrupts;
+    int faults;
+    int node_failures;
+    int checkpoints;
+    int failed_checkpoints;
+    int restarts;
+    int failed_restarts;
+    int soft_reboot_successes;
+    int soft_reboot_failures;
+    int stopped_early;			/* Non-zero, if time_budget ended the run */
+} am_results_t;
+
+typedef struct am_ctx_t am_ctx_t;
+
+
+am_ctx_t *am_init(void);
+void am_defaults(am_config_t *cfg);
+int am_configure(am_ctx_t *ctx, const am_config_t *cfg);
+int am_run(am_ctx_t *ctx);
+int am_results(am_ctx_t *ctx, am_results_t *r);
+const char *am_error(am_ctx_t *ctx);
+void am_free(am_ctx_t *ctx);
+void am_thread_end(void);
+
+
+/*
+** For two_step only. The parts of its features that happen inside the
+** run; two_step sets up the rest (--events, --snapshot_every, --branch,
+** --progress) in their modules before am_run_with(). Unlike am_run(),
+** errors end the program with the exit code of sim_error(): the
+** branches fork inside the run, and a child must not return into the
+** am_run_with() of its parent. After the run, the counters, histograms,
+** and timers of the thread are left as the run ended, for the report.
+*/
+typedef struct am_extra_t   {
+    FILE *fp_input;			/* (--input) NULL for random faults */
+    struct writer_t *w_ints;		/* (--fi) NULL for none */
+    struct writer_t *w_faults;		/* (--ff) NULL for none */
+    char *fname_resume;			/* (--resume) NULL to start at the beginning */
+    int verbose;			/* (-v) */
+    int timers;				/* (-p) */
+} am_extra_t;
+
+int am_run_with(am_ctx_t *ctx, am_extra_t *x);
+
+#endif /* _LIBAPP_MODEL_H_ */
@@ -15,24 +15,42 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>		/* For strcmp(), strerror() */
-#include <math.h>		/* For sqrt() */
+#include <math.h>		/* For exp() */
 #include <getopt.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>		/* For time() */
+#include <unistd.h>		/* For getpid() */
 #include <gsl/gsl_sf_gamma.h>
 
 #include "globals.h"
+#include "writer.h"
+#include "snapshot.h"
+#include "branch.h"
 #include "app.h"
 #include "report.h"
 #include "rnd.h"
 #include "rMPI_model.h"
 #include "timing.h"
+#include "input.h"
+#include "tasks.h"
+#include "record.h"
+#include "colfile.h"
+#include "events.h"
+#include "debug.h"
+#include "perf.h"
+#include "predict.h"
+#include "progress.h"
+#include "libapp_model.h"
+#include "serve.h"
+#include "cache.h"
+#include "manifest.h"
 
 
 /*
 ** Change this when the output or the calculation changes
 */
-#define VERSION			"1.005"
+#define VERSION			"1.008"
 
 
 /*
@@ -50,45 +68,137 @@
 
 
 
+/*
+** What the tasks of a --sizes or --offset_* run need to know. A --sizes
+** run has a list of sizes, a window run a list of start offsets into the
+** input. Time values that were not given on the command line are < 0 and
+** get calculated for each task. Tasks only simulate the sizes or windows
+** that were not in the --cache. With -r, each size has its own number
+** of redundant nodes. The tasks run cfg with their own size; the other
+** values are for the --cache keys and the --columnar rows.
+*/
+typedef struct sweep_t   {
+    int *sizes;
+    int *redundant;		/* Redundant nodes of each size, or NULL */
+    double *offsets;
+    int *tasks;			/* Task number -> index into sizes or offsets */
+    int num_bundles;
+    int num_redundant;
+    double tau;
+    double sys_mtbf;
+    double app_mtbf;
+    double node_mtbf;
+    double checkpoint_time;
+    double restart_time;
+    double work_time;
+    double ras_delay;
+    float soft_time_to_reboot;
+    float soft_reboot_success_rate;
+    int hotswap;
+    FILE *fp_input;
+    int verbose;
+    am_config_t cfg;
+} sweep_t;
+
+
+
 /*
 ** Local functions
 */
-static void calc(double *tau, double *calculated_sys_mtbf, double *calculated_app_mtbf, 
-	double *calculated_fpi, int num_bundles,
-	int num_redundant, double node_mtbf, double checkpoint_time);
 static void usage(int argc, char *argv[]);
 static void banner(int argc, char *argv[], int num_bundles, int num_redundant, double checkpoint_time,
 		double restart_time, double work_time, double tau, int tau_given, double node_mtbf,
 		double calculated_sys_mtbf, int sys_mtbf_given, double calculated_app_mtbf, int app_mtbf_given,
 		int default_seed, rnd_t rnd, double scale, double shape, char *fname_interrupts, char *fname_faults, double ras_delay,
 		float soft_reboot_success_rate, float soft_time_to_reboot, FILE *fp_input,
-		char *fname_input, double calculated_fpi);
-
-
+		char *fname_input, double calculated_fpi, prediction_t *prediction);
+static int parse_sizes(char *spec, int max_size, int **sizes);
+static int make_offsets(double every, int num_random, double span, double work_time,
+		double **offsets);
+static void sweep_task(int task, void *arg, void *result);
+static void add_row(colfile_t *c, sweep_t *sw, int num_bundles, int num_redundant,
+		double offset, double tau, int status, result_t *r);
+static void make_key(cache_key_t *key, int kind, sweep_t *sw, int num_bundles, int num_redundant,
+		double offset, double tau, double sys_mtbf, double app_mtbf);
+static int sweep_key(sweep_t *sw, int i, cache_key_t *key);
+static int compare_ints(const void *pa, const void *pb);
+static int compare_doubles(const void *pa, const void *pb);
+
+
+/* Options of more than one word can be spelled with _ or - */
 static struct option long_options[]=   {
     /* name, has arg, flag, val */
     {"work_time", 1, NULL, 'w'},
+    {"work-time", 1, NULL, 'w'},
     {"num_bundles", 1, NULL, 'n'},
+    {"num-bundles", 1, NULL, 'n'},
     {"redundant", 1, NULL, 'r'},
     {"verbose", 0, NULL, 'v'},
     {"performance", 0, NULL, 'p'},
     {"distribution", 1, NULL, 1100},
     {"seed", 0, NULL, 's'},
     {"checkpoint_time", 1, NULL, 'c'},
+    {"checkpoint-time", 1, NULL, 'c'},
     {"restart_time", 1, NULL, 'R'},
+    {"restart-time", 1, NULL, 'R'},
     {"tau", 1, NULL, 't'},
     {"mtbf_node", 1, NULL, 'm'},
+    {"mtbf-node", 1, NULL, 'm'},
     {"mtbf_sys", 1, NULL, 1003},
+    {"mtbf-sys", 1, NULL, 1003},
     {"mtbf_app", 1, NULL, 'a'},
+    {"mtbf-app", 1, NULL, 'a'},
     {"delay_ras", 1, NULL, 'd'},
+    {"delay-ras", 1, NULL, 'd'},
     {"finterrupts", 1, NULL, 1000},
     {"ffaults", 1, NULL, 1001},
     {"soft_reboot", 1, NULL, 1002},
+    {"soft-reboot", 1, NULL, 1002},
     {"help", 0, NULL, 1004},
     {"input", 1, NULL, 1005},
     {"shape", 1, NULL, 1006},
     {"scale", 1, NULL, 1007},
     {"hotswap", 0, NULL, 1008},
+    {"sizes", 1, NULL, 1009},
+    {"jobs", 1, NULL, 1010},
+    {"offset_every", 1, NULL, 1011},
+    {"offset-every", 1, NULL, 1011},
+    {"offset_random", 1, NULL, 1012},
+    {"offset-random", 1, NULL, 1012},
+    {"binary_out", 0, NULL, 1013},
+    {"binary-out", 0, NULL, 1013},
+    {"write_thread", 0, NULL, 1014},
+    {"write-thread", 0, NULL, 1014},
+    {"format", 1, NULL, 1015},
+    {"columnar", 1, NULL, 1016},
+    {"events", 1, NULL, 1017},
+    {"events_last", 1, NULL, 1018},
+    {"events-last", 1, NULL, 1018},
+    {"events_every", 1, NULL, 1019},
+    {"events-every", 1, NULL, 1019},
+    {"max_walltime", 1, NULL, 1020},
+    {"max-walltime", 1, NULL, 1020},
+    {"max_mem", 1, NULL, 1021},
+    {"max-mem", 1, NULL, 1021},
+    {"time_budget", 1, NULL, 1022},
+    {"time-budget", 1, NULL, 1022},
+    {"progress", 1, NULL, 1023},
+    {"stats_shm", 1, NULL, 1024},
+    {"stats-shm", 1, NULL, 1024},
+    {"snapshot_every", 1, NULL, 1025},
+    {"snapshot-every", 1, NULL, 1025},
+    {"snapshot", 1, NULL, 1026},
+    {"resume", 1, NULL, 1027},
+    {"branch_at", 1, NULL, 1028},
+    {"branch-at", 1, NULL, 1028},
+    {"branch", 1, NULL, 1029},
+    {"serve", 1, NULL, 1030},
+    {"cache", 1, NULL, 1031},
+    {"sweep", 1, NULL, 1032},
+    {"shard", 1, NULL, 1033},
+    {"shard_file", 1, NULL, 1034},
+    {"shard-file", 1, NULL, 1034},
+    {"merge", 1, NULL, 1035},
     {0, 0, 0, 0}
 };
 
@@ -120,17 +230,72 @@ char *fname_input;
 FILE *fp_ints;
 FILE *fp_faults;
 FILE *fp_input;
+writer_t *w_ints;
+writer_t *w_faults;
+int binary_out;
+int write_thread;
+int out_format;
+char *fname_columnar;
+colfile_t *columnar;
+char *fname_events;
+long events_last;
+long events_every;
+double max_walltime;
+double max_mem;
+double time_budget;
+double progress_sec;
+char *stats_shm;
+double snapshot_every;
+char *fname_snapshot;
+char *fname_resume;
+double branch_at;
+int num_branches;
+branch_t *branches;
+char *serve_at;
+char *cache_dir;
+char *fname_sweep;
+char *fname_shard;
+char *merge_spec;
+int shard;
+int num_shards;
+char dummy;
+int use_cache;
+int cached;
+cache_key_t key;
+branch_result_t *branch_res;
+branch_point_t branch_point;
+double budget_work;
+prediction_t prediction;
+result_t result;
 double elapsed;
 double ras_delay;
 float soft_reboot_success_rate, soft_time_to_reboot;
 int display_perf_info;
 double t0, t1;
+am_ctx_t *ctx;
+am_config_t cfg;
+am_extra_t extra;
+am_results_t run_results;
 int tau_given;
+int soft_reboot;
 int app_mtbf_given, sys_mtbf_given;
 int help;
 double daly;
 double calculated_fpi;
 int hotswap;
+char *sizes_spec;
+int num_sizes;
+int max_jobs;
+double offset_every;
+int offset_random;
+int num_windows;
+int *status;
+sweep_t sweep;
+sweep_result_t *sweep_results;
+sweep_result_t *task_results;
+int *task_status;
+int num_tasks;
+int i, n;
 
 
 
@@ -154,6 +319,7 @@ int hotswap;
     dist_scale= DEFAULT_SCALE;
     ras_delay= DEFAULT_RAS_DELAY;
     soft_reboot_success_rate= -1.0;
+    soft_time_to_reboot= 0.0;
     display_perf_info= FALSE;
     calculated_sys_mtbf= -1.0;
     calculated_app_mtbf= -1.0;
@@ -161,6 +327,41 @@ int hotswap;
     app_mtbf_given= FALSE;
     hotswap= FALSE;
     help= FALSE;
+    sizes_spec= NULL;
+    num_sizes= 0;
+    max_jobs= default_jobs();
+    offset_every= -1.0;
+    offset_random= 0;
+    num_windows= 0;
+    sweep.sizes= NULL;
+    sweep.redundant= NULL;
+    sweep.offsets= NULL;
+    sweep.tasks= NULL;
+    binary_out= FALSE;
+    write_thread= FALSE;
+    out_format= FORMAT_TEXT;
+    fname_columnar= NULL;
+    fname_events= NULL;
+    events_last= 0;
+    events_every= 1;
+    max_walltime= -1.0;
+    max_mem= -1.0;
+    time_budget= -1.0;
+    progress_sec= -1.0;
+    stats_shm= NULL;
+    snapshot_every= -1.0;
+    fname_snapshot= "two_step.snapshot";
+    fname_resume= NULL;
+    branch_at= -1.0;
+    num_branches= 0;
+    branches= NULL;
+    serve_at= NULL;
+    fname_sweep= NULL;
+    fname_shard= NULL;
+    merge_spec= NULL;
+    shard= 0;
+    num_shards= 0;
+    cache_dir= NULL;
 
 
     /* check command line args */
@@ -177,7 +378,6 @@ int hotswap;
 		    fprintf(stderr, "Invalid number for -mtbf_app %s\n", optarg);
 		    error= TRUE;
 		}
-		calculated_app_mtbf= calculated_app_mtbf * 60.0;
 		app_mtbf_given= TRUE;
 		break;
 	    case 'n':
@@ -284,7 +484,6 @@ int hotswap;
 		    fprintf(stderr, "Invalid number for -mtbf_sys %s\n", optarg);
 		    error= TRUE;
 		}
-		calculated_sys_mtbf= calculated_sys_mtbf * 60.0;
 		sys_mtbf_given= TRUE;
 		break;
 	    case 1004:
@@ -310,6 +509,148 @@ int hotswap;
 	    case 1008:
 		hotswap= TRUE;
 		break;
+	    case 1009:
+		sizes_spec= optarg;
+		break;
+	    case 1010:
+		max_jobs= strtol(optarg, (char **)NULL, 0);
+		if (max_jobs < 1)   {
+		    fprintf(stderr, "--jobs %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1011:
+		offset_every= strtod(optarg, &endptr);
+		if ((offset_every <= 0.0) || (endptr == optarg))   {
+		    fprintf(stderr, "--offset_every %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1012:
+		offset_random= strtol(optarg, (char **)NULL, 0);
+		if (offset_random < 1)   {
+		    fprintf(stderr, "--offset_random %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1013:
+		binary_out= TRUE;
+		break;
+	    case 1014:
+		write_thread= TRUE;
+		break;
+	    case 1015:
+		out_format= record_parse_format(optarg);
+		if (out_format < 0)   {
+		    fprintf(stderr, "Unknown --format \"%s\". Must be text, json, or csv\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1016:
+		fname_columnar= optarg;
+		break;
+	    case 1017:
+		fname_events= optarg;
+		break;
+	    case 1018:
+		events_last= strtol(optarg, (char **)NULL, 0);
+		if (events_last < 1)   {
+		    fprintf(stderr, "--events_last %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1019:
+		events_every= strtol(optarg, (char **)NULL, 0);
+		if (events_every < 1)   {
+		    fprintf(stderr, "--events_every %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1020:
+		max_walltime= strtod(optarg, (char **)NULL);
+		if (max_walltime <= 0.0)   {
+		    fprintf(stderr, "--max_walltime %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1021:
+		max_mem= strtod(optarg, (char **)NULL);
+		if (max_mem <= 0.0)   {
+		    fprintf(stderr, "--max_mem %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1022:
+		time_budget= strtod(optarg, (char **)NULL);
+		if (time_budget <= 0.0)   {
+		    fprintf(stderr, "--time_budget %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1023:
+		progress_sec= strtod(optarg, (char **)NULL);
+		if (progress_sec <= 0.0)   {
+		    fprintf(stderr, "--progress %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1024:
+		stats_shm= optarg;
+		break;
+	    case 1025:
+		snapshot_every= strtod(optarg, (char **)NULL);
+		if (snapshot_every <= 0.0)   {
+		    fprintf(stderr, "--snapshot_every %s must be > 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1026:
+		fname_snapshot= optarg;
+		break;
+	    case 1027:
+		fname_resume= optarg;
+		break;
+	    case 1028:
+		branch_at= strtod(optarg, &endptr);
+		if ((branch_at < 0.0) || (endptr == optarg))   {
+		    fprintf(stderr, "--branch_at %s must be >= 0\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1029:
+		branches= (branch_t *)realloc(branches, (num_branches + 1) * sizeof(branch_t));
+		if (branches == NULL)   {
+		    fprintf(stderr, "Out of memory!\n");
+		    exit(10);
+		}
+		if (!branch_parse(optarg, &branches[num_branches]))   {
+		    fprintf(stderr, "Invalid --branch \"%s\"\n", optarg);
+		    error= TRUE;
+		}
+		num_branches++;
+		break;
+	    case 1030:
+		serve_at= optarg;
+		break;
+	    case 1031:
+		cache_dir= optarg;
+		break;
+	    case 1032:
+		fname_sweep= optarg;
+		break;
+	    case 1033:
+		if ((sscanf(optarg, "%d/%d%c", &shard, &num_shards, &dummy) != 2) ||
+			(num_shards < 1) || (shard < 0) || (shard >= num_shards))   {
+		    fprintf(stderr, "Invalid --shard \"%s\". Use i/N with 0 <= i < N\n", optarg);
+		    error= TRUE;
+		}
+		break;
+	    case 1034:
+		fname_shard= optarg;
+		break;
+	    case 1035:
+		merge_spec= optarg;
+		break;
 	    default:
 		error= TRUE;
 		break;
@@ -321,11 +662,143 @@ int hotswap;
 	fprintf(stderr, "No additional arguments expected!\n");
     }
 
+    if (num_redundant > num_bundles)   {
+	fprintf(stderr, "-r %d must be <= -n %d\n", num_redundant, num_bundles);
+	error= TRUE;
+    }
+
+    if (sizes_spec)   {
+	num_sizes= parse_sizes(sizes_spec, num_bundles, &sweep.sizes);
+	if (num_sizes < 1)   {
+	    fprintf(stderr, "Invalid list of application sizes for --sizes: \"%s\"\n", sizes_spec);
+	    error= TRUE;
+	} else if ((strcmp(fname_input, "") == 0) ||
+		(strcmp(fname_interrupts, "") != 0) || (strcmp(fname_faults, "") != 0))   {
+	    fprintf(stderr, "--sizes needs --input, and cannot be used with --fi, or --ff\n");
+	    error= TRUE;
+	} else   {
+	    if (num_redundant > 0)   {
+		/* Each size has as many redundant nodes per active node as -r has per -n */
+		sweep.redundant= (int *)malloc(num_sizes * sizeof(int));
+		if (sweep.redundant == NULL)   {
+		    fprintf(stderr, "Out of memory!\n");
+		    exit(10);
+		}
+		for (i= 0; i < num_sizes; i++)   {
+		    sweep.redundant[i]= (long long)num_redundant * sweep.sizes[i] / num_bundles;
+		}
+		num_redundant= sweep.redundant[num_sizes - 1];
+	    }
+	    /* The banner shows the largest size */
+	    num_bundles= sweep.sizes[num_sizes - 1];
+	}
+    }
+
+    if ((offset_every > 0.0) || (offset_random > 0))   {
+	if ((offset_every > 0.0) && (offset_random > 0))   {
+	    fprintf(stderr, "Use either --offset_every or --offset_random, not both\n");
+	    error= TRUE;
+	} else if ((strcmp(fname_input, "") == 0) || (sizes_spec != NULL) ||
+		(strcmp(fname_interrupts, "") != 0) || (strcmp(fname_faults, "") != 0))   {
+	    fprintf(stderr, "--offset_every and --offset_random need --input, and cannot be used "
+		"with --sizes, --fi, or --ff\n");
+	    error= TRUE;
+	}
+    }
+
+    if ((fname_events != NULL) && ((sizes_spec != NULL) || (offset_every > 0.0) ||
+	    (offset_random > 0)))   {
+	fprintf(stderr, "--events cannot be used with --sizes or --offset_every/--offset_random\n");
+	error= TRUE;
+    }
+
+    if ((branch_at >= 0.0) || (num_branches > 0))   {
+	if ((branch_at < 0.0) || (num_branches < 1))   {
+	    fprintf(stderr, "--branch_at and --branch must be used together\n");
+	    error= TRUE;
+	} else if ((sizes_spec != NULL) || (offset_every > 0.0) || (offset_random > 0) ||
+		(strcmp(fname_interrupts, "") != 0) || (strcmp(fname_faults, "") != 0) ||
+		(fname_events != NULL))   {
+	    fprintf(stderr, "--branch cannot be used with --sizes, --offset_every/--offset_random, "
+		"--fi, --ff, or --events\n");
+	    error= TRUE;
+	}
+    }
+
+    if (strcmp(fname_input, "") != 0)   {
+	/* rMPI_trace() and read_next() replace the failed nodes; they never soft reboot them */
+	soft_reboot= soft_reboot_success_rate >= 0.0;
+	for (i= 0; i < num_branches; i++)   {
+	    if ((branches[i].set & BRANCH_SOFT_REBOOT) && (branches[i].soft_reboot_success_rate >= 0.0))   {
+		soft_reboot= TRUE;
+	    }
+	}
+	if (soft_reboot)   {
+	    fprintf(stderr, "--soft_reboot, and soft_reboot= in --branch, cannot be used with "
+		"--input\n");
+	    error= TRUE;
+	}
+    }
+
+    if (((num_shards > 0) || (fname_shard != NULL)) && (fname_sweep == NULL))   {
+	fprintf(stderr, "--shard and --shard_file need --sweep\n");
+	error= TRUE;
+    }
+    if ((fname_shard != NULL) && (num_shards < 1))   {
+	fprintf(stderr, "--shard_file needs --shard\n");
+	error= TRUE;
+    }
+    if (((serve_at != NULL) + (fname_sweep != NULL) + (merge_spec != NULL)) > 1)   {
+	fprintf(stderr, "Use only one of --serve, --sweep, and --merge\n");
+	error= TRUE;
+    }
+
     if (error || help)   {
 	usage(argc, argv);
 	exit(1);
     }
 
+    if (serve_at)   {
+	/* The options of each scenario come with the scenario */
+	return serve(serve_at, max_jobs, out_format);
+    }
+
+    if (fname_sweep)   {
+	/* As with --serve, the options are in the manifest */
+	return manifest_run(fname_sweep, shard, num_shards, fname_shard, max_jobs, out_format);
+    }
+
+    if (merge_spec)   {
+	return manifest_merge(merge_spec, out_format);
+    }
+
+    if (verbose > TRACE_LEVEL)   {
+	fprintf(stderr, "Warning: This binary only prints trace output up to -v level %d\n",
+	    TRACE_LEVEL);
+    }
+
+    /*
+    ** Without -s, each run has its own seed and would never be found again.
+    ** Runs that write files, or do not start from the beginning, or do not
+    ** end with a single result, are always simulated.
+    */
+    use_cache= FALSE;
+    if (cache_dir)   {
+	if (!default_seed)   {
+	    fprintf(stderr, "Warning: --cache needs -s. Not using the cache\n");
+	    cache_dir= NULL;
+	} else   {
+	    cache_open(cache_dir);
+	    use_cache= (strcmp(fname_input, "") == 0) && (strcmp(fname_interrupts, "") == 0) &&
+		(strcmp(fname_faults, "") == 0) && (fname_events == NULL) &&
+		(snapshot_every <= 0.0) && (fname_resume == NULL) && (num_branches == 0);
+	    if (!use_cache && (num_sizes == 0) && (offset_every <= 0.0) && (offset_random == 0))   {
+		fprintf(stderr, "Warning: --cache does not work with --input, --fi, --ff, --events, "
+		    "--snapshot_every, --resume, or --branch. Not using the cache\n");
+	    }
+	}
+    }
+
 
     /*
     ** Open files if necessary
@@ -358,53 +831,338 @@ int hotswap;
     }
 
 
+    columnar= fname_columnar ? colfile_open(fname_columnar) : NULL;
+
+
     if (strcmp(fname_input, "") == 0)   {
 	/* Default */
 	fp_input= NULL;
-    } else if (strcmp(fname_input, "-") == 0)   {
-	fp_input= stdin;
-    } else if (strcmp(fname_input, "") != 0)   {
-	fp_input= fopen(fname_input, "r");
-	if (fp_input == NULL)   {
-	    fprintf(stderr, "Could not open input file \"%s\": %s\n", fname_input, strerror(errno));
-	    exit(2);
-	}
+    } else   {
+	/* One or more files, merged by time */
+	fp_input= open_input(fname_input);
     }
 
 
-    /* Some sanity checks */
-    if (fp_input && (num_redundant > 0))   {
-	fprintf(stderr, "Redundant nodes not supported when reading faults from a file.\n");
-	exit(3);
+    /* The banner and the report go to stdout, as text or as records */
+    record_open(stdout, out_format);
+
+    /* The run itself is simulated by libapp_model, which takes the units of the options */
+    am_defaults(&cfg);
+    cfg.active_nodes= num_bundles;
+    cfg.redundant_nodes= num_redundant;
+    cfg.node_mtbf= node_mtbf;
+    cfg.sys_mtbf= calculated_sys_mtbf;
+    cfg.app_mtbf= calculated_app_mtbf;
+    cfg.work_time= work_time;
+    cfg.checkpoint_time= checkpoint_time;
+    cfg.restart_time= restart_time;
+    cfg.tau= tau;
+    cfg.ras_delay= ras_delay;
+    switch (rnd)   {
+	case RND_GAMMA:		cfg.distribution= AM_DIST_GAMMA; break;
+	case RND_WEIBULL:	cfg.distribution= AM_DIST_WEIBULL; break;
+	case RND_EXP:
+	default:		cfg.distribution= AM_DIST_EXP; break;
     }
-
+    cfg.shape= dist_shape;
+    cfg.scale= dist_scale;
+    cfg.soft_reboot_success= soft_reboot_success_rate;
+    cfg.soft_reboot_time= soft_time_to_reboot;
+    cfg.hotswap= hotswap;
+    cfg.seed= default_seed ? 0 : (unsigned long)time(NULL) + getpid();
+    cfg.time_budget= time_budget;
 
     /* Convert work time to minutes like everything else */
     work_time= 60.0 * work_time;
     node_mtbf= 60.0 * node_mtbf;
     dist_scale= 60.0 * dist_scale;
+    if (sys_mtbf_given)   {
+	calculated_sys_mtbf= 60.0 * calculated_sys_mtbf;
+    }
+    if (app_mtbf_given)   {
+	calculated_app_mtbf= 60.0 * calculated_app_mtbf;
+    }
 
     init_rnd(rnd, node_mtbf, default_seed, dist_shape, dist_scale);
     init_globals();
 
-    calc(&tau, &calculated_sys_mtbf, &calculated_app_mtbf, &calculated_fpi, num_bundles,
+    /* Each size in a --sizes run needs its own calculated values */
+    sweep.tau= tau;
+    sweep.sys_mtbf= calculated_sys_mtbf;
+    sweep.app_mtbf= calculated_app_mtbf;
+
+    predict_tau(&tau, &calculated_sys_mtbf, &calculated_app_mtbf, &calculated_fpi, num_bundles,
 		num_redundant, node_mtbf, checkpoint_time);
 
+    /*
+    ** Predict the cost of the run, and make sure it fits into the budget.
+    ** Without the MTBF of the nodes, we cannot do that for an input file.
+    */
+    if (fp_input)   {
+	if ((max_walltime > 0.0) || (max_mem > 0.0))   {
+	    fprintf(stderr, "Warning: --max_walltime and --max_mem are not checked with --input\n");
+	}
+    } else   {
+	predict(&prediction, num_bundles + num_redundant, work_time, tau, checkpoint_time,
+	    restart_time, calculated_sys_mtbf, calculated_app_mtbf, soft_reboot_success_rate >= 0.0);
+
+	if ((max_mem > 0.0) && (prediction.mem_kb > (max_mem * 1024.0)))   {
+	    fprintf(stderr, "ERROR: This run needs about %.0f MB of memory. --max_mem is %.0f MB\n",
+		prediction.mem_kb / 1024.0, max_mem);
+	    exit(12);
+	}
+
+	if ((max_walltime > 0.0) && (prediction.wall_sec > max_walltime))   {
+	    /*
+	    ** Do less work, if that is enough. Less than one checkpoint
+	    ** interval, or a tenth of the work, would not tell us much.
+	    */
+	    budget_work= predict_work_for(&prediction, work_time, max_walltime);
+	    if ((budget_work < tau) && (budget_work < (work_time / 10.0)))   {
+		fprintf(stderr, "ERROR: This run takes about %.3g seconds, %.3g of them for setup. "
+		    "--max_walltime is %g seconds\n", prediction.wall_sec, prediction.setup_sec,
+		    max_walltime);
+		exit(12);
+	    }
+	    fprintf(stderr, "Work reduced from %.2f to %.2f hours to fit into --max_walltime %g seconds\n",
+		work_time / 60.0, budget_work / 60.0, max_walltime);
+	    work_time= budget_work;
+	    cfg.work_time= work_time / 60.0;
+	    predict(&prediction, num_bundles + num_redundant, work_time, tau, checkpoint_time,
+		restart_time, calculated_sys_mtbf, calculated_app_mtbf,
+		soft_reboot_success_rate >= 0.0);
+	}
+    }
+
+    ctx= am_init();
+    if (ctx == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    if (am_configure(ctx, &cfg) != AM_OK)   {
+	fprintf(stderr, "%s\n", am_error(ctx));
+	usage(argc, argv);
+	exit(1);
+    }
+
     banner(argc, argv, num_bundles, num_redundant, checkpoint_time, restart_time, work_time,
 		tau, tau_given, node_mtbf, calculated_sys_mtbf, sys_mtbf_given, calculated_app_mtbf,
 		app_mtbf_given, default_seed, rnd, dist_scale, dist_shape, fname_interrupts,
 		fname_faults, ras_delay, soft_reboot_success_rate, soft_time_to_reboot, fp_input,
-		fname_input, calculated_fpi);
+		fname_input, calculated_fpi, fp_input ? NULL : &prediction);
+
+    /* The rows of a --columnar file need these too */
+    sweep.num_bundles= num_bundles;
+    sweep.num_redundant= num_redundant;
+    sweep.node_mtbf= node_mtbf;
+    sweep.checkpoint_time= checkpoint_time;
+    sweep.restart_time= restart_time;
+    sweep.work_time= work_time;
+    sweep.ras_delay= ras_delay;
+    sweep.soft_time_to_reboot= soft_time_to_reboot;
+    sweep.soft_reboot_success_rate= soft_reboot_success_rate;
+    sweep.hotswap= hotswap;
+    sweep.fp_input= fp_input;
+    sweep.verbose= verbose;
+    sweep.cfg= cfg;
+
+    if ((num_sizes > 0) || (offset_every > 0.0) || (offset_random > 0))   {
+	/*
+	** Read the input file once, then simulate all sizes, or all start
+	** offsets, in parallel. Each of them replays the faults on its nodes
+	** from memory.
+	*/
+
+	/* Each size or window is a record that starts with the banner */
+	record_keep();
+
+	if ((progress_sec > 0.0) || stats_shm)   {
+	    fprintf(stderr, "Warning: --progress and --stats_shm only report on single runs\n");
+	}
+	if ((snapshot_every > 0.0) || fname_resume)   {
+	    fprintf(stderr, "Warning: --snapshot_every and --resume only work with single runs\n");
+	}
+
+	t0= get_clock_value();
+	load_input(fp_input, num_bundles + num_redundant);
+	if (num_sizes == 0)   {
+	    num_windows= make_offsets(offset_every * 60.0, offset_random, input_span(), work_time,
+		&sweep.offsets);
+	    if (num_windows < 1)   {
+		fprintf(stderr, "ERROR: Input spans %.3f hours, less than the %.3f hours of work\n",
+		    input_span() / 60.0, work_time / 60.0);
+		exit(8);
+	    }
+	    num_sizes= num_windows;
+	}
+
+	sweep_results= (sweep_result_t *)malloc(num_sizes * sizeof(sweep_result_t));
+	status= (int *)malloc(num_sizes * sizeof(int));
+	task_results= (sweep_result_t *)malloc(num_sizes * sizeof(sweep_result_t));
+	task_status= (int *)malloc(num_sizes * sizeof(int));
+	sweep.tasks= (int *)malloc(num_sizes * sizeof(int));
+	if ((sweep_results == NULL) || (status == NULL) || (task_results == NULL) ||
+		(task_status == NULL) || (sweep.tasks == NULL))   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+
+	/* Only simulate what is not in the cache */
+	num_tasks= 0;
+	for (i= 0; i < num_sizes; i++)   {
+	    if (cache_dir && sweep_key(&sweep, i, &key) && cache_get(&key, &sweep_results[i].r))   {
+		sweep_results[i].tau= key.tau;
+		status[i]= 0;
+	    } else   {
+		sweep.tasks[num_tasks++]= i;
+	    }
+	}
+	if (cache_dir)   {
+	    fprintf(stderr, "Found %d of %d %s in the cache\n", num_sizes - num_tasks, num_sizes,
+		(num_windows > 0) ? "windows" : "sizes");
+	}
+
+	run_tasks(num_tasks, max_jobs, sweep_task, &sweep, task_results,
+	    sizeof(sweep_result_t), task_status);
+	for (i= 0; i < num_tasks; i++)   {
+	    n= sweep.tasks[i];
+	    sweep_results[n]= task_results[i];
+	    status[n]= task_status[i];
+	    if (cache_dir && (status[n] == 0) && !sweep_results[n].r.stopped_early &&
+		    sweep_key(&sweep, n, &key))   {
+		cache_put(&key, &sweep_results[n].r);
+	    }
+	}
+	t1= get_clock_value();
+
+	if (columnar)   {
+	    for (i= 0; i < num_sizes; i++)   {
+		add_row(columnar, &sweep, sweep.sizes ? sweep.sizes[i] : num_bundles,
+		    sweep.redundant ? sweep.redundant[i] : num_redundant,
+		    sweep.offsets ? sweep.offsets[i] : 0.0, sweep_results[i].tau, status[i],
+		    &sweep_results[i].r);
+	    }
+	    colfile_close(columnar);
+	}
+
+	if (num_windows > 0)   {
+	    report_windows(num_windows, sweep.offsets, sweep_results, status, work_time,
+		display_perf_info, t1 - t0);
+	} else   {
+	    report_scaling(num_sizes, sweep.sizes, sweep.redundant, sweep_results, status, work_time,
+		display_perf_info, t1 - t0);
+	}
+
+	free(sweep_results);
+	free(status);
+	free(task_results);
+	free(task_status);
+	free(sweep.tasks);
+	free(sweep.sizes);
+	free(sweep.redundant);
+	free(sweep.offsets);
+	am_free(ctx);
+	close_input();
+	record_close();
+	return 0;
+    }
 
-    rMPI_init(num_bundles, num_bundles + num_redundant, fp_input, verbose);
+    /*
+    ** A single run. The simulation is the one of libapp_model. The features
+    ** the library leaves out are set up here, around it: the --input file,
+    ** the --fi and --ff writers, --events, --snapshot_every and --resume,
+    ** --branch, --progress, and the --cache. am_run_with() hands the ones
+    ** that happen inside the run to the simulation.
+    */
+    perf_init(display_perf_info);
+    cached= FALSE;
+    if (use_cache)   {
+	make_key(&key, CACHE_RUN, &sweep, num_bundles, num_redundant, 0.0, tau, calculated_sys_mtbf,
+	    calculated_app_mtbf);
+	cached= cache_get(&key, &result);
+    }
+    if ((num_branches > 0) && fp_input)   {
+	/* The reader threads do not survive a fork. The branches replay from memory. */
+	load_input(fp_input, num_bundles + num_redundant);
+    }
+
+    w_ints= fp_ints ? writer_open(fp_ints, binary_out, write_thread) : NULL;
+    w_faults= fp_faults ? writer_open(fp_faults, binary_out, write_thread) : NULL;
+    if (fname_events)   {
+	events_open(fname_events, events_last, events_every);
+    }
 
     t0= get_clock_value();
-    elapsed= app_model(verbose, tau, checkpoint_time, restart_time, work_time, ras_delay,
-		fp_ints, fp_faults, soft_time_to_reboot, soft_reboot_success_rate, hotswap);
+    progress_start(progress_sec, stats_shm);
+    if (snapshot_every > 0.0)   {
+	app_snapshot(snapshot_every, fname_snapshot);
+    }
+    if (num_branches > 0)   {
+	branch_setup(branch_at * 60.0, num_branches, branches, max_jobs);
+    }
+    if (cached)   {
+	/* Saved as the run left them */
+	restore_results(&result);
+	elapsed= result.elapsed_time;
+    } else   {
+	memset(&extra, 0, sizeof(extra));
+	extra.fp_input= fp_input;
+	extra.w_ints= w_ints;
+	extra.w_faults= w_faults;
+	extra.fname_resume= fname_resume;
+	extra.verbose= verbose;
+	extra.timers= display_perf_info;
+	am_run_with(ctx, &extra);
+	am_results(ctx, &run_results);
+	elapsed= run_results.elapsed;
+	if (use_cache && !stopped_early)   {
+	    save_results(&result, elapsed);
+	    cache_put(&key, &result);
+	}
+    }
+    am_free(ctx);
+    progress_stop(elapsed, work_time);
+
+    /* Everything is written before the report, in case one of them is stdout */
+    writer_close(w_ints);
+    writer_close(w_faults);
+    events_close();
     t1= get_clock_value();
 
-    /* At this point we're one over */
-    interrupt_cnt--;
+    num_branches= branch_results(&branches, &branch_res, &status, &branch_point);
+    if (num_branches > 0)   {
+	/* Each branch finished the run on its own */
+	if (columnar)   {
+	    for (i= 0; i < num_branches; i++)   {
+		sweep.checkpoint_time= branch_res[i].params.checkpoint_time;
+		sweep.restart_time= branch_res[i].params.restart_time;
+		sweep.ras_delay= branch_res[i].params.ras_delay;
+		sweep.soft_time_to_reboot= branch_res[i].params.soft_time_to_reboot;
+		sweep.soft_reboot_success_rate= branch_res[i].params.soft_reboot_success_rate;
+		sweep.hotswap= branch_res[i].params.hotswap;
+		add_row(columnar, &sweep, num_bundles, num_redundant, 0.0, branch_res[i].params.tau,
+		    status[i],
+		    &branch_res[i].r);
+	    }
+	    colfile_close(columnar);
+	}
+	report_branches(num_branches, branches, branch_res, status, &branch_point, work_time,
+	    display_perf_info, t1 - t0);
+
+	end_input();
+	if (fp_input)	close_input();
+	record_close();
+	return 0;
+    } else if (branch_at >= 0.0)   {
+	fprintf(stderr, "Warning: The run ended before --branch_at %.2f hours. There are no "
+	    "branches\n", branch_at);
+    }
+
+    if (columnar)   {
+	save_results(&result, elapsed);
+	add_row(columnar, &sweep, num_bundles, num_redundant, 0.0, tau, 0, &result);
+	colfile_close(columnar);
+    }
 
     /*
     ** Without redundant nodes, the number of faults and interrupts must be the same.
@@ -424,7 +1182,9 @@ int hotswap;
 
     if (fp_ints)	fclose(fp_ints);
     if (fp_faults)	fclose(fp_faults);
-    if (fp_input)	fclose(fp_input);
+    end_input();
+    if (fp_input)	close_input();
+    record_close();
 
     return 0;
 
@@ -432,108 +1192,6 @@ int hotswap;
 
 
 
-#define pi      (3.14159265358979323846264338327950288)
-static double
-Qm2(int n)
-{
-    return sqrt(pi * n / 2.0) + (2.0/3.0);
-}  /* end of Qm2() */
-
-
-
-static void
-calc(double *tau, double *calculated_sys_mtbf, double *calculated_app_mtbf,
-	double *calculated_fpi, int num_bundles,
-	int num_redundant, double node_mtbf, double checkpoint_time)
-{
-
-#define pi	(3.14159265358979323846264338327950288)
-float p;
-float r_none, r_double;
-
-
-    /*
-    ** Calculate the system and application MTBI. We use it to calculate the
-    ** optimal checkpoint interval (tau) using Daly's equation.
-    */
-
-    /* Percentage of redundant nodes */
-    p= (float)num_redundant / (float)num_bundles;
-
-    if (*calculated_sys_mtbf < 0.0)   {
-	/* Not provided by user */
-	*calculated_sys_mtbf= node_mtbf / (num_bundles * (1.0 + p));
-    }
-
-
-    /* Calculate the MTBF of the non-redundant portion of the system */
-    if (num_redundant >= num_bundles)   {
-	/* Each bundle has redundant nodes */
-	r_none= 0.0;
-    } else   {
-	/* Some bundles do not have redundant nodes */
-	r_none= node_mtbf / (num_bundles - num_redundant);
-    }
-
-    /* Calculate the MTBF for the bundles with 2 redundant nodes */
-    if (num_redundant > 0)   {
-	r_double= (node_mtbf / (2.0 * num_redundant)) * Qm2(2.0 * num_redundant);
-    } else   {
-	/* no bundles with redundant ndoes */
-	r_double= 0.0;
-    }
-
-    if (*calculated_app_mtbf < 0.0)   {
-	/* Unless supplied by user */
-	if (num_redundant >= num_bundles)   {
-	    /* All bundles have redundant nodes */
-	    *calculated_app_mtbf= r_double;
-	} else if (num_redundant > 0)   {
-	    /* Only some bundles have redundant nodes */
-	    /* FIXME: This calculation is wrong, I think. */
-	    *calculated_app_mtbf= 1.0 / ((1.0 / r_none) + (1.0 / r_double));
-	} else   {
-	    /* No bundles have redundant nodes */
-	    *calculated_app_mtbf= r_none;
-	}
-    }
-
-
-
-    /*
-    ** calculate optimal checkpoint interval (tau) using Daly's equation,
-    ** unless the user supplied a specific tau.
-    */
-    if (*tau < 0.0)   {
-	if (checkpoint_time >= (2.0 * *calculated_app_mtbf))   {
-	    *tau= *calculated_app_mtbf;
-	} else   {
-	    *tau= sqrt(2.0 * checkpoint_time * *calculated_app_mtbf) *
-		(1.0 + 
-		 (1.0 / 3.0) * sqrt(checkpoint_time / (2.0 * *calculated_app_mtbf)) +
-		 (checkpoint_time / (9.0 * 2.0 * *calculated_app_mtbf))
-		) - checkpoint_time;
-	}
-
-	if (*tau < 0.0)   {
-	    printf("   ERROR: tau (checkpoint time) is negative!\n");
-	    exit(4);
-	}
-    }
-
-    if (num_bundles == num_redundant)   {
-	*calculated_fpi= Qm2(2.0 * num_bundles);
-    } else if (num_redundant == 0)   {
-	*calculated_fpi= 1.0;
-    } else   {
-	/* FIXME: Don't know how to do that yet */
-	*calculated_fpi= -3.0;
-    }
-
-}  /* end of calc() */
-
-
-
 static void
 usage(int argc, char *argv[])
 {
@@ -554,7 +1212,14 @@ int i;
 	"[-w work] [-t tau] [-m mtbf]\n"
 	"\t\t[-d delay] [--fi fi_name] [--ff ff_name] [--input ff_input]\n"
 	"\t\t[-v {-v}] [-p] [-s] [--distrib dist] [--scale a] [--shape b] [--soft_reboot <success rate>,<reboot time>]\n"
-	"\t\t[--mtbf_sys mtbf_sys] [-a mtbi_app] [--daly] [--help]\n", argv[0]);
+	"\t\t[--mtbf_sys mtbf_sys] [-a mtbi_app] [--daly] [--sizes list] [--jobs num]\n"
+	"\t\t[--offset_every hours | --offset_random num] [--binary_out] [--write_thread]\n"
+	"\t\t[--format fmt] [--columnar file] [--events file [--events_last n] [--events_every k]]\n"
+	"\t\t[--max_walltime seconds] [--max_mem MB] [--time_budget seconds] [--progress seconds]\n"
+	"\t\t[--stats_shm name] [--snapshot_every seconds] [--snapshot file] [--resume file]\n"
+	"\t\t[--branch_at hours --branch spec {--branch spec}] [--cache dir]\n"
+	"\t\t[--serve socket | --sweep manifest [--shard i/N [--shard_file file]] | --merge files]\n"
+	"\t\t[--help]\n", argv[0]);
 
     fprintf(stderr, "    -n num                       Number of bundles (active nodes) to simulate. (Default %d)\n",
 	DEFAULT_NUM_BUNDLES);
@@ -575,7 +1240,31 @@ int i;
 	DEFAULT_RAS_DELAY);
     fprintf(stderr, "    --fi fi_name                 File name to write restart (interrupt) times. (Default /dev/null)\n");
     fprintf(stderr, "    --ff ff_name                 File name to write fault times. (Default /dev/null)\n");
+    fprintf(stderr, "    --binary_out                 Write --fi and --ff files as binary records instead of text\n");
+    fprintf(stderr, "    --write_thread               Write --fi and --ff files from a separate thread\n");
+    fprintf(stderr, "    --format fmt                 Print the parameters and results as text (default), json, or csv\n");
+    fprintf(stderr, "    --columnar file              Also write the results to a columnar binary file. See col2csv\n");
+    fprintf(stderr, "    --events file                Write a binary log of the application phases. See ev2chrome\n");
+    fprintf(stderr, "    --events_last n              Only keep the last n events in the log\n");
+    fprintf(stderr, "    --events_every k             Only keep every k'th event in the log\n");
+    fprintf(stderr, "    --max_walltime seconds       Do less work, or refuse the run, if it would take longer\n");
+    fprintf(stderr, "    --max_mem MB                 Refuse the run, if it would need more memory\n");
+    fprintf(stderr, "    --time_budget seconds        Stop the simulation after this long and extrapolate\n");
+    fprintf(stderr, "    --progress seconds           Print a progress line to stderr this often\n");
+    fprintf(stderr, "    --stats_shm name             Publish progress in shared memory. See app_stat\n");
+    fprintf(stderr, "    --snapshot_every seconds     Save the state of the simulation this often\n");
+    fprintf(stderr, "    --snapshot file              Where to save it. Default two_step.snapshot\n");
+    fprintf(stderr, "    --resume file                Continue from a snapshot. Give the same options\n");
+    fprintf(stderr, "    --branch_at hours            Fork the run into --branch variants at this elapsed time\n");
+    fprintf(stderr, "    --branch spec                Finish the run with other parameters; e.g., tau=60,soft_reboot=50:10\n");
+    fprintf(stderr, "    --serve socket               Run the scenarios read from a UNIX socket, or - for stdin\n");
+    fprintf(stderr, "    --cache dir                  Keep results in dir, and do not simulate them again. Needs -s\n");
+    fprintf(stderr, "    --sweep manifest             Run replicas of each configuration in a manifest file\n");
+    fprintf(stderr, "    --shard i/N                  Only run shard i of N of the --sweep, and save the results\n");
+    fprintf(stderr, "    --shard_file file            Where to save them. Default <manifest>.<i>-of-<N>\n");
+    fprintf(stderr, "    --merge files                Report the sweep of these shard files. Comma separated, patterns ok\n");
     fprintf(stderr, "    --input ff_input             File name to read fault times from. Prevents fault generation by sim.\n");
+    fprintf(stderr, "                                 A comma separated list of files or patterns is merged by time.\n");
     fprintf(stderr, "    --distrib dist               Random distribution function: exp (default), gamma, weibull\n");
     fprintf(stderr, "    --scale a        (hours)     Scale parameter for Weibull and gamma distribution. (Default %.3f)\n", (float)DEFAULT_SCALE);
     fprintf(stderr, "    --shape b                    Shape parameter for Weibull and gamma distribution. (Default %.3f)\n", DEFAULT_SHAPE);
@@ -584,7 +1273,13 @@ int i;
     fprintf(stderr, "    --soft_reboot success rate,  Percentage of nodes that can be brought back to life doing a reboot (0 - 1.0)\n");
     fprintf(stderr, "                  reboot time    Nodes become available again after this many minutes\n");
     fprintf(stderr, "    -p                           Display simulation performance data\n");
+    fprintf(stderr, "    --sizes list                 Simulate these comma separated application sizes, or pow2, with --input\n");
+    fprintf(stderr, "                                 Each size replays the loaded input; -r scales with the size\n");
+    fprintf(stderr, "    --jobs num                   Simulate this many sizes or windows at the same time. (Default # of CPUs)\n");
+    fprintf(stderr, "    --offset_every hours         Replay --input starting every this many hours into the input\n");
+    fprintf(stderr, "    --offset_random num          Replay --input starting at num random offsets into the input\n");
     fprintf(stderr, "    --help                       This message\n");
+    fprintf(stderr, "    Long options of more than one word can be spelled with _ or -; e.g., --time-budget\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "app_model, version %s - a program that mimics a parallel\n", VERSION);
@@ -631,13 +1326,121 @@ banner(
     float soft_time_to_reboot,
     FILE *fp_input,
     char *fname_input,
-    double calculated_fpi)
+    double calculated_fpi,
+    prediction_t *prediction)
 {
 
 int i;
 char str[1024];
 
 
+    if (record_active())   {
+	/*
+	** The record of this run starts here and report_results() finishes it.
+	** Values that do not apply, or cannot be calculated, are null.
+	*/
+	record_begin();
+	record_string("version", VERSION);
+	str[0]= '\0';
+	for (i= 0; i < argc; i++)   {
+	    strncat(str, argv[i], sizeof(str) - strlen(str) - 2);
+	    if (i < (argc - 1))   {
+		strcat(str, " ");
+	    }
+	}
+	record_string("command_line", str);
+
+	record_section("parameters");
+	record_int("active_nodes", num_bundles);
+	record_int("redundant_nodes", num_redundant);
+	record_int("total_nodes", num_bundles + num_redundant);
+	record_double("checkpoint_min", checkpoint_time);
+	record_double("restart_min", restart_time);
+	record_double("work_min", work_time);
+	if (fp_input)   {
+	    record_null("node_mtbf_min");
+	} else   {
+	    record_double("node_mtbf_min", node_mtbf);
+	}
+	record_string("file_interrupts", fname_interrupts);
+	record_string("file_faults", fname_faults);
+	record_string("file_input", fp_input ? fname_input : "");
+	record_string("seed", default_seed ? "fixed" : "random");
+	if (fp_input)   {
+	    record_string("distribution", "input");
+	    record_null("scale_min");
+	    record_null("shape");
+	} else   {
+	    switch (rnd)   {
+		case RND_EXP:
+		    record_string("distribution", "exponential");
+		    record_null("scale_min");
+		    record_null("shape");
+		    break;
+		case RND_GAMMA:
+		    record_string("distribution", "gamma");
+		    record_double("scale_min", scale);
+		    record_double("shape", shape);
+		    break;
+		case RND_WEIBULL:
+		    if ((1.0 + 1.0 / shape) > GSL_SF_GAMMA_XMAX)   {
+			fprintf(stderr, "Shape parameter %g is too large for gamma function!\n",
+			    shape);
+			exit(1);
+		    }
+		    record_string("distribution", "weibull");
+		    record_double("scale_min", scale);
+		    record_double("shape", shape);
+		    break;
+		default:
+		    fprintf(stderr, "Unknown random distribution!\n");
+		    exit(1);
+		    break;
+	    }
+	}
+	record_double("ras_delay_min", ras_delay);
+	if (soft_reboot_success_rate < 0.0)   {
+	    record_null("soft_reboot_min");
+	    record_null("soft_reboot_success_rate");
+	} else   {
+	    record_double("soft_reboot_min", soft_time_to_reboot);
+	    record_double("soft_reboot_success_rate", soft_reboot_success_rate);
+	}
+
+	/* Values given on the command line are reported here as well */
+	record_section("calculated");
+	if (fp_input && !sys_mtbf_given)   {
+	    record_null("sys_mtbf_min");
+	} else   {
+	    record_double("sys_mtbf_min", calculated_sys_mtbf);
+	}
+	if (fp_input && !app_mtbf_given)   {
+	    record_null("app_mtbi_min");
+	} else   {
+	    record_double("app_mtbi_min", calculated_app_mtbf);
+	}
+	record_double("checkpoint_interval_min", tau);
+	if ((num_bundles == num_redundant) || (num_redundant == 0))   {
+	    record_double("faults_per_interrupt", calculated_fpi);
+	} else   {
+	    record_null("faults_per_interrupt");
+	}
+	if (prediction)   {
+	    record_double("expected_interrupts", prediction->interrupts);
+	    record_double("expected_faults", prediction->faults);
+	    record_double("predicted_random_draws", prediction->draws);
+	    record_double("predicted_wall_sec", prediction->wall_sec);
+	    record_double("predicted_mem_mb", prediction->mem_kb / 1024.0);
+	} else   {
+	    record_null("expected_interrupts");
+	    record_null("expected_faults");
+	    record_null("predicted_random_draws");
+	    record_null("predicted_wall_sec");
+	    record_null("predicted_mem_mb");
+	}
+	return;
+    }
+
     printf("Version %s\n", VERSION);
     printf("Command line \"");
     for (i= 0; i < argc; i++)   {
@@ -755,6 +1558,15 @@ char str[1024];
 	sprintf(str, "1...???");
 	printf("  Faults/interrupt       %12s\n", str);
     }
+    if (prediction)   {
+	printf("  Expected interrupts    %12.0f\n", prediction->interrupts);
+	printf("  Expected faults        %12.0f\n", prediction->faults);
+	printf("  Predicted random draws %12.0f\n", prediction->draws);
+	printf("  Predicted wall time    %12.2f seconds\n", prediction->wall_sec);
+	printf("  Predicted peak memory  %12.2f MB\n", prediction->mem_kb / 1024.0);
+    } else   {
+	printf("  Cannot predict the cost of this run\n");
+    }
 
 
     if ((restart_time + checkpoint_time) > calculated_sys_mtbf)   {
@@ -771,3 +1583,295 @@ char str[1024];
 
 
 }  /* end of banner() */
+
+
+
+/*
+** Parse a comma separated list of application sizes, or "pow2" for all
+** powers of two up to max_size. The sizes are returned in ascending order.
+** Returns the number of sizes, or 0 if the list is invalid.
+*/
+static int
+parse_sizes(char *spec, int max_size, int **sizes)
+{
+
+int num;
+int n;
+char *pos;
+char *endptr;
+
+
+    /* Enough room for either form */
+    *sizes= (int *)malloc((strlen(spec) + 32) * sizeof(int));
+    if (*sizes == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    num= 0;
+    if (strcmp(spec, "pow2") == 0)   {
+	for (n= 1; (n > 0) && (n <= max_size); n= n * 2)   {
+	    (*sizes)[num++]= n;
+	}
+	return num;
+    }
+
+    pos= spec;
+    while (*pos)   {
+	n= strtol(pos, &endptr, 0);
+	if ((endptr == pos) || (n < 1) || ((*endptr != ',') && (*endptr != '\0')))   {
+	    return 0;
+	}
+	(*sizes)[num++]= n;
+	pos= (*endptr == ',') ? endptr + 1 : endptr;
+    }
+    qsort(*sizes, num, sizeof(int), compare_ints);
+
+    return num;
+
+}  /* end of parse_sizes() */
+
+
+
+/*
+** Start offsets for a window run, in minutes after the first line of
+** the input. Either every "every" minutes, starting at 0, or num_random
+** uniformly distributed ones. Each window must fit the work into the
+** input. Returns the number of offsets.
+*/
+static int
+make_offsets(double every, int num_random, double span, double work_time, double **offsets)
+{
+
+int num;
+int i;
+
+
+    if (span < work_time)   {
+	*offsets= NULL;
+	return 0;
+    }
+
+    if (every > 0.0)   {
+	num= (int)((span - work_time) / every) + 1;
+    } else   {
+	num= num_random;
+    }
+
+    *offsets= (double *)malloc(num * sizeof(double));
+    if (*offsets == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    for (i= 0; i < num; i++)   {
+	if (every > 0.0)   {
+	    (*offsets)[i]= i * every;
+	} else   {
+	    (*offsets)[i]= rnd_probability() * (span - work_time);
+	}
+    }
+    qsort(*offsets, num, sizeof(double), compare_doubles);
+
+    return num;
+
+}  /* end of make_offsets() */
+
+
+
+/*
+** Simulate one application size of a --sizes run, or one start offset
+** of a window run. This runs in a child process with a fresh copy of the
+** global state.
+*/
+static void
+sweep_task(int task, void *arg, void *result)
+{
+
+sweep_t *sw= arg;
+sweep_result_t *res= result;
+am_config_t cfg;
+am_extra_t extra;
+am_results_t r;
+am_ctx_t *ctx;
+int i;
+
+
+    i= sw->tasks[task];
+    cfg= sw->cfg;
+    if (sw->sizes)   {
+	cfg.active_nodes= sw->sizes[i];
+    }
+    cfg.redundant_nodes= sw->redundant ? sw->redundant[i] : sw->num_redundant;
+    if (sw->offsets)   {
+	set_replay_offset(sw->offsets[i]);
+    }
+
+    ctx= am_init();
+    if (ctx == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    if (am_configure(ctx, &cfg) != AM_OK)   {
+	/* main() checked the largest size */
+	sim_error(1, "%s\n", am_error(ctx));
+    }
+    memset(&extra, 0, sizeof(extra));
+    extra.fp_input= sw->fp_input;
+    extra.verbose= sw->verbose;
+    am_run_with(ctx, &extra);
+    am_results(ctx, &r);
+    am_free(ctx);
+
+    res->tau= r.tau;
+    save_results(&res->r, r.elapsed);
+
+}  /* end of sweep_task() */
+
+
+
+static int
+compare_ints(const void *pa, const void *pb)
+{
+
+const int *a= pa;
+const int *b= pb;
+
+
+    return (*a > *b) - (*a < *b);
+
+}  /* end of compare_ints() */
+
+
+
+static int
+compare_doubles(const void *pa, const void *pb)
+{
+
+const double *a= pa;
+const double *b= pb;
+
+
+    return (*a > *b) - (*a < *b);
+
+}  /* end of compare_doubles() */
+
+
+
+/*
+** Add the row of one run, or of one size or window, to a --columnar file
+*/
+static void
+add_row(colfile_t *c, sweep_t *sw, int num_bundles, int num_redundant, double offset,
+	double tau, int status, result_t *r)
+{
+
+colfile_row_t row;
+
+
+    memset(&row, 0, sizeof(row));
+    row.active_nodes= num_bundles;
+    row.redundant_nodes= num_redundant;
+    row.offset= offset;
+    row.tau= tau;
+    row.checkpoint_time= sw->checkpoint_time;
+    row.restart_time= sw->restart_time;
+    row.work_time= sw->work_time;
+    row.node_mtbf= sw->fp_input ? NAN : sw->node_mtbf;
+    row.ras_delay= sw->ras_delay;
+    if (sw->soft_reboot_success_rate < 0.0)   {
+	row.soft_time_to_reboot= NAN;
+	row.soft_reboot_success_rate= NAN;
+    } else   {
+	row.soft_time_to_reboot= sw->soft_time_to_reboot;
+	row.soft_reboot_success_rate= sw->soft_reboot_success_rate;
+    }
+    row.status= status;
+    if (status == 0)   {
+	row.r= *r;
+	row.restart= r->total_restart_time + r->wasted_restart_time;
+	row.rework= r->total_rework_time + r->wasted_rework_time;
+	row.work= r->total_work_time + r->wasted_work_time;
+	row.checkpoint= r->total_checkpoint_time + r->wasted_checkpoint_time;
+    } else   {
+	row.tau= NAN;
+    }
+
+    colfile_row(c, &row);
+
+}  /* end of add_row() */
+
+
+
+/*
+** The --cache key of a run with these resolved parameters, starting from
+** the random number generator as it is now
+*/
+static void
+make_key(cache_key_t *key, int kind, sweep_t *sw, int num_bundles, int num_redundant,
+	double offset, double tau, double sys_mtbf, double app_mtbf)
+{
+
+    memset(key, 0, sizeof(cache_key_t));
+    strncpy(key->version, VERSION, sizeof(key->version) - 1);
+    key->kind= kind;
+    key->num_bundles= num_bundles;
+    key->num_redundant= num_redundant;
+    key->hotswap= sw->hotswap;
+    key->tau= tau;
+    key->sys_mtbf= sys_mtbf;
+    key->app_mtbf= app_mtbf;
+    key->checkpoint_time= sw->checkpoint_time;
+    key->restart_time= sw->restart_time;
+    key->work_time= sw->work_time;
+    key->ras_delay= sw->ras_delay;
+    if (sw->soft_reboot_success_rate >= 0.0)   {
+	key->soft_time_to_reboot= sw->soft_time_to_reboot;
+	key->soft_reboot_success_rate= sw->soft_reboot_success_rate;
+    } else   {
+	key->soft_reboot_success_rate= -1.0;
+    }
+    key->offset= offset;
+    key->rnd= rnd_hash();
+    key->input= input_hash(num_bundles + num_redundant);
+
+}  /* end of make_key() */
+
+
+
+/*
+** The key of size or window i of a sweep, with the values sweep_task()
+** calculates for it. Returns FALSE, if that fails; the task reports why.
+*/
+static int
+sweep_key(sweep_t *sw, int i, cache_key_t *key)
+{
+
+jmp_buf env;
+double tau;
+double sys_mtbf;
+double app_mtbf;
+double fpi;
+int num_bundles;
+int num_redundant;
+
+
+    num_bundles= sw->sizes ? sw->sizes[i] : sw->num_bundles;
+    num_redundant= sw->redundant ? sw->redundant[i] : sw->num_redundant;
+    tau= sw->tau;
+    sys_mtbf= sw->sys_mtbf;
+    app_mtbf= sw->app_mtbf;
+
+    sim_jmp= &env;
+    if (setjmp(env) != 0)   {
+	sim_jmp= NULL;
+	return FALSE;
+    }
+    predict_tau(&tau, &sys_mtbf, &app_mtbf, &fpi, num_bundles, num_redundant, sw->node_mtbf,
+	sw->checkpoint_time);
+    sim_jmp= NULL;
+
+    make_key(key, CACHE_POINT, sw, num_bundles, num_redundant, sw->offsets ? sw->offsets[i] : 0.0,
+	tau, sys_mtbf, app_mtbf);
+    return TRUE;
+
+}  /* end of sweep_key() */
@@ -0,0 +1,880 @@
+/*
+** $Id$
+**
+** Manifest sweeps. See manifest.h.
+**
+** Each replica is a task of tasks.c that runs the configuration through
+** libapp_model in a child process. A run without --shard keeps all
+** results in memory and reports them. A shard writes its results to a
+** file instead, and --merge reads the files of all shards back into the
+** same table. The statistics are calculated from that table in task
+** order, so they are the same, to the last bit, either way.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <glob.h>
+
+#include "globals.h"
+#include "tasks.h"
+#include "record.h"
+#include "cache.h"
+#include "libapp_model.h"
+#include "serve.h"
+#include "manifest.h"
+#include "stats.h"
+
+
+typedef struct config_t   {
+    char *line;			/* As written, for the report */
+    am_config_t cfg;		/* seed is 0 for -s */
+    int replicas;
+    int first_task;
+} config_t;
+
+typedef struct manifest_t   {
+    char *name;
+    char *text;
+    uint32_t text_size;
+    unsigned long seed;
+    int num_configs;
+    config_t *configs;
+    int num_tasks;
+} manifest_t;
+
+/* What a task sends back, and what a shard file stores */
+typedef struct manifest_result_t   {
+    int32_t task;
+    int32_t rc;			/* 0, or the exit code two_step would have ended with */
+    am_results_t r;
+} manifest_result_t;
+
+/* What manifest_task() needs to know */
+typedef struct task_arg_t   {
+    manifest_t *m;
+    int *tasks;			/* Task number of run_tasks() -> task of the sweep */
+} task_arg_t;
+
+
+/* Local functions */
+static void load_manifest(manifest_t *m, char *fname);
+static void parse_manifest(manifest_t *m, char *name, char *text, uint32_t size);
+static void manifest_error(manifest_t *m, int line_num, const char *msg);
+static int task_config(manifest_t *m, int task);
+static unsigned long task_seed(manifest_t *m, int config, int replica);
+static void manifest_task(int task, void *arg, void *result);
+static int write_shard(char *fname, manifest_t *m, int shard, int num_shards,
+		manifest_result_t *results, int num_results);
+static void read_shard(char *fname, manifest_t *m, int *num_shards, char **shard_seen,
+		manifest_result_t **all, char **have);
+static void report(manifest_t *m, manifest_result_t *all);
+static void *xmalloc(size_t size);
+
+
+
+/*
+** Run the manifest in fname. With num_shards > 0, only run shard number
+** "shard" of them, and write the results to shard_file, or to
+** <fname>.<shard>-of-<num_shards>, if it is NULL. Returns the exit code.
+*/
+int
+manifest_run(char *fname, int shard, int num_shards, char *shard_file, int max_jobs,
+	int format)
+{
+
+manifest_t m;
+task_arg_t arg;
+manifest_result_t *results;
+manifest_result_t *all;
+int *status;
+int num;
+int t, i;
+char *out;
+int rc;
+
+
+    load_manifest(&m, fname);
+
+    arg.m= &m;
+    arg.tasks= (int *)xmalloc((m.num_tasks + 1) * sizeof(int));
+    num= 0;
+    for (t= 0; t < m.num_tasks; t++)   {
+	if ((num_shards < 1) || ((t % num_shards) == shard))   {
+	    arg.tasks[num++]= t;
+	}
+    }
+
+    results= (manifest_result_t *)xmalloc((num + 1) * sizeof(manifest_result_t));
+    status= (int *)xmalloc((num + 1) * sizeof(int));
+    run_tasks(num, max_jobs, manifest_task, &arg, results, sizeof(manifest_result_t), status);
+    for (i= 0; i < num; i++)   {
+	if (status[i] != 0)   {
+	    /* The child did not get to send its results */
+	    results[i].task= arg.tasks[i];
+	    results[i].rc= status[i];
+	}
+    }
+
+    if (num_shards > 0)   {
+	if (shard_file)   {
+	    out= shard_file;
+	} else   {
+	    out= (char *)xmalloc(strlen(fname) + 32);
+	    sprintf(out, "%s.%d-of-%d", fname, shard, num_shards);
+	}
+	rc= write_shard(out, &m, shard, num_shards, results, num) ? 0 : 2;
+	if (rc == 0)   {
+	    fprintf(stderr, "Shard %d of %d: %d of %d runs written to \"%s\"\n", shard,
+		num_shards, num, m.num_tasks, out);
+	}
+    } else   {
+	/* Every task ran, in order */
+	all= results;
+	record_open(stdout, format);
+	report(&m, all);
+	record_close();
+	rc= 0;
+    }
+
+    free(results);
+    free(status);
+    free(arg.tasks);
+    return rc;
+
+}  /* end of manifest_run() */
+
+
+
+/*
+** Read the shard files in spec, a comma separated list of file names and
+** glob patterns, and report the sweep they are from. All shards must be
+** there. Returns the exit code.
+*/
+int
+manifest_merge(char *spec, int format)
+{
+
+manifest_t m;
+manifest_result_t *all;
+char *have;
+char *shard_seen;
+int num_shards;
+char *names;
+char *name;
+char *saveptr;
+glob_t g;
+size_t i;
+int t;
+int missing;
+int num_files;
+
+
+    names= strdup(spec);
+    if (names == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    num_shards= 0;
+    shard_seen= NULL;
+    all= NULL;
+    have= NULL;
+    num_files= 0;
+    for (name= strtok_r(names, ",", &saveptr); name; name= strtok_r(NULL, ",", &saveptr))   {
+	/* A name that is not a pattern, or matches nothing, is used as is */
+	if (glob(name, GLOB_NOCHECK, NULL, &g) != 0)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	for (i= 0; i < g.gl_pathc; i++)   {
+	    read_shard(g.gl_pathv[i], &m, &num_shards, &shard_seen, &all, &have);
+	    num_files++;
+	}
+	globfree(&g);
+    }
+    free(names);
+
+    if (num_files < 1)   {
+	fprintf(stderr, "No shard file in \"%s\"\n", spec);
+	exit(2);
+    }
+
+    missing= 0;
+    for (t= 0; t < num_shards; t++)   {
+	if (!shard_seen[t])   {
+	    fprintf(stderr, "ERROR: Shard %d of %d is missing\n", t, num_shards);
+	    missing++;
+	}
+    }
+    for (t= 0; t < m.num_tasks; t++)   {
+	if (shard_seen[t % num_shards] && !have[t])   {
+	    fprintf(stderr, "ERROR: Run %d is missing from shard %d\n", t, t % num_shards);
+	    missing++;
+	}
+    }
+    if (missing > 0)   {
+	exit(8);
+    }
+
+    record_open(stdout, format);
+    report(&m, all);
+    record_close();
+
+    free(all);
+    free(have);
+    free(shard_seen);
+    return 0;
+
+}  /* end of manifest_merge() */
+
+
+
+static void
+load_manifest(manifest_t *m, char *fname)
+{
+
+FILE *fp;
+char *text;
+size_t size;
+size_t len;
+
+
+    fp= fopen(fname, "r");
+    if (fp == NULL)   {
+	fprintf(stderr, "Could not open manifest \"%s\": %s\n", fname, strerror(errno));
+	exit(2);
+    }
+
+    size= 4096;
+    len= 0;
+    text= (char *)xmalloc(size);
+    while (TRUE)   {
+	len= len + fread(text + len, 1, size - len, fp);
+	if (len < size)   {
+	    break;
+	}
+	size= size * 2;
+	text= (char *)realloc(text, size);
+	if (text == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+    }
+    if (ferror(fp))   {
+	fprintf(stderr, "Could not read manifest \"%s\": %s\n", fname, strerror(errno));
+	exit(2);
+    }
+    fclose(fp);
+
+    parse_manifest(m, fname, text, len);
+    free(text);
+
+}  /* end of load_manifest() */
+
+
+
+/*
+** Set up m from the size bytes of manifest text. The manifest keeps its
+** own copies of the name and the text.
+*/
+static void
+parse_manifest(manifest_t *m, char *name, char *text, uint32_t size)
+{
+
+am_ctx_t *ctx;
+am_config_t *c;
+config_t *cf;
+char error[256];
+char *line;
+char *copy;
+char *p;
+char *end;
+int line_num;
+int replicas;
+int len;
+
+
+    memset(m, 0, sizeof(manifest_t));
+    m->name= strdup(name);
+    m->text= (char *)xmalloc(size + 1);
+    memcpy(m->text, text, size);
+    m->text[size]= '\0';
+    m->text_size= size;
+    m->seed= 1;
+    if (m->name == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    /* To check each configuration the way am_run() will */
+    ctx= am_init();
+    if (ctx == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    replicas= 1;
+    line_num= 0;
+    for (line= m->text; *line; line= end)   {
+	end= strchr(line, '\n');
+	end= end ? end + 1 : line + strlen(line);
+	len= end - line;
+	line_num++;
+
+	copy= (char *)xmalloc(len + 1);
+	memcpy(copy, line, len);
+	copy[len]= '\0';
+	for (p= copy + len; (p > copy) && ((p[-1] == '\n') || (p[-1] == '\r')); p--)   {
+	    p[-1]= '\0';
+	}
+
+	/* Skip empty lines and comments */
+	for (p= copy; (*p == ' ') || (*p == '\t'); p++)   {
+	}
+	if ((*p == '\0') || (*p == '#'))   {
+	    free(copy);
+	    continue;
+	}
+
+	if (strncmp(p, "replicas", 8) == 0)   {
+	    if ((sscanf(p + 8, "%d%n", &replicas, &len) != 1) || (replicas < 1) ||
+		    (p[8 + len] != '\0'))   {
+		manifest_error(m, line_num, "replicas must be > 0");
+	    }
+	    free(copy);
+	    continue;
+	}
+
+	if (strncmp(p, "seed", 4) == 0)   {
+	    if ((sscanf(p + 4, "%lu%n", &m->seed, &len) != 1) || (p[4 + len] != '\0'))   {
+		manifest_error(m, line_num, "seed must be a number");
+	    }
+	    if (m->num_configs > 0)   {
+		manifest_error(m, line_num, "seed must come before the first configuration");
+	    }
+	    free(copy);
+	    continue;
+	}
+
+	m->configs= (config_t *)realloc(m->configs, (m->num_configs + 1) * sizeof(config_t));
+	if (m->configs == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	cf= &m->configs[m->num_configs];
+	cf->line= strdup(p);
+	if (cf->line == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	cf->replicas= replicas;
+	cf->first_task= m->num_tasks;
+
+	/* A seed of 1 here, so we know whether the line has -s */
+	c= &cf->cfg;
+	error[0]= '\0';
+	if ((serve_parse(p, 1, c, error, sizeof(error)) != AM_OK) ||
+		(am_configure(ctx, c) != AM_OK))   {
+	    manifest_error(m, line_num, (error[0] != '\0') ? error : am_error(ctx));
+	}
+	free(copy);
+
+	if (m->num_tasks > (INT32_MAX - replicas))   {
+	    manifest_error(m, line_num, "Too many replicas");
+	}
+	m->num_tasks= m->num_tasks + replicas;
+	m->num_configs++;
+    }
+    am_free(ctx);
+
+    if (m->num_configs < 1)   {
+	fprintf(stderr, "ERROR: Manifest \"%s\" has no configurations\n", m->name);
+	exit(8);
+    }
+
+}  /* end of parse_manifest() */
+
+
+
+static void
+manifest_error(manifest_t *m, int line_num, const char *msg)
+{
+
+    fprintf(stderr, "ERROR: Manifest \"%s\" line %d: %s\n", m->name, line_num, msg);
+    exit(8);
+
+}  /* end of manifest_error() */
+
+
+
+/*
+** The configuration a task of the sweep is a replica of
+*/
+static int
+task_config(manifest_t *m, int task)
+{
+
+int lo, hi, mid;
+
+
+    lo= 0;
+    hi= m->num_configs - 1;
+    while (lo < hi)   {
+	mid= (lo + hi + 1) / 2;
+	if (m->configs[mid].first_task <= task)   {
+	    lo= mid;
+	} else   {
+	    hi= mid - 1;
+	}
+    }
+
+    return lo;
+
+}  /* end of task_config() */
+
+
+
+/*
+** Replicas get independent seeds that only depend on the manifest seed
+** and on their place in the manifest, not on the shard they run in
+*/
+static unsigned long
+task_seed(manifest_t *m, int config, int replica)
+{
+
+uint64_t h;
+
+
+    h= cache_hash(CACHE_HASH_INIT, &m->seed, sizeof(m->seed));
+    h= cache_hash(h, &config, sizeof(config));
+    h= cache_hash(h, &replica, sizeof(replica));
+
+    /* 0 is the fixed seed of -s */
+    return (h != 0) ? (unsigned long)h : 1;
+
+}  /* end of task_seed() */
+
+
+
+/*
+** Run one replica. This runs in a child process.
+*/
+static void
+manifest_task(int task, void *arg, void *result)
+{
+
+task_arg_t *a= arg;
+manifest_result_t *res= result;
+manifest_t *m= a->m;
+am_ctx_t *ctx;
+am_config_t cfg;
+int c;
+
+
+    memset(res, 0, sizeof(manifest_result_t));
+    res->task= a->tasks[task];
+    c= task_config(m, res->task);
+    cfg= m->configs[c].cfg;
+    if (cfg.seed != 0)   {
+	cfg.seed= task_seed(m, c, res->task - m->configs[c].first_task);
+    }
+
+    ctx= am_init();
+    if (ctx == NULL)   {
+	res->rc= 10;
+	return;
+    }
+    res->rc= am_configure(ctx, &cfg);
+    if (res->rc == AM_OK)   {
+	res->rc= am_run(ctx);
+    }
+    if (res->rc == AM_OK)   {
+	am_results(ctx, &res->r);
+    }
+    am_free(ctx);
+
+}  /* end of manifest_task() */
+
+
+
+/*
+** Write the results of a shard. Returns FALSE, if that did not work; a
+** file that was there before is still there then.
+*/
+static int
+write_shard(char *fname, manifest_t *m, int shard, int num_shards, manifest_result_t *results,
+	int num_results)
+{
+
+FILE *fp;
+char *tmp;
+manifest_hdr_t hdr;
+uint32_t end;
+int rc;
+
+
+    tmp= (char *)xmalloc(strlen(fname) + 5);
+    sprintf(tmp, "%s.tmp", fname);
+
+    fp= fopen(tmp, "w");
+    if (fp == NULL)   {
+	fprintf(stderr, "Could not write shard file \"%s\": %s\n", tmp, strerror(errno));
+	free(tmp);
+	return FALSE;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MANIFEST_MAGIC, sizeof(hdr.magic));
+    hdr.version= MANIFEST_VERSION;
+    hdr.byte_order= MANIFEST_BYTE_ORDER;
+    hdr.result_size= sizeof(manifest_result_t);
+    hdr.shard= shard;
+    hdr.num_shards= num_shards;
+    hdr.num_tasks= m->num_tasks;
+    hdr.num_results= num_results;
+    hdr.name_size= strlen(m->name);
+    hdr.text_size= m->text_size;
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(m->name, 1, hdr.name_size, fp);
+    fwrite(m->text, 1, hdr.text_size, fp);
+    fwrite(results, sizeof(manifest_result_t), num_results, fp);
+    end= MANIFEST_END;
+    fwrite(&end, sizeof(end), 1, fp);
+
+    rc= ferror(fp);
+    if ((fclose(fp) != 0) || rc)   {
+	fprintf(stderr, "Could not write shard file \"%s\"\n", tmp);
+	remove(tmp);
+	free(tmp);
+	return FALSE;
+    }
+
+    if (rename(tmp, fname) != 0)   {
+	fprintf(stderr, "Could not rename \"%s\" to \"%s\": %s\n", tmp, fname, strerror(errno));
+	remove(tmp);
+	free(tmp);
+	return FALSE;
+    }
+
+    free(tmp);
+    return TRUE;
+
+}  /* end of write_shard() */
+
+
+
+/*
+** Add the results in a shard file to all. The first file sets up m and
+** the tables; the others must be shards of the same sweep. A shard that
+** was read before is skipped.
+*/
+static void
+read_shard(char *fname, manifest_t *m, int *num_shards, char **shard_seen,
+	manifest_result_t **all, char **have)
+{
+
+FILE *fp;
+manifest_hdr_t hdr;
+manifest_result_t res;
+char *name;
+char *text;
+uint32_t end;
+int expected;
+int ok;
+int i;
+
+
+    fp= fopen(fname, "r");
+    if (fp == NULL)   {
+	fprintf(stderr, "Could not open shard file \"%s\": %s\n", fname, strerror(errno));
+	exit(2);
+    }
+
+    ok= (fread(&hdr, sizeof(hdr), 1, fp) == 1) &&
+	(memcmp(hdr.magic, MANIFEST_MAGIC, sizeof(hdr.magic)) == 0);
+    if (!ok)   {
+	fprintf(stderr, "ERROR: \"%s\" is not a shard file\n", fname);
+	exit(8);
+    }
+    if ((hdr.byte_order != MANIFEST_BYTE_ORDER) || (hdr.version != MANIFEST_VERSION) ||
+	    (hdr.result_size != sizeof(manifest_result_t)))   {
+	fprintf(stderr, "ERROR: \"%s\" was written by another version of two_step, or on a "
+	    "machine with a different byte order\n", fname);
+	exit(8);
+    }
+    if ((hdr.num_shards < 1) || (hdr.shard < 0) || (hdr.shard >= hdr.num_shards) ||
+	    (hdr.num_tasks < 0) || (hdr.num_results < 0))   {
+	fprintf(stderr, "ERROR: Shard file \"%s\" is corrupt\n", fname);
+	exit(8);
+    }
+
+    name= (char *)xmalloc(hdr.name_size + 1);
+    text= (char *)xmalloc(hdr.text_size + 1);
+    if ((fread(name, 1, hdr.name_size, fp) != hdr.name_size) ||
+	    (fread(text, 1, hdr.text_size, fp) != hdr.text_size))   {
+	fprintf(stderr, "ERROR: Shard file \"%s\" is truncated\n", fname);
+	exit(8);
+    }
+    name[hdr.name_size]= '\0';
+    text[hdr.text_size]= '\0';
+
+    if (*num_shards == 0)   {
+	/* The first one */
+	parse_manifest(m, name, text, hdr.text_size);
+	*num_shards= hdr.num_shards;
+	*shard_seen= (char *)xmalloc(hdr.num_shards);
+	*all= (manifest_result_t *)xmalloc((m->num_tasks + 1) * sizeof(manifest_result_t));
+	*have= (char *)xmalloc(m->num_tasks + 1);
+	memset(*shard_seen, 0, hdr.num_shards);
+	memset(*have, 0, m->num_tasks + 1);
+    } else if ((hdr.num_shards != *num_shards) || (hdr.text_size != m->text_size) ||
+	    (memcmp(text, m->text, hdr.text_size) != 0))   {
+	fprintf(stderr, "ERROR: \"%s\" is not a shard of the same sweep as the others\n", fname);
+	exit(8);
+    }
+    free(name);
+    free(text);
+
+    if (hdr.num_tasks != m->num_tasks)   {
+	fprintf(stderr, "ERROR: Shard file \"%s\" is corrupt\n", fname);
+	exit(8);
+    }
+
+    if ((*shard_seen)[hdr.shard])   {
+	fprintf(stderr, "Warning: Skipping \"%s\". Shard %d was read already\n", fname, hdr.shard);
+	fclose(fp);
+	return;
+    }
+    (*shard_seen)[hdr.shard]= TRUE;
+
+    /* Tasks hdr.shard, hdr.shard + num_shards, ... */
+    expected= (m->num_tasks - hdr.shard + hdr.num_shards - 1) / hdr.num_shards;
+    if (hdr.num_results != expected)   {
+	fprintf(stderr, "ERROR: Shard file \"%s\" has %d runs instead of %d\n", fname,
+	    hdr.num_results, expected);
+	exit(8);
+    }
+
+    for (i= 0; i < hdr.num_results; i++)   {
+	if (fread(&res, sizeof(res), 1, fp) != 1)   {
+	    fprintf(stderr, "ERROR: Shard file \"%s\" is truncated\n", fname);
+	    exit(8);
+	}
+	if ((res.task < 0) || (res.task >= m->num_tasks) ||
+		((res.task % hdr.num_shards) != hdr.shard))   {
+	    fprintf(stderr, "ERROR: Shard file \"%s\" is corrupt\n", fname);
+	    exit(8);
+	}
+	(*all)[res.task]= res;
+	(*have)[res.task]= TRUE;
+    }
+
+    if ((fread(&end, sizeof(end), 1, fp) != 1) || (end != MANIFEST_END))   {
+	fprintf(stderr, "ERROR: Shard file \"%s\" is truncated\n", fname);
+	exit(8);
+    }
+    fclose(fp);
+
+}  /* end of read_shard() */
+
+
+
+/*
+** Statistics over the replicas of each configuration. Replicas that
+** failed, or ran out of --time_budget, are counted, but left out of the
+** statistics.
+*/
+static void
+report(manifest_t *m, manifest_result_t *all)
+{
+
+config_t *cf;
+manifest_result_t *res;
+am_results_t *first;
+double *elapsed;
+stats_t stats;
+double mean, stddev, ci95;
+double work;
+double interrupts, faults, node_failures, checkpoints, failed_checkpoints;
+double restarts, failed_restarts, rework, restart, checkpoint;
+const char *base;
+int num_failed, num_stopped;
+int num;
+int c, j;
+
+
+    base= strrchr(m->name, '/');
+    base= base ? base + 1 : m->name;
+    if (!record_active())   {
+	printf("SWEEP \"%s\": %d configurations, %d runs\n", base, m->num_configs, m->num_tasks);
+    }
+
+    elapsed= NULL;
+    for (c= 0; c < m->num_configs; c++)   {
+	cf= &m->configs[c];
+	elapsed= (double *)realloc(elapsed, cf->replicas * sizeof(double));
+	if (elapsed == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+
+	first= NULL;
+	num= 0;
+	num_failed= 0;
+	num_stopped= 0;
+	stats_init(&stats);
+	interrupts= faults= node_failures= checkpoints= failed_checkpoints= 0.0;
+	restarts= failed_restarts= rework= restart= checkpoint= 0.0;
+	for (j= 0; j < cf->replicas; j++)   {
+	    res= &all[cf->first_task + j];
+	    if (res->rc != 0)   {
+		num_failed++;
+		continue;
+	    }
+	    if (res->r.stopped_early)   {
+		num_stopped++;
+		continue;
+	    }
+	    if (first == NULL)   {
+		first= &res->r;
+	    }
+	    elapsed[num++]= res->r.elapsed;
+	    stats_add(&stats, res->r.elapsed);
+	    interrupts= interrupts + res->r.interrupts;
+	    faults= faults + res->r.faults;
+	    node_failures= node_failures + res->r.node_failures;
+	    checkpoints= checkpoints + res->r.checkpoints;
+	    failed_checkpoints= failed_checkpoints + res->r.failed_checkpoints;
+	    restarts= restarts + res->r.restarts;
+	    failed_restarts= failed_restarts + res->r.failed_restarts;
+	    rework= rework + res->r.rework_time;
+	    restart= restart + res->r.restart_time;
+	    checkpoint= checkpoint + res->r.checkpoint_time;
+	}
+
+	stats_sort(elapsed, num);
+	mean= stats_mean(&stats);
+	stddev= stats_stddev(&stats);
+	ci95= stats_ci95(&stats);
+	work= 60.0 * cf->cfg.work_time;
+
+	if (record_active())   {
+	    record_begin();
+	    record_section("sweep");
+	    record_string("manifest", base);
+	    record_int("configuration", c + 1);
+	    record_string("options", cf->line);
+	    record_int("replicas", cf->replicas);
+	    record_int("completed", num);
+	    record_int("failed", num_failed);
+	    record_int("stopped_early", num_stopped);
+
+	    record_section("calculated");
+	    record_double("checkpoint_interval_min", first ? first->tau : NAN);
+	    record_double("sys_mtbf_min", first ? first->sys_mtbf : NAN);
+	    record_double("app_mtbi_min", first ? first->app_mtbf : NAN);
+	    record_double("modeled_elapsed_min", first ? first->daly : NAN);
+
+	    record_section("elapsed_min");
+	    record_double("mean", mean);
+	    record_double("stddev", stddev);
+	    record_double("ci95", ci95);
+	    record_double("min", (num > 0) ? elapsed[0] : NAN);
+	    record_double("p10", (num > 0) ? stats_percentile(elapsed, num, 10.0) : NAN);
+	    record_double("p50", (num > 0) ? stats_percentile(elapsed, num, 50.0) : NAN);
+	    record_double("p90", (num > 0) ? stats_percentile(elapsed, num, 90.0) : NAN);
+	    record_double("max", (num > 0) ? elapsed[num - 1] : NAN);
+
+	    record_section("mean");
+	    record_double("overhead_pct", (100.0 / work * mean) - 100.0);
+	    record_double("interrupts", (num > 0) ? interrupts / num : NAN);
+	    record_double("faults", (num > 0) ? faults / num : NAN);
+	    record_double("node_failures", (num > 0) ? node_failures / num : NAN);
+	    record_double("checkpoints", (num > 0) ? checkpoints / num : NAN);
+	    record_double("failed_checkpoints", (num > 0) ? failed_checkpoints / num : NAN);
+	    record_double("restarts", (num > 0) ? restarts / num : NAN);
+	    record_double("failed_restarts", (num > 0) ? failed_restarts / num : NAN);
+	    record_double("rework_min", (num > 0) ? rework / num : NAN);
+	    record_double("restart_min", (num > 0) ? restart / num : NAN);
+	    record_double("checkpoint_min", (num > 0) ? checkpoint / num : NAN);
+	    record_end();
+	    continue;
+	}
+
+	printf("\n");
+	printf("CONFIGURATION %d: %s\n", c + 1, cf->line);
+	printf("  Replicas               %12d\n", cf->replicas);
+	printf("  Replicas completed     %12d\n", num);
+	for (j= 0; j < cf->replicas; j++)   {
+	    res= &all[cf->first_task + j];
+	    if (res->rc != 0)   {
+		printf("  Replica %d failed (exit code %d)\n", j, res->rc);
+	    } else if (res->r.stopped_early)   {
+		printf("  Replica %d stopped by --time_budget\n", j);
+	    }
+	}
+	if (num < 1)   {
+	    continue;
+	}
+
+	printf("  Checkpoint interval    %12.2f hours (%.3f minutes)\n", first->tau / 60.0,
+	    first->tau);
+	printf("  Application MTBI       %12.2f hours (%.3f minutes)\n", first->app_mtbf / 60.0,
+	    first->app_mtbf);
+	printf("  Modeled elapsed time   %12.2f hours\n", first->daly / 60.0);
+	printf("  Elapsed time minimum   %12.2f hours (Overhead is %5.2f%%)\n", elapsed[0] / 60.0,
+	    (100.0 / work * elapsed[0]) - 100.0);
+	printf("  Elapsed time mean      %12.2f hours (Overhead is %5.2f%%)\n", mean / 60.0,
+	    (100.0 / work * mean) - 100.0);
+	if (num > 1)   {
+	    printf("  Elapsed time std dev   %12.2f hours (95%% confidence of the mean +/- %.2f)\n",
+		stddev / 60.0, ci95 / 60.0);
+	} else   {
+	    printf("  Elapsed time std dev   %12.2f hours\n", stddev / 60.0);
+	}
+	printf("  Elapsed time 10th pct  %12.2f hours\n", stats_percentile(elapsed, num, 10.0) / 60.0);
+	printf("  Elapsed time median    %12.2f hours\n", stats_percentile(elapsed, num, 50.0) / 60.0);
+	printf("  Elapsed time 90th pct  %12.2f hours\n", stats_percentile(elapsed, num, 90.0) / 60.0);
+	printf("  Elapsed time maximum   %12.2f hours (Overhead is %5.2f%%)\n",
+	    elapsed[num - 1] / 60.0, (100.0 / work * elapsed[num - 1]) - 100.0);
+	printf("  Mean interrupts        %12.2f\n", interrupts / num);
+	printf("  Mean faults            %12.2f\n", faults / num);
+	printf("  Mean checkpoints       %12.2f    Failed: %.2f\n", checkpoints / num,
+	    failed_checkpoints / num);
+	printf("  Mean restarts          %12.2f    Failed: %.2f\n", restarts / num,
+	    failed_restarts / num);
+	printf("  Mean rework time       %12.2f hours\n", rework / num / 60.0);
+    }
+
+    free(elapsed);
+
+}  /* end of report() */
+
+
+
+static void *
+xmalloc(size_t size)
+{
+
+void *p;
+
+
+    p= malloc(size);
+    if (p == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    return p;
+
+}  /* end of xmalloc() */
@@ -0,0 +1,63 @@
+/*
+** $Id$
+**
+** --sweep: run the configurations of a manifest file, several replicas
+** of each, all in one process or split into --shard i/N processes whose
+** result files --merge combines.
+**
+** A manifest has one configuration per line, with the options of a
+** --serve scenario. Empty lines and lines that start with # are skipped.
+**     seed S		Base seed of all replicas. Before the first configuration
+**     replicas K	Replicas of each configuration after this line. Default 1
+** Replica j of configuration c is task number first_task(c) + j, and
+** gets a seed calculated from S, c, and j, unless its line has -s.
+** Shard i of N runs the tasks t with t % N == i.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _MANIFEST_H_
+#define _MANIFEST_H_
+
+#include <stdint.h>
+
+/*
+** Shard file layout:
+**     manifest_hdr_t		header
+**     name_size bytes		the manifest file name
+**     text_size bytes		the manifest, so the file is all --merge needs
+**     manifest_result_t	num_results times, in task order
+**     MANIFEST_END		marks a complete file
+** All values are stored in the byte order of the machine that wrote the
+** file. Change MANIFEST_VERSION, when any of the sections change.
+*/
+#define MANIFEST_MAGIC		"APPMSHD1"
+#define MANIFEST_VERSION	(1)
+#define MANIFEST_BYTE_ORDER	(0x01020304)
+#define MANIFEST_END		(0x454e4421)
+
+typedef struct manifest_hdr_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t result_size;	/* sizeof(manifest_result_t) */
+    int32_t shard;
+    int32_t num_shards;
+    int32_t num_tasks;		/* In the whole sweep */
+    int32_t num_results;	/* In this file */
+    uint32_t name_size;
+    uint32_t text_size;
+    uint32_t unused;
+} manifest_hdr_t;
+
+
+int manifest_run(char *fname, int shard, int num_shards, char *shard_file, int max_jobs,
+	int format);
+int manifest_merge(char *spec, int format);
+
+#endif /* _MANIFEST_H_ */
@@ -0,0 +1,261 @@
+/*
+** $Id$
+**
+** Timers and counters for the -p performance report. See perf.h.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "globals.h"
+#include "record.h"
+#include "perf.h"
+
+
+SIM_LOCAL uint64_t perf_tree_inserts;
+SIM_LOCAL uint64_t perf_tree_deletes;
+SIM_LOCAL uint64_t perf_tree_steps;
+SIM_LOCAL uint64_t perf_tod_retries;
+SIM_LOCAL uint64_t perf_soft_reboots;
+SIM_LOCAL uint64_t perf_phase_iterations;
+SIM_LOCAL uint64_t perf_allocs;
+SIM_LOCAL uint64_t perf_output_bytes;
+
+static SIM_LOCAL int timers= FALSE;
+static SIM_LOCAL int current= PERF_OTHER;
+static SIM_LOCAL double last;
+static SIM_LOCAL double spent[PERF_NUM_TIMERS];
+
+static const char *timer_name[PERF_NUM_TIMERS]=   {
+    "setup",
+    "phases",
+    "rMPI",
+    "input",
+    "output",
+    "other",
+};
+
+
+/* Local functions */
+static double now(void);
+static long peak_rss_kb(void);
+static double total_time(void);
+static double loop_time(void);
+
+
+
+/*
+** Reset the counters. With timers_on, start charging time to PERF_SETUP.
+*/
+void
+perf_init(int timers_on)
+{
+
+int i;
+
+
+    perf_tree_inserts= 0;
+    perf_tree_deletes= 0;
+    perf_tree_steps= 0;
+    perf_tod_retries= 0;
+    perf_soft_reboots= 0;
+    perf_phase_iterations= 0;
+    perf_allocs= 0;
+    perf_output_bytes= 0;
+
+    for (i= 0; i < PERF_NUM_TIMERS; i++)   {
+	spent[i]= 0.0;
+    }
+    timers= timers_on;
+    current= PERF_SETUP;
+    if (timers)   {
+	last= now();
+    }
+
+}  /* end of perf_init() */
+
+
+
+/*
+** Charge the time since the last switch to the current timer, and
+** start charging to this one. Returns the previous timer.
+*/
+int
+perf_switch(int timer)
+{
+
+int prev;
+double t;
+
+
+    prev= current;
+    current= timer;
+    if (timers)   {
+	t= now();
+	spent[prev]= spent[prev] + (t - last);
+	last= t;
+    }
+
+    return prev;
+
+}  /* end of perf_switch() */
+
+
+
+void
+perf_report(void)
+{
+
+double total;
+double loop;
+uint64_t events;
+int i;
+
+
+    /* Charge the time up to now */
+    perf_switch(current);
+    total= total_time();
+
+    printf("\n");
+    printf("  Where the time went                 Seconds     Percent\n");
+    for (i= 0; i < PERF_NUM_TIMERS; i++)   {
+	printf("    %-28s %12.6f %10.2f%%\n", timer_name[i], spent[i],
+	    (total > 0.0) ? 100.0 / total * spent[i] : 0.0);
+    }
+    printf("    %-28s %12.6f\n", "total", total);
+
+    printf("\n");
+    printf("  Counter                               Count     Per sec\n");
+    printf("    %-28s %12lu %12.0f\n", "search tree inserts",
+	(unsigned long)perf_tree_inserts, (total > 0.0) ? perf_tree_inserts / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "search tree deletes",
+	(unsigned long)perf_tree_deletes, (total > 0.0) ? perf_tree_deletes / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "search tree steps",
+	(unsigned long)perf_tree_steps, (total > 0.0) ? perf_tree_steps / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "duplicate tod retries",
+	(unsigned long)perf_tod_retries, (total > 0.0) ? perf_tod_retries / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "soft reboot attempts",
+	(unsigned long)perf_soft_reboots, (total > 0.0) ? perf_soft_reboots / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "phase machine iterations",
+	(unsigned long)perf_phase_iterations, (total > 0.0) ? perf_phase_iterations / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "allocations",
+	(unsigned long)perf_allocs, (total > 0.0) ? perf_allocs / total : 0.0);
+    printf("    %-28s %12lu %12.0f\n", "output bytes",
+	(unsigned long)perf_output_bytes, (total > 0.0) ? perf_output_bytes / total : 0.0);
+
+    /* The events of the simulation are faults and application interrupts */
+    events= (uint64_t)fault_cnt + (uint64_t)interrupt_cnt;
+    loop= loop_time();
+    printf("\n");
+    printf("  Simulated %lu events (faults and interrupts), %.0f events/sec in the "
+	"simulation loop\n", (unsigned long)events, (loop > 0.0) ? events / loop : 0.0);
+    printf("  Peak resident set size %ld kB\n", peak_rss_kb());
+
+}  /* end of perf_report() */
+
+
+
+/*
+** Add the timers and counters to the current record section
+*/
+void
+perf_record(void)
+{
+
+int i;
+char key[64];
+
+
+    perf_switch(current);
+    for (i= 0; i < PERF_NUM_TIMERS; i++)   {
+	snprintf(key, sizeof(key), "time_%s_sec", timer_name[i]);
+	record_double(key, spent[i]);
+    }
+
+    /* Counts can exceed an int */
+    record_double("tree_inserts", (double)perf_tree_inserts);
+    record_double("tree_deletes", (double)perf_tree_deletes);
+    record_double("tree_steps", (double)perf_tree_steps);
+    record_double("tod_retries", (double)perf_tod_retries);
+    record_double("soft_reboot_attempts", (double)perf_soft_reboots);
+    record_double("phase_iterations", (double)perf_phase_iterations);
+    record_double("allocations", (double)perf_allocs);
+    record_double("output_bytes", (double)perf_output_bytes);
+    record_double("events_per_sec", (loop_time() > 0.0) ?
+	((double)fault_cnt + interrupt_cnt) / loop_time() : 0.0);
+    record_double("peak_rss_kb", (double)peak_rss_kb());
+
+}  /* end of perf_record() */
+
+
+
+static double
+now(void)
+{
+
+struct timespec tm;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &tm);
+    return (double)(tm.tv_sec) + (double)(tm.tv_nsec) / 1000000000.0;
+
+}  /* end of now() */
+
+
+
+static long
+peak_rss_kb(void)
+{
+
+struct rusage usage;
+
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)   {
+	return 0;
+    }
+
+    /* Linux reports kilobytes */
+    return usage.ru_maxrss;
+
+}  /* end of peak_rss_kb() */
+
+
+
+static double
+total_time(void)
+{
+
+double total;
+int i;
+
+
+    total= 0.0;
+    for (i= 0; i < PERF_NUM_TIMERS; i++)   {
+	total= total + spent[i];
+    }
+
+    return total;
+
+}  /* end of total_time() */
+
+
+
+/*
+** The time of the simulation loop: everything but the setup before it,
+** and the report after it
+*/
+static double
+loop_time(void)
+{
+
+    return spent[PERF_PHASES] + spent[PERF_RMPI] + spent[PERF_INPUT] + spent[PERF_OUTPUT];
+
+}  /* end of loop_time() */
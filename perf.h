@@ -0,0 +1,47 @@
+/*
+** $Id$
+**
+** Timers and counters for the -p performance report. The counters are
+** plain increments and always on. The timers read CLOCK_MONOTONIC, and
+** only when -p is given. Time is charged to one subsystem at a time;
+** perf_switch() moves the clock to another one and returns the one it
+** left, so a caller can switch back.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _PERF_H_
+#define _PERF_H_
+
+#include <stdint.h>
+
+#define PERF_SETUP		(0)	/* Node array and search tree */
+#define PERF_PHASES		(1)	/* The state machine in app.c */
+#define PERF_RMPI		(2)	/* Finding the next interrupt */
+#define PERF_INPUT		(3)	/* Getting faults from the input */
+#define PERF_OUTPUT		(4)	/* Handing output to the writers */
+#define PERF_OTHER		(5)
+#define PERF_NUM_TIMERS		(6)
+
+/* Counters. Per thread, like the rest of the simulation state */
+extern SIM_LOCAL uint64_t perf_tree_inserts;
+extern SIM_LOCAL uint64_t perf_tree_deletes;
+extern SIM_LOCAL uint64_t perf_tree_steps;
+extern SIM_LOCAL uint64_t perf_tod_retries;
+extern SIM_LOCAL uint64_t perf_soft_reboots;
+extern SIM_LOCAL uint64_t perf_phase_iterations;
+extern SIM_LOCAL uint64_t perf_allocs;
+extern SIM_LOCAL uint64_t perf_output_bytes;
+
+
+void perf_init(int timers_on);
+int perf_switch(int timer);
+void perf_report(void);
+void perf_record(void);
+
+#endif /* _PERF_H_ */
@@ -16,6 +16,10 @@
 #include <assert.h>
 #include "phases.h"
 #include "globals.h"
+#include "fmt.h"
+#include "debug.h"
+#include "hist.h"
+#include "events.h"
 
 #define MIN(a, b)		((a) < (b) ? (a) : (b))
 
@@ -32,6 +36,11 @@
 void
 do_restart(double next_interrupt, double restart_time, int verbose, double *elapsed_time)
 {
+
+double start;
+
+
+    start= *elapsed_time;
     if (next_interrupt > (*elapsed_time + restart_time))   {
 	/*
 	** We have enough time to finish this restart before the
@@ -40,11 +49,10 @@ do_restart(double next_interrupt, double restart_time, int verbose, double *elap
 	*elapsed_time= *elapsed_time + restart_time;
 	restart_cnt++;
 	total_restart_time= total_restart_time + restart_time;
+	event_phase(EVENT_RESTART, start, *elapsed_time, EVENT_DONE);
 
-	if (verbose > 3)   {
-	    fprintf(stderr, "%12.1f\" restart time             %12.1f\", count %d\n", *elapsed_time,
-		restart_time, restart_cnt);
-	}
+	TRACE4(verbose, "%12.1f\" restart time             %12.1f\", count %d\n", *elapsed_time,
+	    restart_time, restart_cnt);
 
     } else   {
 	/*
@@ -54,10 +62,10 @@ do_restart(double next_interrupt, double restart_time, int verbose, double *elap
 	wasted_restart_time= wasted_restart_time + (next_interrupt - *elapsed_time);
 	*elapsed_time= next_interrupt;
 	failed_restart_cnt++;
+	hist_lost_work(0.0);
+	event_phase(EVENT_RESTART, start, *elapsed_time, EVENT_INTERRUPTED);
 
-	if (verbose > 2)   {
-	    fprintf(stderr, "%12.1f\" restart %d/%d failed\n", *elapsed_time, failed_restart_cnt, restart_cnt);
-	}
+	TRACE3(verbose, "%12.1f\" restart %d/%d failed\n", *elapsed_time, failed_restart_cnt, restart_cnt);
     }
 
 }  /* end of do_restart() */
@@ -80,7 +88,10 @@ do_rework(double next_interrupt, double rework_time, int verbose, double *elapse
 {
 
 double rework_done;
+double start;
+
 
+    start= *elapsed_time;
 
     /*
     ** How much rework can we do, until the next interrupt
@@ -94,10 +105,10 @@ double rework_done;
 	/* Rework was interrupted */
 	wasted_rework_time= wasted_rework_time + rework_done;
 	failed_rework_cnt++;
-	if (verbose > 2)   {
-	    fprintf(stderr, "%12.1f\" rework time (partial)    %12.1f/%.0f\", count %d\n", *elapsed_time,
-		rework_done, MIN((next_interrupt - *elapsed_time), rework_time), failed_rework_cnt);
-	}
+	hist_lost_work(rework_done);
+	event_phase(EVENT_REWORK, start, *elapsed_time, EVENT_INTERRUPTED);
+	TRACE3(verbose, "%12.1f\" rework time (partial)    %12.1f/%.0f\", count %d\n", *elapsed_time,
+	    rework_done, MIN((next_interrupt - *elapsed_time), rework_time), failed_rework_cnt);
     } else if (rework_done >= rework_time)   {
 	/* We are done with rework */
 	total_rework_time= total_rework_time + rework_done;
@@ -106,10 +117,11 @@ double rework_done;
 	** rework_done will count as work done, but not yet!
 	*/
 	rework_cnt++;
-	if (verbose > 3)   {
-	    fprintf(stderr, "%12.1f\" rework (saved) done      %12.1f\", work done so far %12.1f\", count %d\n",
-		*elapsed_time, rework_done, total_work_time, rework_cnt);
+	if (rework_done > 0.0)   {
+	    event_phase(EVENT_REWORK, start, *elapsed_time, EVENT_DONE);
 	}
+	TRACE4(verbose, "%12.1f\" rework (saved) done      %12.1f\", work done so far %12.1f\", count %d\n",
+	    *elapsed_time, rework_done, total_work_time, rework_cnt);
     } else   {
 	/* This means we had more rework than tau! */
 	assert(FALSE);
@@ -144,6 +156,7 @@ do_work(double next_interrupt, double work_time, double *rework_time,
 double work_done;
 double work_left;
 double checkpoint_done;
+double start;
 int first_segment;
 
 
@@ -161,6 +174,7 @@ int first_segment;
 
 	work_done= MIN(time_left_this_segment, (next_interrupt - *elapsed_time));
 	work_done= MIN(work_done, work_left);
+	start= *elapsed_time;
 	*elapsed_time= *elapsed_time + work_done;
 
 	if (first_segment)   {
@@ -173,14 +187,15 @@ int first_segment;
 	if (*elapsed_time >= next_interrupt)   {
 	    failed_work_cnt++;
 	    *rework_time= work_done;
-	    if (verbose > 2)   {
-		fprintf(stderr, "%12.1f\" work time (partial)      %12.1f/%.0f\", count %d\n", *elapsed_time,
-		    work_done, MIN(time_left_this_segment, work_left), failed_work_cnt);
-	    }
+	    hist_lost_work(work_done);
+	    event_phase(EVENT_WORK, start, *elapsed_time, EVENT_INTERRUPTED);
+	    TRACE3(verbose, "%12.1f\" work time (partial)      %12.1f/%.0f\", count %d\n", *elapsed_time,
+		work_done, MIN(time_left_this_segment, work_left), failed_work_cnt);
 	    break;
 	}
 
 	/* Must be checkpoint time */
+	event_phase(EVENT_WORK, start, *elapsed_time, EVENT_DONE);
 	if (next_interrupt > (*elapsed_time + checkpoint_time))   {
 	    /* We have time to write a checkpoint */
 	    work_cnt++;
@@ -189,38 +204,35 @@ int first_segment;
 
 	    if ((work_time - total_work_time) <= 0.0)   {
 		/* We are done with work */
-		if (verbose > 3)   {
-		    fprintf(stderr, "%12.1f\" work (saved) DONE        %12.1f\", so far %12.1f\", count %d\n", *elapsed_time,
-			work_done, total_work_time, work_cnt);
-		    }
+		TRACE4(verbose, "%12.1f\" work (saved) DONE        %12.1f\", so far %12.1f\", count %d\n", *elapsed_time,
+		    work_done, total_work_time, work_cnt);
 		return TRUE;  /* done */
 	    }
 
+	    event_phase(EVENT_CHECKPOINT, *elapsed_time, *elapsed_time + checkpoint_time, EVENT_DONE);
 	    *elapsed_time= *elapsed_time + checkpoint_time;
 	    checkpoint_cnt++;
 	    total_checkpoint_time= total_checkpoint_time + checkpoint_time;
 	    *rework_time= 0.0;
 	    time_left_this_segment= tau;
-	    if (verbose > 3)   {
-		fprintf(stderr, "%12.1f\" work (saved) time        %12.1f\", so far %12.1f\", count %d\n", *elapsed_time,
-		    work_done, total_work_time, work_cnt);
-		fprintf(stderr, "%12.1f\" checkpoint time          %12.1f\", count %d\n", *elapsed_time,
-		    checkpoint_time, checkpoint_cnt);
-	    }
+	    TRACE4(verbose, "%12.1f\" work (saved) time        %12.1f\", so far %12.1f\", count %d\n", *elapsed_time,
+		work_done, total_work_time, work_cnt);
+	    TRACE4(verbose, "%12.1f\" checkpoint time          %12.1f\", count %d\n", *elapsed_time,
+		checkpoint_time, checkpoint_cnt);
 	} else   {
 	    /* We will get interrupted during a checkpoint write */
 	    checkpoint_done= next_interrupt - *elapsed_time;
+	    event_phase(EVENT_CHECKPOINT, *elapsed_time, next_interrupt, EVENT_INTERRUPTED);
 	    *elapsed_time= *elapsed_time + checkpoint_done;
 	    wasted_checkpoint_time= wasted_checkpoint_time + checkpoint_done;
 	    failed_checkpoint_cnt++;
 
 	    *rework_time= work_done;
-	    if (verbose > 2)   {
-		fprintf(stderr, "%12.1f\" work (not saved) time    %12.1f\", count %d\n", *elapsed_time,
-		    work_done, failed_work_cnt);
-		fprintf(stderr, "%12.1f\" failed checkpoint time   %12.1f/%.0f\", count %d\n", *elapsed_time,
-		    checkpoint_done, checkpoint_time, failed_checkpoint_cnt);
-	    }
+	    hist_lost_work(work_done);
+	    TRACE3(verbose, "%12.1f\" work (not saved) time    %12.1f\", count %d\n", *elapsed_time,
+		work_done, failed_work_cnt);
+	    TRACE3(verbose, "%12.1f\" failed checkpoint time   %12.1f/%.0f\", count %d\n", *elapsed_time,
+		checkpoint_done, checkpoint_time, failed_checkpoint_cnt);
 	    break;
 	}
     }
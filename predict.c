@@ -0,0 +1,178 @@
+/*
+** $Id$
+**
+** Predict what a run will cost before it starts. The expected elapsed
+** time comes from Daly's model, the same one report_results() compares
+** against. It gives the number of interrupts and faults, and those,
+** plus the number of nodes, give the wall time, the random numbers
+** drawn, and the memory used. The constants are in predict.h.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <math.h>
+
+#include "globals.h"
+#include "predict.h"
+
+
+
+void
+predict(prediction_t *p, int total_nodes, double work_time, double tau,
+	double checkpoint_time, double restart_time, double sys_mtbf, double app_mtbf,
+	int soft_reboot)
+{
+
+    /* This is eq 20 from Daly:04:higher */
+    p->elapsed= app_mtbf *
+	    exp(restart_time / app_mtbf) *
+	    (exp((tau + checkpoint_time) / app_mtbf) - 1.0) *
+	    (work_time / tau);
+
+    p->interrupts= p->elapsed / app_mtbf;
+    p->faults= p->elapsed / sys_mtbf;
+
+    /* One failure time per node to start, and a new one after each fault */
+    p->draws= total_nodes + p->faults;
+    if (soft_reboot)   {
+	/* Plus a probability for each reboot attempt */
+	p->draws= p->draws + p->faults;
+    }
+
+    p->setup_sec= total_nodes * PREDICT_SETUP_SEC_PER_NODE;
+    p->wall_sec= p->setup_sec + p->faults * PREDICT_SEC_PER_FAULT;
+    p->mem_kb= PREDICT_BASE_KB + total_nodes * PREDICT_KB_PER_NODE;
+
+}  /* end of predict() */
+
+
+
+/*
+** The wall time after setup grows with the work. Return the work time
+** that fits into max_wall_sec, or 0.0 if not even the setup fits.
+*/
+double
+predict_work_for(prediction_t *p, double work_time, double max_wall_sec)
+{
+
+    if (p->setup_sec >= max_wall_sec)   {
+	return 0.0;
+    }
+
+    if (p->wall_sec <= max_wall_sec)   {
+	return work_time;
+    }
+
+    return work_time * (max_wall_sec - p->setup_sec) / (p->wall_sec - p->setup_sec);
+
+}  /* end of predict_work_for() */
+
+
+
+static double
+Qm2(int n)
+{
+    return sqrt(M_PI * n / 2.0) + (2.0/3.0);
+}  /* end of Qm2() */
+
+
+
+/*
+** Fill in the system and application MTBF, unless they are >= 0 already,
+** and tau from Daly's equation, unless it is >= 0 already. All in minutes.
+** The faults per interrupt are -3.0 when we do not know them.
+*/
+void
+predict_tau(double *tau, double *calculated_sys_mtbf, double *calculated_app_mtbf,
+	double *calculated_fpi, int num_bundles,
+	int num_redundant, double node_mtbf, double checkpoint_time)
+{
+
+float p;
+float r_none, r_double;
+
+
+    /*
+    ** Calculate the system and application MTBI. We use it to calculate the
+    ** optimal checkpoint interval (tau) using Daly's equation.
+    */
+
+    /* Percentage of redundant nodes */
+    p= (float)num_redundant / (float)num_bundles;
+
+    if (*calculated_sys_mtbf < 0.0)   {
+	/* Not provided by user */
+	*calculated_sys_mtbf= node_mtbf / (num_bundles * (1.0 + p));
+    }
+
+
+    /* Calculate the MTBF of the non-redundant portion of the system */
+    if (num_redundant >= num_bundles)   {
+	/* Each bundle has redundant nodes */
+	r_none= 0.0;
+    } else   {
+	/* Some bundles do not have redundant nodes */
+	r_none= node_mtbf / (num_bundles - num_redundant);
+    }
+
+    /* Calculate the MTBF for the bundles with 2 redundant nodes */
+    if (num_redundant > 0)   {
+	r_double= (node_mtbf / (2.0 * num_redundant)) * Qm2(2.0 * num_redundant);
+    } else   {
+	/* no bundles with redundant ndoes */
+	r_double= 0.0;
+    }
+
+    if (*calculated_app_mtbf < 0.0)   {
+	/* Unless supplied by user */
+	if (num_redundant >= num_bundles)   {
+	    /* All bundles have redundant nodes */
+	    *calculated_app_mtbf= r_double;
+	} else if (num_redundant > 0)   {
+	    /* Only some bundles have redundant nodes */
+	    /* FIXME: This calculation is wrong, I think. */
+	    *calculated_app_mtbf= 1.0 / ((1.0 / r_none) + (1.0 / r_double));
+	} else   {
+	    /* No bundles have redundant nodes */
+	    *calculated_app_mtbf= r_none;
+	}
+    }
+
+
+
+    /*
+    ** calculate optimal checkpoint interval (tau) using Daly's equation,
+    ** unless the user supplied a specific tau.
+    */
+    if (*tau < 0.0)   {
+	if (checkpoint_time >= (2.0 * *calculated_app_mtbf))   {
+	    *tau= *calculated_app_mtbf;
+	} else   {
+	    *tau= sqrt(2.0 * checkpoint_time * *calculated_app_mtbf) *
+		(1.0 + 
+		 (1.0 / 3.0) * sqrt(checkpoint_time / (2.0 * *calculated_app_mtbf)) +
+		 (checkpoint_time / (9.0 * 2.0 * *calculated_app_mtbf))
+		) - checkpoint_time;
+	}
+
+	if (*tau < 0.0)   {
+	    sim_error(4, "   ERROR: tau (checkpoint time) is negative!\n");
+	}
+    }
+
+    if (num_bundles == num_redundant)   {
+	*calculated_fpi= Qm2(2.0 * num_bundles);
+    } else if (num_redundant == 0)   {
+	*calculated_fpi= 1.0;
+    } else   {
+	/* FIXME: Don't know how to do that yet */
+	*calculated_fpi= -3.0;
+    }
+
+}  /* end of predict_tau() */
@@ -0,0 +1,47 @@
+/*
+** $Id$
+**
+** Predict what a run will cost before it starts: how long it takes,
+** how many random numbers it draws, and how much memory it needs.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _PREDICT_H_
+#define _PREDICT_H_
+
+/*
+** Calibrated with make bench (default build, no -O). Setting up a node
+** costs between 0.5 and 3 us, depending on how much of the search tree
+** fits in the caches; each fault costs 2.5 to 5 us. A node takes about
+** 86 bytes: its node_t, its search tree entry, and malloc overhead.
+*/
+#define PREDICT_SETUP_SEC_PER_NODE	(2.5e-6)
+#define PREDICT_SEC_PER_FAULT		(4.0e-6)
+#define PREDICT_BASE_KB			(4400.0)
+#define PREDICT_KB_PER_NODE		(0.086)
+
+typedef struct prediction_t   {
+    double elapsed;		/* minutes, Daly's model */
+    double interrupts;
+    double faults;
+    double draws;		/* Random numbers and probabilities */
+    double setup_sec;		/* Part of wall_sec that does not depend on the work */
+    double wall_sec;
+    double mem_kb;
+} prediction_t;
+
+
+void predict(prediction_t *p, int total_nodes, double work_time, double tau,
+	double checkpoint_time, double restart_time, double sys_mtbf, double app_mtbf,
+	int soft_reboot);
+double predict_work_for(prediction_t *p, double work_time, double max_wall_sec);
+void predict_tau(double *tau, double *sys_mtbf, double *app_mtbf, double *fpi,
+	int num_bundles, int num_redundant, double node_mtbf, double checkpoint_time);
+
+#endif /* _PREDICT_H_ */
@@ -0,0 +1,266 @@
+/*
+** $Id$
+**
+** Signs of life from a long run. See progress.h.
+**
+** The signal handlers only set flags. The simulation loop checks one of
+** them, progress_pending, once per application interrupt and does the
+** printing and the shared memory updates in progress_poll(). SIGALRM
+** from an interval timer drives the heartbeat and the updates, so the
+** loop does not have to read the clock.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "globals.h"
+#include "timing.h"
+#include "progress.h"
+
+/* The shared memory segment is updated this often, at most */
+#define PROGRESS_TICK_SEC	(1.0)
+
+
+volatile sig_atomic_t progress_pending= 0;
+
+static volatile sig_atomic_t dump_requested= 0;
+static double start;
+static double heartbeat;
+static double tick;
+static double last_beat;
+static char *name;
+static progress_shm_t *shared;
+
+
+/* Local functions */
+static void on_usr1(int sig);
+static void on_alarm(int sig);
+static void set_timer(double seconds);
+static void print_line(const char *why, double elapsed_time, double work_time);
+static void publish(double elapsed_time, double work_time, int done);
+
+
+
+/*
+** Catch SIGUSR1. With heartbeat_sec > 0, print a line every that many
+** seconds. With a shm_name, create the shared memory segment.
+*/
+void
+progress_start(double heartbeat_sec, char *shm_name)
+{
+
+struct sigaction sa;
+int fd;
+
+
+    start= get_clock_value();
+    heartbeat= heartbeat_sec;
+    last_beat= start;
+    shared= NULL;
+    name= NULL;
+
+    /* A handler that interrupts a read() or waitpid() must not make it fail */
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags= SA_RESTART;
+    sa.sa_handler= on_usr1;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    if (shm_name)   {
+	/* POSIX shared memory names start with a slash */
+	name= (char *)malloc(strlen(shm_name) + 2);
+	if (name == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	sprintf(name, "%s%s", (shm_name[0] == '/') ? "" : "/", shm_name);
+
+	/* Remove what a killed run left behind. Monitors may only read */
+	shm_unlink(name);
+	fd= shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0444);
+	if (fd < 0)   {
+	    fprintf(stderr, "Could not create shared memory \"%s\": %s\n", name, strerror(errno));
+	    exit(2);
+	}
+	if (ftruncate(fd, sizeof(progress_shm_t)) != 0)   {
+	    fprintf(stderr, "Could not size shared memory \"%s\": %s\n", name, strerror(errno));
+	    exit(2);
+	}
+	shared= (progress_shm_t *)mmap(NULL, sizeof(progress_shm_t), PROT_READ | PROT_WRITE,
+		    MAP_SHARED, fd, 0);
+	if (shared == MAP_FAILED)   {
+	    fprintf(stderr, "Could not map shared memory \"%s\": %s\n", name, strerror(errno));
+	    exit(2);
+	}
+	close(fd);
+
+	/* ftruncate() zeroed it, so seq starts even */
+	memcpy(shared->magic, PROGRESS_MAGIC, sizeof(shared->magic));
+	shared->version= PROGRESS_VERSION;
+	shared->pid= getpid();
+	publish(0.0, 0.0, FALSE);
+    }
+
+    tick= 0.0;
+    if (heartbeat > 0.0)   {
+	tick= heartbeat;
+    }
+    if (shared && ((tick <= 0.0) || (tick > PROGRESS_TICK_SEC)))   {
+	tick= PROGRESS_TICK_SEC;
+    }
+    if (tick > 0.0)   {
+	sa.sa_handler= on_alarm;
+	sigaction(SIGALRM, &sa, NULL);
+	set_timer(tick);
+    }
+
+}  /* end of progress_start() */
+
+
+
+/*
+** Called from the simulation loop, when progress_pending is set
+*/
+void
+progress_poll(double elapsed_time, double work_time)
+{
+
+double now;
+
+
+    progress_pending= 0;
+    if (dump_requested)   {
+	dump_requested= 0;
+	print_line("SIGUSR1", elapsed_time, work_time);
+    }
+
+    if (shared)   {
+	publish(elapsed_time, work_time, FALSE);
+    }
+
+    if (heartbeat > 0.0)   {
+	/* The timer may fire a little early */
+	now= get_clock_value();
+	if ((now - last_beat) >= (heartbeat - tick / 2.0))   {
+	    last_beat= now;
+	    print_line("Progress", elapsed_time, work_time);
+	}
+    }
+
+}  /* end of progress_poll() */
+
+
+
+/*
+** Stop the timer. Mark the segment done and remove its name; monitors
+** that have it open still see the final values.
+*/
+void
+progress_stop(double elapsed_time, double work_time)
+{
+
+    set_timer(0.0);
+    progress_pending= 0;
+
+    if (shared)   {
+	publish(elapsed_time, work_time, TRUE);
+	munmap(shared, sizeof(progress_shm_t));
+	shm_unlink(name);
+	shared= NULL;
+    }
+    free(name);
+    name= NULL;
+
+}  /* end of progress_stop() */
+
+
+
+static void
+on_usr1(int sig)
+{
+
+    (void)sig;
+    dump_requested= 1;
+    progress_pending= 1;
+
+}  /* end of on_usr1() */
+
+
+
+static void
+on_alarm(int sig)
+{
+
+    (void)sig;
+    progress_pending= 1;
+
+}  /* end of on_alarm() */
+
+
+
+/*
+** SIGALRM every seconds. 0.0 stops it.
+*/
+static void
+set_timer(double seconds)
+{
+
+struct itimerval it;
+
+
+    it.it_interval.tv_sec= (long)seconds;
+    it.it_interval.tv_usec= (long)((seconds - (long)seconds) * 1000000.0);
+    it.it_value= it.it_interval;
+    setitimer(ITIMER_REAL, &it, NULL);
+
+}  /* end of set_timer() */
+
+
+
+static void
+print_line(const char *why, double elapsed_time, double work_time)
+{
+
+    fprintf(stderr, "%s %.1f s: %d interrupts, %d faults, %.2f of %.2f hours of work "
+	"(%.2f%%), elapsed %.2f hours\n", why, get_clock_value() - start, interrupt_cnt,
+	fault_cnt, total_work_time / 60.0, work_time / 60.0,
+	(work_time > 0.0) ? 100.0 / work_time * total_work_time : 0.0, elapsed_time / 60.0);
+
+}  /* end of print_line() */
+
+
+
+/*
+** Update the shared memory segment under its sequence lock
+*/
+static void
+publish(double elapsed_time, double work_time, int done)
+{
+
+    __atomic_store_n(&shared->seq, shared->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    shared->done= done;
+    shared->interrupt_cnt= interrupt_cnt;
+    shared->fault_cnt= fault_cnt;
+    shared->work_done= total_work_time;
+    shared->work_time= work_time;
+    shared->elapsed= elapsed_time;
+    shared->wall_sec= get_clock_value() - start;
+
+    __atomic_store_n(&shared->seq, shared->seq + 1, __ATOMIC_RELEASE);
+
+}  /* end of publish() */
@@ -0,0 +1,55 @@
+/*
+** $Id$
+**
+** Signs of life from a long run: a line on stderr for each SIGUSR1,
+** heartbeat lines every --progress seconds, and a --stats_shm shared
+** memory segment that app_stat, or any other monitor, can read while
+** the simulation runs.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _PROGRESS_H_
+#define _PROGRESS_H_
+
+#include <stdint.h>
+#include <signal.h>
+
+/*
+** The shared memory segment. The writer makes seq odd, updates the
+** fields after it, and makes seq even again. A reader copies the
+** segment and tries again, if seq was odd or changed during the copy.
+** Times are in minutes, except wall_sec.
+*/
+#define PROGRESS_MAGIC		"APPMSTA1"
+#define PROGRESS_VERSION	(1)
+
+typedef struct progress_shm_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t seq;
+    int64_t pid;
+    int32_t done;		/* 1 after the simulation ended */
+    int32_t interrupt_cnt;
+    int32_t fault_cnt;
+    int32_t unused;
+    double work_done;
+    double work_time;
+    double elapsed;
+    double wall_sec;		/* Since the simulation started */
+} progress_shm_t;
+
+
+/* Set by the signal handlers. app_model() calls progress_poll(), if it is */
+extern volatile sig_atomic_t progress_pending;
+
+void progress_start(double heartbeat_sec, char *shm_name);
+void progress_poll(double elapsed_time, double work_time);
+void progress_stop(double elapsed_time, double work_time);
+
+#endif /* _PROGRESS_H_ */
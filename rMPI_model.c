@@ -20,14 +20,22 @@
 
 #include <avl.h>
 #include "globals.h"
+#include "fmt.h"
+#include "debug.h"
+#include "perf.h"
+#include "hist.h"
+#include "events.h"
+#include "writer.h"
 #include "rMPI_model.h"
 #include "rnd.h"
 #include "data_structs.h"
 #include "input.h"
+#include "snapshot.h"
 
 
 /* Local functions */
 static int compare_nodes(const void *pa, const void *pb, void *param);
+static int compare_trace_faults(const void *pa, const void *pb, void *param);
 
 
 /* Define a struct to hold info about a node. Make sure it is a multiple of sizeof(double) */
@@ -41,19 +49,72 @@ typedef struct node_t   {
     double new_tod;	/* If reborn, when will it happen? */
 } node_t;
 
-static node_t *nodes;
-static struct avl_table *avl_nodes;
-static int read_input= FALSE;
+static SIM_LOCAL node_t *nodes;
+static SIM_LOCAL int node_cnt;
+static SIM_LOCAL int active_cnt;
+static SIM_LOCAL struct avl_table *avl_nodes;
+static SIM_LOCAL int read_input= FALSE;
 
+/* Between two rMPI() calls, this is all a snapshot needs besides the nodes */
+static SIM_LOCAL double last_app_death= 0.0;
+static SIM_LOCAL int input_first_time= TRUE;
+static SIM_LOCAL int trace_first_time= TRUE;
+static SIM_LOCAL int phase_first_time= TRUE;
 
-static nodelist_t *next_phase_kills_start= NULL;
-static nodelist_t *next_phase_kills_end= NULL;
+
+/*
+** When faults come from an input file and there are redundant nodes, we
+** only keep track of the nodes that have failed since the last interrupt.
+** Memory use depends on the number of faults, not the number of nodes.
+*/
+typedef struct trace_fault_t   {
+    int node;
+    double tod;
+    struct trace_fault_t *next;
+} trace_fault_t;
+
+static SIM_LOCAL struct avl_table *avl_trace_dead;
+static SIM_LOCAL trace_fault_t *trace_faults_start= NULL;
+static SIM_LOCAL trace_fault_t *trace_faults_end= NULL;
+static SIM_LOCAL int trace_bundles;
+static SIM_LOCAL int trace_redundant;
+
+
+static SIM_LOCAL nodelist_t *next_phase_kills_start= NULL;
+static SIM_LOCAL nodelist_t *next_phase_kills_end= NULL;
+
+
+/*
+** The node array and the search tree entries stay allocated after
+** rMPI_end(), for the next run on this thread; rMPI_free() releases
+** them. Tree entries come from slabs. avl_delete() puts an entry on
+** the free list, and the avl_probe() that follows it for the same node
+** takes it back off, so a fault does not call malloc() or free().
+*/
+#define TREE_SLAB_NODES		(4096)
+
+typedef struct tree_slab_t   {
+    struct tree_slab_t *next;
+    int used;
+    struct avl_node node[TREE_SLAB_NODES];
+} tree_slab_t;
+
+static SIM_LOCAL int nodes_size= 0;
+static SIM_LOCAL tree_slab_t *slabs= NULL;
+static SIM_LOCAL tree_slab_t *slabs_end= NULL;
+static SIM_LOCAL tree_slab_t *cur_slab= NULL;
+static SIM_LOCAL struct avl_node *free_tree_nodes= NULL;
+
+static void *tree_malloc(struct libavl_allocator *allocator, size_t size);
+static void tree_free(struct libavl_allocator *allocator, void *block);
+static struct libavl_allocator tree_allocator= {tree_malloc, tree_free};
 
 
 /* Local function */
 static void process_previous_phase(double elapsed_time, double previous_app_death,
-		FILE *fp_ints, FILE *fp_faults);
+		writer_t *w_ints, writer_t *w_faults);
 static node_t *init_node_array(int num_bundles, int total_nodes, int verbose);
+static node_t *alloc_node_array(int total_nodes);
 static int find_next_node_to_die(int tree_change);
 static int soft_boot_node(int dead_node, float soft_reboot_success_rate,
 		float soft_time_to_reboot, int hotswap);
@@ -61,6 +122,13 @@ static void next_phase_kills_add(int node);
 static void wakeup_node(int node);
 static int is_bundle_dead(int dead_node);
 static int count_bundle_nodes(int bundle);
+static double rMPI_trace(int verbose, writer_t *w_ints, writer_t *w_faults,
+		double previous_app_death);
+static int trace_partner(int node);
+static int trace_faults_free(double elapsed_time, writer_t *w_faults);
+static void trace_fault_add(int node, double tod);
+static struct avl_node *tree_build(struct libavl_allocator *alloc, int *order, int num,
+		int *height);
 #undef LEGACY
 #define LEGACY
 #ifdef LEGACY
@@ -78,80 +146,180 @@ rMPI_init(int num_bundles, int total_nodes, FILE *fp_input, int verbose)
 {
 
 
-    /* Allocate memory for the nodes and initialize it */
-    nodes= init_node_array(num_bundles, total_nodes, verbose);
-    if (init_input(fp_input, num_bundles))   {
+    /*
+    ** Faults on all nodes, including redundant ones, are read from the
+    ** input file, if there is one. There is no need for the node array then.
+    */
+    if (init_input(fp_input, total_nodes))   {
 	read_input= TRUE;
+	trace_bundles= num_bundles;
+	trace_redundant= total_nodes - num_bundles;
+	avl_trace_dead= avl_create(compare_trace_faults, NULL, NULL);
+    } else   {
+	/* Allocate memory for the nodes and initialize it */
+	nodes= init_node_array(num_bundles, total_nodes, verbose);
+	node_cnt= total_nodes;
+	active_cnt= num_bundles;
     }
 
 }  /* end of rMPI_init() */
 
 
 
+/*
+** Free the search trees and lists of a run, so the next rMPI_init() on
+** this thread starts over. A run that ended with an error may have left
+** things half done. The node array and the tree entries are kept for
+** the next run.
+*/
+void
+rMPI_end(void)
+{
+
+nodelist_t *list;
+nodelist_t *next;
+trace_fault_t *fault;
+trace_fault_t *next_fault;
+
+
+    if (avl_nodes)   {
+	/* Only the table itself came from malloc(). The entries go back to the slabs. */
+	free(avl_nodes);
+	avl_nodes= NULL;
+    }
+    free_tree_nodes= NULL;
+    for (cur_slab= slabs; cur_slab; cur_slab= cur_slab->next)   {
+	cur_slab->used= 0;
+    }
+    cur_slab= slabs;
+    node_cnt= 0;
+    active_cnt= 0;
+
+    for (list= next_phase_kills_start; list; list= next)   {
+	next= list->next;
+	free(list);
+    }
+    next_phase_kills_start= NULL;
+    next_phase_kills_end= NULL;
+
+    if (avl_trace_dead)   {
+	avl_destroy(avl_trace_dead, NULL);
+	avl_trace_dead= NULL;
+    }
+    for (fault= trace_faults_start; fault; fault= next_fault)   {
+	next_fault= fault->next;
+	free(fault);
+    }
+    trace_faults_start= NULL;
+    trace_faults_end= NULL;
+
+    read_input= FALSE;
+    last_app_death= 0.0;
+    input_first_time= TRUE;
+    trace_first_time= TRUE;
+    phase_first_time= TRUE;
+
+}  /* end of rMPI_end() */
+
+
+
+/*
+** Release the memory rMPI_end() keeps. Call it after rMPI_end().
+*/
+void
+rMPI_free(void)
+{
+
+tree_slab_t *next;
+
+
+    while (slabs)   {
+	next= slabs->next;
+	free(slabs);
+	slabs= next;
+    }
+    slabs_end= NULL;
+    cur_slab= NULL;
+    free_tree_nodes= NULL;
+
+    free(nodes);
+    nodes= NULL;
+    nodes_size= 0;
+
+}  /* end of rMPI_free() */
+
+
+
 /*
 ** This function determines which nodes die and when. It returns the time the app
 ** dies next time.
 */
 double
-rMPI(int verbose, FILE *fp_ints, FILE *fp_faults, double elapsed_time,
+rMPI(int verbose, writer_t *w_ints, writer_t *w_faults, double elapsed_time,
 	float soft_time_to_reboot, float soft_reboot_success_rate,
 	int hotswap)
 {
 
-static double previous_app_death= 0.0;
 double next_app_death;
 int dead_node;
 int wake;
 int rc;
+int timer;
 
 
+    timer= perf_switch(PERF_RMPI);
     calls_rMPI++;
     /*
-    ** If we are reading the fault times from a file, make sure the fault times
-    ** are ascending and return the next value.
+    ** If we are reading the fault times from a file, return the next value.
+    ** read_next() makes sure the fault times are ascending.
     */
-    if (read_input)   {
-	static int first_time= TRUE;
+    if (read_input && (trace_redundant > 0))   {
+	next_app_death= rMPI_trace(verbose, w_ints, w_faults, last_app_death);
+	last_app_death= next_app_death;
+	perf_switch(timer);
+	return next_app_death;
+    }
 
-	next_app_death= read_next(verbose);
+    if (read_input)   {
+	perf_switch(PERF_INPUT);
+	next_app_death= read_next(verbose, &dead_node);
+	perf_switch(PERF_RMPI);
 	if (next_app_death < 0)   {
-	    fprintf(stderr, "ERROR: Input file terminated early or has error!\n");
-	    exit(8);
+	    sim_error(8, "ERROR: Input file terminated early or has error!\n");
 	}
 
-	if (next_app_death < previous_app_death)   {
-	    fprintf(stderr, "ERROR: Fault times read from input file are not ascending!\n");
-	    exit(8);
+	if (input_first_time)   {
+	    input_first_time= FALSE;
+	    /*
+	    ** Don't count the first fault. We'll read one extra fault after the app
+	    ** has finished and count that instead.
+	    ** The input file must span a time longer than the application run time.
+	    */
 	} else   {
-	    if (first_time)   {
-		first_time= FALSE;
-		/*
-		** Don't count the first fault. We'll read one extra fault after the app
-		** has finished and count that instead.
-		** The input file must span a time longer than the application run time.
-		*/
-	    } else   {
-		fault_cnt++;
-		node_failure_cnt++;
-		total_repaired++;
-		if (fp_faults)   {
-		    fprintf(fp_faults, "%15.3f\n", next_app_death);
-		}
+	    fault_cnt++;
+	    node_failure_cnt++;
+	    total_repaired++;
+	    hist_fault(next_app_death);
+	    if (w_faults)   {
+		writer_fault(w_faults, next_app_death);
+	    }
 
-		/* FIXME: Once we allow redundant nodes with an input fault file, this needs to move. */
-		if (fp_ints)   {
-		    fprintf(fp_ints, "%15.3f %d\n", previous_app_death, 1);
-		}
+	    /* Without redundant nodes, every fault is an interrupt. rMPI_trace() does -r */
+	    hist_interrupt(last_app_death, 1);
+	    event_interrupt(last_app_death, 1);
+	    if (w_ints)   {
+		writer_interrupt(w_ints, last_app_death, 1);
 	    }
-	    previous_app_death= next_app_death;
-	    return next_app_death;
 	}
+	last_app_death= next_app_death;
+	perf_switch(timer);
+	return next_app_death;
     }
 
 
 
     /* Process the faults that occured in the last phase. */
-    process_previous_phase(elapsed_time, previous_app_death, fp_ints, fp_faults);
+    process_previous_phase(elapsed_time, last_app_death, w_ints, w_faults);
 
 
     /*
@@ -172,14 +340,13 @@ int rc;
 	    break;
 	}
     }
-    if (verbose > 4)   {
-	fprintf(stderr, "# rMPI        Application dies at time %12.1f\" Time since last death %12.1f\"\n",
-	    previous_app_death + next_app_death, next_app_death);
-    }
+    TRACE5(verbose, "# rMPI        Application dies at time %12.1f\" Time since last death %12.1f\"\n",
+	last_app_death + next_app_death, next_app_death);
 
-    assert(next_app_death >= previous_app_death);
-    previous_app_death= next_app_death;
+    assert(next_app_death >= last_app_death);
+    last_app_death= next_app_death;
 
+    perf_switch(timer);
     return next_app_death;
 
 }  /* end of rMPI() */
@@ -191,7 +358,7 @@ int rc;
 ** during the previous phase.
 */
 int
-count_dead_nodes(double elapsed_time, FILE *fp_faults)
+count_dead_nodes(double elapsed_time, writer_t *w_faults)
 {
 
 int dead_nodes;
@@ -199,14 +366,19 @@ nodelist_t *list;
 nodelist_t *next;
 
 
+    if (read_input)   {
+	return trace_faults_free(elapsed_time, w_faults);
+    }
+
     dead_nodes= fault_cnt;
     list= next_phase_kills_start;
     while (list)   {
         if (nodes[list->node].tod <= elapsed_time)   {
             fault_cnt++;
             node_failure_cnt++;
-	    if (fp_faults)   {
-		fprintf(fp_faults, "%15.3f\n", nodes[list->node].tod);
+	    hist_fault(nodes[list->node].tod);
+	    if (w_faults)   {
+		writer_fault(w_faults, nodes[list->node].tod);
 	    }
         }
 
@@ -223,6 +395,171 @@ nodelist_t *next;
 
 
 
+/*
+** Save the state between two rMPI() calls in a snapshot. The nodes are
+** followed by their IDs in search tree order, so rMPI_load() can rebuild
+** the tree without sorting. With an input file, the position in the
+** input is the number of faults read from it.
+*/
+void
+rMPI_save(FILE *fp)
+{
+
+struct avl_traverser traverser;
+node_t *current;
+nodelist_t *list;
+trace_fault_t *fault;
+int *order;
+int cnt;
+int i;
+
+
+    snap_put(fp, &read_input, sizeof(read_input));
+    snap_put(fp, &input_first_time, sizeof(input_first_time));
+    snap_put(fp, &trace_first_time, sizeof(trace_first_time));
+    snap_put(fp, &phase_first_time, sizeof(phase_first_time));
+    snap_put(fp, &last_app_death, sizeof(last_app_death));
+
+    if (read_input)   {
+	snap_put(fp, &read_input_accepted, sizeof(read_input_accepted));
+	snap_put(fp, &trace_bundles, sizeof(trace_bundles));
+	snap_put(fp, &trace_redundant, sizeof(trace_redundant));
+	cnt= 0;
+	for (fault= trace_faults_start; fault; fault= fault->next)   {
+	    cnt++;
+	}
+	snap_put(fp, &cnt, sizeof(cnt));
+	for (fault= trace_faults_start; fault; fault= fault->next)   {
+	    snap_put(fp, &fault->node, sizeof(fault->node));
+	    snap_put(fp, &fault->tod, sizeof(fault->tod));
+	}
+	return;
+    }
+
+    snap_put(fp, &node_cnt, sizeof(node_cnt));
+    snap_put(fp, &active_cnt, sizeof(active_cnt));
+    snap_put(fp, nodes, node_cnt * sizeof(node_t));
+
+    order= (int *)malloc(node_cnt * sizeof(int));
+    if (order == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    i= 0;
+    current= avl_t_first(&traverser, avl_nodes);
+    while (current)   {
+	order[i++]= current->ID;
+	current= avl_t_next(&traverser);
+    }
+    snap_put(fp, order, node_cnt * sizeof(int));
+    free(order);
+
+    cnt= 0;
+    for (list= next_phase_kills_start; list; list= list->next)   {
+	cnt++;
+    }
+    snap_put(fp, &cnt, sizeof(cnt));
+    for (list= next_phase_kills_start; list; list= list->next)   {
+	snap_put(fp, &list->node, sizeof(list->node));
+    }
+
+}  /* end of rMPI_save() */
+
+
+
+/*
+** Load what rMPI_save() wrote, instead of calling rMPI_init(). The
+** number of nodes and the input must be the same as when the snapshot
+** was taken. The input is read up to where the snapshot left it.
+*/
+void
+rMPI_load(FILE *fp, int num_bundles, int total_nodes, FILE *fp_input)
+{
+
+int saved_input;
+int *order;
+int height;
+int consumed;
+int cnt;
+int node;
+int timer;
+int i;
+double tod;
+
+
+    snap_get(fp, &saved_input, sizeof(saved_input));
+    if (saved_input != (fp_input != NULL))   {
+	sim_error(8, "ERROR: The snapshot was taken %s --input\n", saved_input ? "with" : "without");
+    }
+    snap_get(fp, &input_first_time, sizeof(input_first_time));
+    snap_get(fp, &trace_first_time, sizeof(trace_first_time));
+    snap_get(fp, &phase_first_time, sizeof(phase_first_time));
+    snap_get(fp, &last_app_death, sizeof(last_app_death));
+
+    if (saved_input)   {
+	snap_get(fp, &consumed, sizeof(consumed));
+	snap_get(fp, &trace_bundles, sizeof(trace_bundles));
+	snap_get(fp, &trace_redundant, sizeof(trace_redundant));
+	if ((trace_bundles != num_bundles) || (trace_redundant != (total_nodes - num_bundles)))   {
+	    sim_error(8, "ERROR: The snapshot was taken with -n %d -r %d\n", trace_bundles,
+		trace_redundant);
+	}
+
+	read_input= init_input(fp_input, total_nodes);
+	avl_trace_dead= avl_create(compare_trace_faults, NULL, NULL);
+	snap_get(fp, &cnt, sizeof(cnt));
+	for (i= 0; i < cnt; i++)   {
+	    snap_get(fp, &node, sizeof(node));
+	    snap_get(fp, &tod, sizeof(tod));
+	    trace_fault_add(node, tod);
+	}
+
+	timer= perf_switch(PERF_INPUT);
+	for (i= 0; i < consumed; i++)   {
+	    if (read_next(0, &node) < 0)   {
+		sim_error(8, "ERROR: The input ends before the point the snapshot was taken\n");
+	    }
+	}
+	perf_switch(timer);
+	return;
+    }
+
+    snap_get(fp, &node_cnt, sizeof(node_cnt));
+    snap_get(fp, &active_cnt, sizeof(active_cnt));
+    if ((node_cnt != total_nodes) || (active_cnt != num_bundles))   {
+	sim_error(8, "ERROR: The snapshot was taken with -n %d -r %d\n", active_cnt,
+	    node_cnt - active_cnt);
+    }
+
+    nodes= alloc_node_array(node_cnt);
+    order= (int *)malloc(node_cnt * sizeof(int));
+    if (order == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    snap_get(fp, nodes, node_cnt * sizeof(node_t));
+    snap_get(fp, order, node_cnt * sizeof(int));
+
+    /* The tree needs them in strictly ascending tod order */
+    for (i= 0; i < node_cnt; i++)   {
+	if ((order[i] < 0) || (order[i] >= node_cnt) ||
+		((i > 0) && !(nodes[order[i - 1]].tod < nodes[order[i]].tod)))   {
+	    sim_error(8, "ERROR: Snapshot has the nodes out of order\n");
+	}
+    }
+    avl_nodes= avl_create(compare_nodes, NULL, &tree_allocator);
+    avl_nodes->avl_root= tree_build(avl_nodes->avl_alloc, order, node_cnt, &height);
+    avl_nodes->avl_count= node_cnt;
+    free(order);
+
+    snap_get(fp, &cnt, sizeof(cnt));
+    for (i= 0; i < cnt; i++)   {
+	snap_get(fp, &node, sizeof(node));
+	next_phase_kills_add(node);
+    }
+
+}  /* end of rMPI_load() */
+
+
+
 /*
 ** -----------------------------------------------------------------------------
 ** Local functions
@@ -231,17 +568,175 @@ nodelist_t *next;
 
 
 
+/*
+** Faults are read from an input file and there are redundant nodes.
+** Nodes fail when the input file says so. The application is interrupted
+** when the last live node of a bundle fails. Like the random fault
+** generator, all failed nodes are replaced when the application restarts.
+*/
+static double
+rMPI_trace(int verbose, writer_t *w_ints, writer_t *w_faults, double previous_app_death)
+{
+
+int node;
+int partner;
+int dead_nodes;
+double t;
+trace_fault_t key;
+
+
+    if (trace_first_time)   {
+	trace_first_time= FALSE;
+    } else   {
+	/* All the nodes that failed during the previous phase have been replaced */
+	dead_nodes= trace_faults_free(previous_app_death, w_faults);
+	total_repaired= total_repaired + dead_nodes;
+
+	/* At least the node that caused the interrupt must have died */
+	assert(dead_nodes > 0);
+	hist_interrupt(previous_app_death, dead_nodes);
+	event_interrupt(previous_app_death, dead_nodes);
+	if (w_ints)   {
+	    writer_interrupt(w_ints, previous_app_death, dead_nodes);
+	}
+    }
+
+    while (TRUE)   {
+	perf_switch(PERF_INPUT);
+	t= read_next(verbose, &node);
+	perf_switch(PERF_RMPI);
+	if (t < 0)   {
+	    sim_error(8, "ERROR: Input file terminated early or has error!\n");
+	}
+
+	key.node= node;
+	perf_tree_steps++;
+	if (avl_find(avl_trace_dead, &key))   {
+	    /* This node is already dead and waiting for the next restart */
+	    continue;
+	}
+
+	trace_fault_add(node, t);
+
+	/* The bundle dies, if there is no live partner left */
+	partner= trace_partner(node);
+	key.node= partner;
+	perf_tree_steps++;
+	if ((partner < 0) || avl_find(avl_trace_dead, &key))   {
+	    break;
+	}
+    }
+
+    TRACE5(verbose, "# rMPI        Application dies at time %12.1f\" (node %d)\n", t, node);
+
+    return t;
+
+}  /* end of rMPI_trace() */
+
+
+
+/*
+** Remember a node from the input file that is dead until the next restart
+*/
+static void
+trace_fault_add(int node, double tod)
+{
+
+trace_fault_t *fault;
+
+
+    fault= (trace_fault_t *)malloc(sizeof(trace_fault_t));
+    if (fault == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    perf_allocs++;
+    fault->node= node;
+    fault->tod= tod;
+    fault->next= NULL;
+    if (trace_faults_end)   {
+	trace_faults_end->next= fault;
+    } else   {
+	trace_faults_start= fault;
+    }
+    trace_faults_end= fault;
+    avl_insert(avl_trace_dead, fault);
+    perf_tree_inserts++;
+
+}  /* end of trace_fault_add() */
+
+
+
+/*
+** Return the redundant partner of a node, or -1 if it has none.
+** Redundant nodes are assigned the same way init_node_array() does it.
+*/
+static int
+trace_partner(int node)
+{
+
+    if (node >= trace_bundles)   {
+	return node - trace_bundles;
+    } else if (node < trace_redundant)   {
+	return node + trace_bundles;
+    }
+
+    return -1;
+
+}  /* end of trace_partner() */
+
+
+
+/*
+** Count the nodes from the input file that failed at or before elapsed_time
+** and forget about all of them. Returns the number counted.
+*/
+static int
+trace_faults_free(double elapsed_time, writer_t *w_faults)
+{
+
+int dead_nodes;
+trace_fault_t *fault;
+trace_fault_t *next;
+
+
+    dead_nodes= 0;
+    fault= trace_faults_start;
+    while (fault)   {
+	if (fault->tod <= elapsed_time)   {
+	    fault_cnt++;
+	    node_failure_cnt++;
+	    dead_nodes++;
+	    hist_fault(fault->tod);
+	    if (w_faults)   {
+		writer_fault(w_faults, fault->tod);
+	    }
+	}
+
+	avl_delete(avl_trace_dead, fault);
+	perf_tree_deletes++;
+	next= fault->next;
+	free(fault);
+	fault= next;
+    }
+    trace_faults_start= NULL;
+    trace_faults_end= NULL;
+
+    return dead_nodes;
+
+}  /* end of trace_faults_free() */
+
+
+
 /*
 ** During the previous phase a bunch of nodes died. This function marks and counts them,
 ** then rejuvenates them by assigning those nodes a new tod.
 */
 static void
 process_previous_phase(double elapsed_time, double previous_app_death,
-	FILE *fp_ints, FILE *fp_faults)
+	writer_t *w_ints, writer_t *w_faults)
 {
 
 int dead_nodes;
-static int first_time= TRUE;
 nodelist_t *list;
 nodelist_t *next;
 node_t *current;
@@ -254,8 +749,8 @@ node_t **new;
     assert(elapsed_time >= previous_app_death);
 
 
-    if (first_time)   {
-	first_time= FALSE;
+    if (phase_first_time)   {
+	phase_first_time= FALSE;
     } else   {
 	/*
 	** Since last time nodes might have died that did not cause an
@@ -273,21 +768,27 @@ node_t **new;
 	while (list)   {
 	    assert(nodes[list->node].dead);
 	    node_failure_cnt++;
-	    if (fp_faults)   {
-		fprintf(fp_faults, "%15.3f\n", nodes[list->node].tod);
+	    hist_fault(nodes[list->node].tod);
+	    if (w_faults)   {
+		writer_fault(w_faults, nodes[list->node].tod);
 	    }
 	    fault_cnt++;
 
 	    current= &(nodes[list->node]);
 	    old= avl_delete(avl_nodes, current);
 	    assert(old);
+	    perf_tree_deletes++;
 
 	    /* Only reset tod for failed nodes */
 	    do   {
 		/* See if we can insert it (must have unique tod) */
 		current->tod= next_node_failure(elapsed_time);
 		new= (node_t **)avl_probe(avl_nodes, current);
+		if ((*new)->ID != list->node)   {
+		    perf_tod_retries++;
+		}
 	    } while ((*new)->ID != list->node);
+	    perf_tree_inserts++;
 
 	    current->dead= FALSE;
 	    total_repaired++;
@@ -302,8 +803,11 @@ node_t **new;
 	/* There should always be at least one dead node */
 	assert(fault_cnt - dead_nodes);
 
-	if (fp_ints)   {
-	    fprintf(fp_ints, "%15.3f %d\n", previous_app_death, fault_cnt - dead_nodes);
+	hist_interrupt(previous_app_death, fault_cnt - dead_nodes);
+
+	event_interrupt(previous_app_death, fault_cnt - dead_nodes);
+	if (w_ints)   {
+	    writer_interrupt(w_ints, previous_app_death, fault_cnt - dead_nodes);
 	}
     }
 
@@ -316,7 +820,7 @@ find_next_node_to_die(int tree_change)
 {
 
 node_t *current;
-static struct avl_traverser traverser;
+static SIM_LOCAL struct avl_traverser traverser;
 
 
     if (tree_change >= 0)   {
@@ -327,12 +831,14 @@ static struct avl_traverser traverser;
 	/* Pick up from where we left off the last time */
 	current= avl_t_next(&traverser);
     }
+    perf_tree_steps++;
 
     /* Now find the node with the lowest tod.  */
     while (current->dead == TRUE)   {
 	/* Reject it, if it is already dead */
 	current= avl_t_next(&traverser);
 	assert(current);
+	perf_tree_steps++;
     }
 
     return current->ID;
@@ -359,6 +865,7 @@ node_t test;
 	bundle_cnt= count_bundle_nodes(nodes[dead_node].active);
 	if (bundle_cnt > 1)   {
 	    /* Maybe */
+	    perf_soft_reboots++;
 	    if (rnd_probability() <= soft_reboot_success_rate)   {
 		/*
 		** Yes. During the time between original tod and tod + soft_time_to_reboot,
@@ -383,13 +890,18 @@ node_t test;
 		** 3). Keep trying until we get a time that is beyond current
 		**     and continue.
 		*/
-		do   {
+		while (TRUE)   {
 		    if (hotswap)   {
 			test.tod= next_node_failure(nodes[dead_node].rebirth);
 		    } else   {
 			test.tod= next_node_failure(0.0);
 		    }
-		} while (avl_find(avl_nodes, &test) != NULL);
+		    perf_tree_steps++;
+		    if (avl_find(avl_nodes, &test) == NULL)   {
+			break;
+		    }
+		    perf_tod_retries++;
+		}
 
 		if (test.tod <= nodes[dead_node].rebirth)   {
 		    /* Didn't make it */
@@ -454,6 +966,7 @@ node_t *current;
     */
     current= avl_delete(avl_nodes, &(nodes[node]));
     assert(current);
+    perf_tree_deletes++;
 
     /* Re-init node */
     nodes[node].dead= FALSE;
@@ -470,10 +983,10 @@ node_t *current;
     **         Treat this as an assertion within NDEBUG
     */
     new= (node_t **)avl_probe(avl_nodes, &(nodes[node]));
+    perf_tree_inserts++;
 #ifndef NDEBUG
     if ((*new)->ID != node)   {
-	fprintf(stderr, "Attempting to insert non-unique tod into search tree!\n");
-	exit(9);
+	sim_error(9, "Attempting to insert non-unique tod into search tree!\n");
     }
 #endif
 
@@ -566,10 +1079,28 @@ void *unused;
 
 
 
+
+/*
+** Failed nodes from an input file are looked up by node ID
+*/
+static int
+compare_trace_faults(const void *pa, const void *pb, void *param)
+{
+
+const trace_fault_t *a= pa;
+const trace_fault_t *b= pb;
+
+
+    (void)param;
+    return (a->node > b->node) - (a->node < b->node);
+
+}  /* end of compare_trace_faults() */
+
+
+
 /*
 ** Allocate the node structures and fill them with default values.
-** This gets called only once. alloc_node is freed at the end of
-** the program automatically.
+** This gets called once per run. rMPI_free() frees the nodes again.
 */
 static node_t *
 init_node_array(int num_bundles, int total_nodes, int verbose)
@@ -581,12 +1112,8 @@ node_t *alloc_nodes;
 node_t **current;
 
 
-    avl_nodes= avl_create(compare_nodes, NULL, NULL);
-    alloc_nodes= (node_t *)malloc(total_nodes * sizeof(node_t));
-    if (alloc_nodes == NULL)   {
-	fprintf(stderr, "Out of memory!\n");
-	exit(10);
-    }
+    avl_nodes= avl_create(compare_nodes, NULL, &tree_allocator);
+    alloc_nodes= alloc_node_array(total_nodes);
 
     /* Initialize the active nodes */
     for (i= 0; i < num_bundles; i++)   {
@@ -601,7 +1128,11 @@ node_t **current;
 	do   {
 	    alloc_nodes[i].tod= next_node_failure(0.0);
 	    current= (node_t **)avl_probe(avl_nodes, &(alloc_nodes[i]));
+	    if ((*current)->ID != i)   {
+		perf_tod_retries++;
+	    }
 	} while ((*current)->ID != i);
+	perf_tree_inserts++;
     }
 
     /* Assign redundant nodes to active nodes in round robin fashion */
@@ -613,8 +1144,7 @@ node_t **current;
 	    ** Assign a redundant-redundant node etc.
 	    */
 	    /* FIXME: It would be nice to support this */
-	    fprintf(stderr, "# rMPI        More redundant nodes than active nodes not supported yet!\n");
-	    exit(10);
+	    sim_error(10, "# rMPI        More redundant nodes than active nodes not supported yet!\n");
 	} else   {
 	    alloc_nodes[active_node % num_bundles].partner= i;	/* Tell the active node where we are */
 	    alloc_nodes[i].ID= i;
@@ -628,20 +1158,21 @@ node_t **current;
 	    do   {
 		alloc_nodes[i].tod= next_node_failure(0.0);
 		current= (node_t **)avl_probe(avl_nodes, &(alloc_nodes[i]));
+		if ((*current)->ID != i)   {
+		    perf_tod_retries++;
+		}
 	    } while ((*current)->ID != i);
+	    perf_tree_inserts++;
 
-	    if (verbose > 0)   {
-		fprintf(stderr, "# rMPI        Active node %5d has node %5d as redundant\n", active_node % num_bundles, i);
-	    }
+	    TRACE1(verbose, "# rMPI        Active node %5d has node %5d as redundant\n", active_node % num_bundles, i);
 	}
 	active_node++;
     }
 
 #ifndef NDEBUG
     if (avl_count(avl_nodes) != (unsigned)total_nodes)   {
-	fprintf(stderr, "%ld items in table does not match total number of nodes %d\n",
+	sim_error(10, "%ld items in table does not match total number of nodes %d\n",
 	    (long int)avl_count(avl_nodes), total_nodes);
-	exit(10);
     }
 #endif
 
@@ -651,6 +1182,131 @@ node_t **current;
 
 
 
+/*
+** The node array for total_nodes nodes. The one of the previous run on
+** this thread is used again, if it is large enough.
+*/
+static node_t *
+alloc_node_array(int total_nodes)
+{
+
+    if (total_nodes > nodes_size)   {
+	free(nodes);
+	nodes= (node_t *)malloc(total_nodes * sizeof(node_t));
+	if (nodes == NULL)   {
+	    nodes_size= 0;
+	    sim_error(10, "Out of memory!\n");
+	}
+	nodes_size= total_nodes;
+    }
+
+    return nodes;
+
+}  /* end of alloc_node_array() */
+
+
+
+/*
+** Search tree entries from the free list, or the slabs. The table
+** itself is the only other thing avl_create() allocates.
+*/
+static void *
+tree_malloc(struct libavl_allocator *allocator, size_t size)
+{
+
+struct avl_node *t;
+tree_slab_t *slab;
+
+
+    (void)allocator;
+    if (size != sizeof(struct avl_node))   {
+	return malloc(size);
+    }
+
+    if (free_tree_nodes)   {
+	t= free_tree_nodes;
+	free_tree_nodes= t->avl_link[0];
+	return t;
+    }
+
+    if (cur_slab && (cur_slab->used >= TREE_SLAB_NODES))   {
+	cur_slab= cur_slab->next;
+    }
+    if (cur_slab == NULL)   {
+	slab= (tree_slab_t *)malloc(sizeof(tree_slab_t));
+	if (slab == NULL)   {
+	    sim_error(10, "Out of memory!\n");
+	}
+	slab->next= NULL;
+	slab->used= 0;
+	if (slabs_end)   {
+	    slabs_end->next= slab;
+	} else   {
+	    slabs= slab;
+	}
+	slabs_end= slab;
+	cur_slab= slab;
+    }
+
+    return &cur_slab->node[cur_slab->used++];
+
+}  /* end of tree_malloc() */
+
+
+
+/*
+** Only avl_delete() frees anything; always a tree entry
+*/
+static void
+tree_free(struct libavl_allocator *allocator, void *block)
+{
+
+struct avl_node *t= block;
+
+
+    (void)allocator;
+    t->avl_link[0]= free_tree_nodes;
+    free_tree_nodes= t;
+
+}  /* end of tree_free() */
+
+
+
+/*
+** Build a balanced search tree of the nodes in order[], which are sorted
+** by tod, in O(num). The middle node is the root; the left half is never
+** smaller than the right half, so their heights differ by at most one.
+*/
+static struct avl_node *
+tree_build(struct libavl_allocator *alloc, int *order, int num, int *height)
+{
+
+struct avl_node *t;
+int left_height;
+int right_height;
+
+
+    if (num <= 0)   {
+	*height= 0;
+	return NULL;
+    }
+
+    t= (struct avl_node *)alloc->libavl_malloc(alloc, sizeof(struct avl_node));
+    if (t == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    t->avl_link[0]= tree_build(alloc, order, num / 2, &left_height);
+    t->avl_data= &nodes[order[num / 2]];
+    t->avl_link[1]= tree_build(alloc, order + num / 2 + 1, num - num / 2 - 1, &right_height);
+    t->avl_balance= right_height - left_height;
+    *height= 1 + ((left_height > right_height) ? left_height : right_height);
+
+    return t;
+
+}  /* end of tree_build() */
+
+
+
 #ifdef LEGACY
 /*
 ** Sort the list of nodes to be rejuvenated. The only reason to do this is to
@@ -685,8 +1341,7 @@ nodelist_t *next;
 	    search= new_list_start;
 	    while (search)   {
 		if (search->node == element->node)   {
-		    fprintf(stderr, "Can't have duplicate node IDs! %d\n", element->node);
-		    exit(1);
+		    sim_error(1, "Can't have duplicate node IDs! %d\n", element->node);
 		}
 
 		if (search->node > element->node)   {
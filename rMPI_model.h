@@ -18,10 +18,14 @@
 void rMPI_init(int num_bundles, int total_nodes, FILE *fp_input, int verbose);
 
 double
-rMPI(int verbose, FILE *fp, FILE *fp_faults, double elapsed_time,
+rMPI(int verbose, writer_t *w_ints, writer_t *w_faults, double elapsed_time,
 	float soft_time_to_reboot, float soft_reboot_success_rate,
 	int hotswap);
 
-int count_dead_nodes(double elapsed_time, FILE *fp_faults);
+int count_dead_nodes(double elapsed_time, writer_t *w_faults);
+void rMPI_save(FILE *fp);
+void rMPI_load(FILE *fp, int num_bundles, int total_nodes, FILE *fp_input);
+void rMPI_end(void);
+void rMPI_free(void);
 
 #endif /* _RMPI_MODEL_H */
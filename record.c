@@ -0,0 +1,452 @@
+/*
+** $Id$
+**
+** Structured output of the banner and the report, for sweep harnesses
+** that would otherwise have to scrape the text. Each record is built
+** in memory and written out in one piece when it ends, so a sweep
+** streams its records out as the results come in.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "globals.h"
+#include "record.h"
+
+
+typedef struct strbuf_t   {
+    char *data;
+    size_t len;
+    size_t size;
+} strbuf_t;
+
+typedef struct rec_t   {
+    strbuf_t head;		/* CSV column names */
+    strbuf_t values;		/* CSV values, or the JSON text */
+    char section[64];
+    int in_section;
+    int top_fields;		/* Fields (and sections) at the top level */
+    int fields;			/* Fields in the current section */
+} rec_t;
+
+
+static FILE *rec_fp= NULL;
+static int rec_format= FORMAT_TEXT;
+static int header_done;
+static rec_t cur;
+static rec_t kept;
+static int have_kept;
+
+
+/* Local functions */
+static void rec_clear(rec_t *r);
+static void rec_copy(rec_t *to, rec_t *from);
+static void add_key(const char *key);
+static void put_str(strbuf_t *b, const char *s, size_t len);
+static void put_escaped(strbuf_t *b, const char *s);
+static void write_buf(strbuf_t *b);
+
+
+
+/*
+** Returns FORMAT_TEXT, FORMAT_JSON, or FORMAT_CSV, or -1 for an
+** unknown name
+*/
+int
+record_parse_format(const char *name)
+{
+
+    if (strcmp(name, "text") == 0)   {
+	return FORMAT_TEXT;
+    } else if (strcmp(name, "json") == 0)   {
+	return FORMAT_JSON;
+    } else if (strcmp(name, "csv") == 0)   {
+	return FORMAT_CSV;
+    }
+
+    return -1;
+
+}  /* end of record_parse_format() */
+
+
+
+void
+record_open(FILE *fp, int format)
+{
+
+    rec_fp= fp;
+    rec_format= format;
+    header_done= FALSE;
+    have_kept= FALSE;
+    rec_clear(&cur);
+    rec_clear(&kept);
+
+}  /* end of record_open() */
+
+
+
+/*
+** TRUE if the banner and the report should be records instead of text
+*/
+int
+record_active(void)
+{
+    return rec_format != FORMAT_TEXT;
+}  /* end of record_active() */
+
+
+
+void
+record_close(void)
+{
+
+    if (!record_active())   {
+	return;
+    }
+
+    if (fflush(rec_fp) != 0)   {
+	fprintf(stderr, "Write of results failed: %s\n", strerror(errno));
+	exit(2);
+    }
+
+    free(cur.head.data);
+    free(cur.values.data);
+    free(kept.head.data);
+    free(kept.values.data);
+    memset(&cur, 0, sizeof(cur));
+    memset(&kept, 0, sizeof(kept));
+    rec_format= FORMAT_TEXT;
+
+}  /* end of record_close() */
+
+
+
+void
+record_begin(void)
+{
+
+    if (have_kept)   {
+	rec_copy(&cur, &kept);
+    } else   {
+	rec_clear(&cur);
+	if (rec_format == FORMAT_JSON)   {
+	    put_str(&cur.values, "{", 1);
+	}
+    }
+
+}  /* end of record_begin() */
+
+
+
+/*
+** The fields that follow belong to this section
+*/
+void
+record_section(const char *name)
+{
+
+    if (rec_format == FORMAT_JSON)   {
+	if (cur.in_section)   {
+	    put_str(&cur.values, "}", 1);
+	}
+	if (cur.top_fields > 0)   {
+	    put_str(&cur.values, ",", 1);
+	}
+	put_escaped(&cur.values, name);
+	put_str(&cur.values, ":{", 2);
+	cur.top_fields++;
+    }
+
+    strncpy(cur.section, name, sizeof(cur.section) - 1);
+    cur.section[sizeof(cur.section) - 1]= '\0';
+    cur.in_section= TRUE;
+    cur.fields= 0;
+
+}  /* end of record_section() */
+
+
+
+void
+record_int(const char *key, int v)
+{
+
+char str[32];
+
+
+    add_key(key);
+    put_str(&cur.values, str, sprintf(str, "%d", v));
+
+}  /* end of record_int() */
+
+
+
+/*
+** Infinite and NaN values are written as JSON null, or an empty CSV field
+*/
+void
+record_double(const char *key, double v)
+{
+
+char str[RECORD_DOUBLE_SIZE];
+
+
+    if (!isfinite(v))   {
+	record_null(key);
+	return;
+    }
+
+    add_key(key);
+    put_str(&cur.values, str, record_fmt_double(str, v));
+
+}  /* end of record_double() */
+
+
+
+/*
+** Full precision, so a value read back from a record is the one that
+** was written; but without the noise digits of "%.17g", where fewer
+** digits already give the same double. Returns the length.
+*/
+int
+record_fmt_double(char *str, double v)
+{
+
+double back;
+int prec;
+int len;
+
+
+    for (prec= 15; prec < 17; prec++)   {
+	len= sprintf(str, "%.*g", prec, v);
+	back= strtod(str, NULL);
+	if (memcmp(&back, &v, sizeof(v)) == 0)   {
+	    return len;
+	}
+    }
+
+    return sprintf(str, "%.17g", v);
+
+}  /* end of record_fmt_double() */
+
+
+
+void
+record_string(const char *key, const char *s)
+{
+
+    add_key(key);
+    put_escaped(&cur.values, s);
+
+}  /* end of record_string() */
+
+
+
+void
+record_null(const char *key)
+{
+
+    add_key(key);
+    if (rec_format == FORMAT_JSON)   {
+	put_str(&cur.values, "null", 4);
+    }
+
+}  /* end of record_null() */
+
+
+
+/*
+** Write the record out
+*/
+void
+record_end(void)
+{
+
+    if (rec_format == FORMAT_JSON)   {
+	if (cur.in_section)   {
+	    put_str(&cur.values, "}", 1);
+	}
+	put_str(&cur.values, "}\n", 2);
+    } else   {
+	if (!header_done)   {
+	    put_str(&cur.head, "\n", 1);
+	    write_buf(&cur.head);
+	    header_done= TRUE;
+	}
+	put_str(&cur.values, "\n", 1);
+    }
+
+    write_buf(&cur.values);
+
+}  /* end of record_end() */
+
+
+
+void
+record_keep(void)
+{
+
+    rec_copy(&kept, &cur);
+    have_kept= TRUE;
+
+}  /* end of record_keep() */
+
+
+
+static void
+rec_clear(rec_t *r)
+{
+
+    r->head.len= 0;
+    r->values.len= 0;
+    r->section[0]= '\0';
+    r->in_section= FALSE;
+    r->top_fields= 0;
+    r->fields= 0;
+
+}  /* end of rec_clear() */
+
+
+
+static void
+rec_copy(rec_t *to, rec_t *from)
+{
+
+    rec_clear(to);
+    put_str(&to->head, from->head.data, from->head.len);
+    put_str(&to->values, from->values.data, from->values.len);
+    memcpy(to->section, from->section, sizeof(to->section));
+    to->in_section= from->in_section;
+    to->top_fields= from->top_fields;
+    to->fields= from->fields;
+
+}  /* end of rec_copy() */
+
+
+
+/*
+** Start the next field: the JSON key, or the CSV column name
+*/
+static void
+add_key(const char *key)
+{
+
+int *fields;
+
+
+    fields= cur.in_section ? &cur.fields : &cur.top_fields;
+
+    if (rec_format == FORMAT_JSON)   {
+	if (*fields > 0)   {
+	    put_str(&cur.values, ",", 1);
+	}
+	put_escaped(&cur.values, key);
+	put_str(&cur.values, ":", 1);
+    } else   {
+	if (cur.head.len > 0)   {
+	    put_str(&cur.head, ",", 1);
+	    put_str(&cur.values, ",", 1);
+	}
+	if (cur.in_section)   {
+	    put_str(&cur.head, cur.section, strlen(cur.section));
+	    put_str(&cur.head, ".", 1);
+	}
+	put_str(&cur.head, key, strlen(key));
+    }
+
+    (*fields)++;
+
+}  /* end of add_key() */
+
+
+
+static void
+put_str(strbuf_t *b, const char *s, size_t len)
+{
+
+    if ((len == 0) && (b->data != NULL))   {
+	return;
+    }
+
+    if (b->len + len + 1 > b->size)   {
+	b->size= 2 * (b->len + len + 1) + 256;
+	b->data= (char *)realloc(b->data, b->size);
+	if (b->data == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+    }
+
+    if (len > 0)   {
+	memcpy(b->data + b->len, s, len);
+    }
+    b->len= b->len + len;
+    b->data[b->len]= '\0';
+
+}  /* end of put_str() */
+
+
+
+/*
+** A JSON string, or a CSV field that is quoted if it needs to be
+*/
+static void
+put_escaped(strbuf_t *b, const char *s)
+{
+
+char str[8];
+
+
+    if (rec_format == FORMAT_CSV)   {
+	if (strpbrk(s, ",\"\r\n") == NULL)   {
+	    put_str(b, s, strlen(s));
+	    return;
+	}
+	put_str(b, "\"", 1);
+	for (; *s; s++)   {
+	    if (*s == '"')   {
+		put_str(b, "\"\"", 2);
+	    } else   {
+		put_str(b, s, 1);
+	    }
+	}
+	put_str(b, "\"", 1);
+	return;
+    }
+
+    put_str(b, "\"", 1);
+    for (; *s; s++)   {
+	if ((*s == '"') || (*s == '\\'))   {
+	    put_str(b, "\\", 1);
+	    put_str(b, s, 1);
+	} else if ((unsigned char)*s < 0x20)   {
+	    put_str(b, str, sprintf(str, "\\u%04x", (unsigned char)*s));
+	} else   {
+	    put_str(b, s, 1);
+	}
+    }
+    put_str(b, "\"", 1);
+
+}  /* end of put_escaped() */
+
+
+
+static void
+write_buf(strbuf_t *b)
+{
+
+    if (fwrite(b->data, 1, b->len, rec_fp) != b->len)   {
+	fprintf(stderr, "Write of results failed: %s\n", strerror(errno));
+	exit(2);
+    }
+
+}  /* end of write_buf() */
@@ -0,0 +1,50 @@
+/*
+** $Id$
+**
+** Structured (JSON or CSV) output of the banner and the report, one
+** record per run, or per size or window of a sweep.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _RECORD_H_
+#define _RECORD_H_
+
+#include <stdio.h>
+
+#define FORMAT_TEXT		(0)
+#define FORMAT_JSON		(1)
+#define FORMAT_CSV		(2)
+
+/*
+** A JSON record is one object per line, with an object for each
+** section. A CSV record is one line; the columns are named
+** "section.key", and the header is written before the first record.
+** All records written to a stream must have the same keys.
+*/
+int record_parse_format(const char *name);
+void record_open(FILE *fp, int format);
+int record_active(void);
+void record_close(void);
+
+void record_begin(void);
+void record_section(const char *name);
+void record_int(const char *key, int v);
+void record_double(const char *key, double v);
+void record_string(const char *key, const char *s);
+void record_null(const char *key);
+void record_end(void);
+
+/* Start every following record with the fields written so far */
+void record_keep(void);
+
+/* The shortest text that reads back as v. str needs RECORD_DOUBLE_SIZE bytes */
+#define RECORD_DOUBLE_SIZE	(32)
+int record_fmt_double(char *str, double v);
+
+#endif /* _RECORD_H_ */
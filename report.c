@@ -13,9 +13,26 @@
 **
 */
 #include <stdio.h>
+#include <stdlib.h>		/* For malloc() */
+#include <string.h>		/* For strlen() */
+#include <math.h>		/* For NAN */
+#include "globals.h"
+#include "snapshot.h"
+#include "branch.h"
 #include "report.h"
 #include "timing.h"
-#include "globals.h"
+#include "hist.h"
+#include "record.h"
+#include "perf.h"
+#include "stats.h"
+
+
+static const char *task_failure(int status);
+static const char *budget_failure(result_t *r, double work_time);
+static double extrapolate(result_t *r, double work_time);
+static void record_simulation(result_t *r, double work_time);
+static void record_performance(result_t *r, int display_perf_info, double model_time);
+static void record_count(const char *key, result_t *r, int v);
 
 
 
@@ -29,9 +46,44 @@ double total_percent= 0.0;
 double total_elapsed_time= 0.0;
 float offset;
 int num_faults;
+result_t r;
+
 
+    if (record_active())   {
+	/* Finish the record banner() started */
+	save_results(&r, elapsed_time);
+	record_simulation(&r, work_time);
+	record_double("modeled_elapsed_min", fp_input ? NAN : daly);
+	hist_record();
+	record_performance(&r, display_perf_info, model_time);
+	if (display_perf_info)   {
+	    perf_record();
+	}
+	record_end();
+	return;
+    }
 
     /* Report results */
+    if (stopped_early)   {
+	save_results(&r, elapsed_time);
+	printf("\n");
+	printf("STOPPED BY --time_budget\n");
+	printf("  Work completed         %12.2f hours (%5.2f%% of work to be done)\n",
+	    total_work_time / 60.0, 100.0 / work_time * total_work_time);
+	printf("  Elapsed so far         %12.2f hours\n", elapsed_time / 60.0);
+	if (interrupt_cnt > 0)   {
+	    printf("  Observed app. MTBI     %12.2f hours\n", (elapsed_time / interrupt_cnt) / 60.0);
+	} else   {
+	    printf("  Observed app. MTBI     %12s\n", "-");
+	}
+	if (total_work_time > 0.0)   {
+	    printf("  Extrapolated elapsed   %12.2f hours to complete all work\n",
+		extrapolate(&r, work_time) / 60.0);
+	} else   {
+	    printf("  Extrapolated elapsed   %12s (no work completed)\n", "-");
+	}
+    }
+
     printf("\n");
     printf("SIMULATION\n");
     printf("  Application completed  %12.2f hours of work (%5.2f%% of work to be done)\n",
@@ -192,6 +244,8 @@ int num_faults;
 	}
     }
 
+    hist_report();
+
     if (display_perf_info)   {
 	printf("\n");
 	printf("PROGRAM PERFORMANCE INFORMATION:\n");
@@ -207,6 +261,454 @@ int num_faults;
 		read_input_cnt, read_input_accepted, 0.0);
 	}
 	printf("  Time to model this application: %s\n", disp_time(model_time));
+	perf_report();
     }
 
 }  /* end of report_results() */
+
+
+
+
+/*
+** One line per application size for a --sizes run
+*/
+void
+report_scaling(int num_sizes, int *sizes, int *redundant, sweep_result_t *results, int *status,
+	double work_time, int display_perf_info, double model_time)
+{
+
+int i;
+result_t *r;
+
+
+    if (record_active())   {
+	for (i= 0; i < num_sizes; i++)   {
+	    r= (status[i] == 0) ? &results[i].r : NULL;
+	    record_begin();
+	    record_section("sweep");
+	    record_int("nodes", sizes[i]);
+	    if (redundant)   {
+		record_int("redundant_nodes", redundant[i]);
+	    }
+	    record_int("status", status[i]);
+	    record_double("checkpoint_interval_min", r ? results[i].tau : NAN);
+	    record_simulation(r, work_time);
+	    record_performance(r, display_perf_info, model_time);
+	    record_end();
+	}
+	return;
+    }
+
+    printf("\n");
+    printf("SCALING\n");
+    if (redundant)   {
+	printf("         Nodes   Redundant    Interval     Elapsed  Overhead  Interrupts      Faults   App. MTBI\n");
+	printf("                               (hours)     (hours)                                     (hours)\n");
+    } else   {
+	printf("         Nodes    Interval     Elapsed  Overhead  Interrupts      Faults   App. MTBI\n");
+	printf("                   (hours)     (hours)                                     (hours)\n");
+    }
+    for (i= 0; i < num_sizes; i++)   {
+	printf("  %12d", sizes[i]);
+	if (redundant)   {
+	    printf(" %11d", redundant[i]);
+	}
+	if (status[i] != 0)   {
+	    printf(" %s\n", task_failure(status[i]));
+	    continue;
+	}
+	r= &results[i].r;
+	if (r->stopped_early)   {
+	    printf(" %s\n", budget_failure(r, work_time));
+	    continue;
+	}
+	printf(" %11.2f %11.2f %8.2f%% %11d %11d", results[i].tau / 60.0,
+	    r->elapsed_time / 60.0, (100.0 / work_time * r->elapsed_time) - 100.0,
+	    r->interrupt_cnt, r->fault_cnt);
+	if (r->interrupt_cnt > 0)   {
+	    printf(" %11.2f\n", (r->elapsed_time / r->interrupt_cnt) / 60.0);
+	} else   {
+	    printf(" %11s\n", "-");
+	}
+    }
+
+    if (display_perf_info)   {
+	printf("\n");
+	printf("PROGRAM PERFORMANCE INFORMATION:\n");
+	printf("  Time to model all sizes: %s\n", disp_time(model_time));
+    }
+
+}  /* end of report_scaling() */
+
+
+
+/*
+** Summarize the windows of an --offset_every or --offset_random run.
+** Windows that ran out of input, or out of --time_budget, before the
+** work was done are counted, but left out of the statistics.
+*/
+void
+report_windows(int num_windows, double *offsets, sweep_result_t *results, int *status,
+	double work_time, int display_perf_info, double model_time)
+{
+
+double *elapsed;
+stats_t stats;
+double mean, stddev, ci95;
+double interrupts;
+int num;
+int i;
+result_t *r;
+
+
+    if (record_active())   {
+	for (i= 0; i < num_windows; i++)   {
+	    r= (status[i] == 0) ? &results[i].r : NULL;
+	    record_begin();
+	    record_section("sweep");
+	    record_double("offset_min", offsets[i]);
+	    record_int("status", status[i]);
+	    record_double("checkpoint_interval_min", r ? results[i].tau : NAN);
+	    record_simulation(r, work_time);
+	    record_performance(r, display_perf_info, model_time);
+	    record_end();
+	}
+	return;
+    }
+
+    elapsed= (double *)malloc(num_windows * sizeof(double));
+    if (elapsed == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    num= 0;
+    stats_init(&stats);
+    interrupts= 0.0;
+    for (i= 0; i < num_windows; i++)   {
+	if ((status[i] != 0) || results[i].r.stopped_early)   {
+	    continue;
+	}
+	elapsed[num]= results[i].r.elapsed_time;
+	stats_add(&stats, elapsed[num]);
+	interrupts= interrupts + results[i].r.interrupt_cnt;
+	num++;
+    }
+
+    printf("\n");
+    printf("WINDOWS\n");
+    printf("  Windows simulated      %12d (offsets %.2f to %.2f hours)\n", num_windows,
+	offsets[0] / 60.0, offsets[num_windows - 1] / 60.0);
+    printf("  Windows completed      %12d\n", num);
+    for (i= 0; i < num_windows; i++)   {
+	if (status[i] != 0)   {
+	    printf("  Window at %12.2f hours %s\n", offsets[i] / 60.0, task_failure(status[i]));
+	} else if (results[i].r.stopped_early)   {
+	    printf("  Window at %12.2f hours %s\n", offsets[i] / 60.0,
+		budget_failure(&results[i].r, work_time));
+	}
+    }
+
+    if (num > 0)   {
+	stats_sort(elapsed, num);
+	mean= stats_mean(&stats);
+	stddev= stats_stddev(&stats);
+	ci95= stats_ci95(&stats);
+
+	printf("  Elapsed time minimum   %12.2f hours (Overhead is %5.2f%%)\n", elapsed[0] / 60.0,
+	    (100.0 / work_time * elapsed[0]) - 100.0);
+	printf("  Elapsed time mean      %12.2f hours (Overhead is %5.2f%%)\n", mean / 60.0,
+	    (100.0 / work_time * mean) - 100.0);
+	if (num > 1)   {
+	    printf("  Elapsed time std dev   %12.2f hours (95%% confidence of the mean +/- %.2f)\n",
+		stddev / 60.0, ci95 / 60.0);
+	} else   {
+	    printf("  Elapsed time std dev   %12.2f hours\n", stddev / 60.0);
+	}
+	printf("  Elapsed time 10th pct  %12.2f hours\n",
+	    stats_percentile(elapsed, num, 10.0) / 60.0);
+	printf("  Elapsed time median    %12.2f hours\n",
+	    stats_percentile(elapsed, num, 50.0) / 60.0);
+	printf("  Elapsed time 90th pct  %12.2f hours\n",
+	    stats_percentile(elapsed, num, 90.0) / 60.0);
+	printf("  Elapsed time maximum   %12.2f hours (Overhead is %5.2f%%)\n", elapsed[num - 1] / 60.0,
+	    (100.0 / work_time * elapsed[num - 1]) - 100.0);
+	printf("  Mean interrupts        %12.2f\n", interrupts / num);
+    }
+
+    if (display_perf_info)   {
+	printf("\n");
+	printf("PROGRAM PERFORMANCE INFORMATION:\n");
+	printf("  Time to model all windows: %s\n", disp_time(model_time));
+    }
+
+    free(elapsed);
+
+}  /* end of report_windows() */
+
+
+
+/*
+** One line per --branch. Each one is compared to the unchanged branch,
+** which is always the first one.
+*/
+void
+report_branches(int num_branches, branch_t *branches, branch_result_t *results, int *status,
+	branch_point_t *point, double work_time, int display_perf_info, double model_time)
+{
+
+int i;
+result_t *r;
+double base;
+
+
+    if (record_active())   {
+	for (i= 0; i < num_branches; i++)   {
+	    r= (status[i] == 0) ? &results[i].r : NULL;
+	    record_begin();
+	    record_section("branch");
+	    record_string("spec", branches[i].spec);
+	    record_double("branch_at_min", point->elapsed_time);
+	    record_int("branch_at_interrupts", point->interrupt_cnt);
+	    record_double("branch_at_work_min", point->work_done);
+	    record_int("status", status[i]);
+	    record_double("checkpoint_interval_min", results[i].params.tau);
+	    record_double("checkpoint_min", results[i].params.checkpoint_time);
+	    record_double("restart_min", results[i].params.restart_time);
+	    record_double("ras_delay_min", results[i].params.ras_delay);
+	    if (results[i].params.soft_reboot_success_rate < 0.0)   {
+		record_null("soft_reboot_min");
+		record_null("soft_reboot_success_rate");
+	    } else   {
+		record_double("soft_reboot_min", results[i].params.soft_time_to_reboot);
+		record_double("soft_reboot_success_rate", results[i].params.soft_reboot_success_rate);
+	    }
+	    record_int("hotswap", results[i].params.hotswap);
+	    record_simulation(r, work_time);
+	    record_performance(r, display_perf_info, model_time);
+	    record_end();
+	}
+	return;
+    }
+
+    base= NAN;
+    if ((status[0] == 0) && !results[0].r.stopped_early)   {
+	base= results[0].r.elapsed_time;
+    }
+
+    printf("\n");
+    printf("BRANCHES at %.2f hours, after %d interrupts and %.2f hours of work\n",
+	point->elapsed_time / 60.0, point->interrupt_cnt, point->work_done / 60.0);
+    printf("  Branch                 Interval     Elapsed  Overhead  Interrupts      Faults   App. MTBI    Change\n");
+    printf("                          (hours)     (hours)                                     (hours)\n");
+    for (i= 0; i < num_branches; i++)   {
+	if (status[i] != 0)   {
+	    printf("  %-20s %s\n", branches[i].spec, task_failure(status[i]));
+	    continue;
+	}
+	r= &results[i].r;
+	if (r->stopped_early)   {
+	    printf("  %-20s %s\n", branches[i].spec, budget_failure(r, work_time));
+	    continue;
+	}
+	if (strlen(branches[i].spec) > 20)   {
+	    /* Keep the columns lined up */
+	    printf("  %s\n", branches[i].spec);
+	    printf("  %-20s", "");
+	} else   {
+	    printf("  %-20s", branches[i].spec);
+	}
+	printf(" %10.2f %11.2f %8.2f%% %11d %11d", results[i].params.tau / 60.0, r->elapsed_time / 60.0,
+	    (100.0 / work_time * r->elapsed_time) - 100.0, r->interrupt_cnt, r->fault_cnt);
+	if (r->interrupt_cnt > 0)   {
+	    printf(" %11.2f", (r->elapsed_time / r->interrupt_cnt) / 60.0);
+	} else   {
+	    printf(" %11s", "-");
+	}
+	if ((i > 0) && !isnan(base))   {
+	    printf(" %+8.2f%%\n", 100.0 / base * r->elapsed_time - 100.0);
+	} else   {
+	    printf(" %9s\n", "-");
+	}
+    }
+
+    if (display_perf_info)   {
+	printf("\n");
+	printf("PROGRAM PERFORMANCE INFORMATION:\n");
+	printf("  Time to model all branches: %s\n", disp_time(model_time));
+    }
+
+}  /* end of report_branches() */
+
+
+
+/*
+** Why a task did not produce results. Exit code 8 means the input
+** ended before the application finished.
+*/
+static const char *
+task_failure(int status)
+{
+
+static char str[64];
+
+
+    if (status == 8)   {
+	return "input ended";
+    }
+
+    sprintf(str, "failed (exit code %d)", status);
+    return str;
+
+}  /* end of task_failure() */
+
+
+
+/*
+** Why a task that ran out of --time_budget did not finish, and how long
+** it would have taken
+*/
+static const char *
+budget_failure(result_t *r, double work_time)
+{
+
+static char str[128];
+
+
+    if (r->total_work_time > 0.0)   {
+	snprintf(str, sizeof(str), "stopped by --time_budget after %.2f%% of the work, "
+	    "about %.2f hours to complete", 100.0 / work_time * r->total_work_time,
+	    extrapolate(r, work_time) / 60.0);
+    } else   {
+	snprintf(str, sizeof(str), "stopped by --time_budget before any work was done");
+    }
+
+    return str;
+
+}  /* end of budget_failure() */
+
+
+
+/*
+** The elapsed time to complete all work, if the rest of the work goes
+** like the part that was done. For a run that finished, that is its
+** elapsed time. NAN, if no work was done.
+*/
+static double
+extrapolate(result_t *r, double work_time)
+{
+
+    if (r->total_work_time <= 0.0)   {
+	return NAN;
+    }
+
+    return r->elapsed_time / r->total_work_time * work_time;
+
+}  /* end of extrapolate() */
+
+
+
+/*
+** The SIMULATION block as a record section. Times are in minutes and
+** include the wasted time, like the text report. All values are null
+** for a task that failed (r == NULL).
+*/
+static void
+record_simulation(result_t *r, double work_time)
+{
+
+double restart, rework, work, checkpoint;
+double total;
+
+
+    if (r != NULL)   {
+	restart= r->total_restart_time + r->wasted_restart_time;
+	rework= r->total_rework_time + r->wasted_rework_time;
+	work= r->total_work_time + r->wasted_work_time;
+	checkpoint= r->total_checkpoint_time + r->wasted_checkpoint_time;
+	total= restart + rework + work + checkpoint + r->total_ras_delay;
+    } else   {
+	restart= rework= work= checkpoint= total= NAN;
+    }
+
+    record_section("simulation");
+    record_double("completed_work_min", r ? r->total_work_time : NAN);
+    record_double("elapsed_min", r ? r->elapsed_time : NAN);
+    record_double("overhead_pct", r ? (100.0 / work_time * r->elapsed_time) - 100.0 : NAN);
+    record_double("restart_min", restart);
+    record_double("rework_min", rework);
+    record_double("work_min", work);
+    record_double("checkpoint_min", checkpoint);
+    record_double("ras_delay_min", r ? r->total_ras_delay : NAN);
+    record_double("wasted_restart_min", r ? r->wasted_restart_time : NAN);
+    record_double("wasted_rework_min", r ? r->wasted_rework_time : NAN);
+    record_double("wasted_work_min", r ? r->wasted_work_time : NAN);
+    record_double("wasted_checkpoint_min", r ? r->wasted_checkpoint_time : NAN);
+    record_count("restarts", r, r ? r->restart_cnt : 0);
+    record_count("failed_restarts", r, r ? r->failed_restart_cnt : 0);
+    record_count("reworks", r, r ? r->rework_cnt : 0);
+    record_count("failed_reworks", r, r ? r->failed_rework_cnt : 0);
+    record_count("work_segments", r, r ? r->work_cnt : 0);
+    record_count("failed_work_segments", r, r ? r->failed_work_cnt : 0);
+    record_count("checkpoints", r, r ? r->checkpoint_cnt : 0);
+    record_count("failed_checkpoints", r, r ? r->failed_checkpoint_cnt : 0);
+    record_count("interrupts", r, r ? r->interrupt_cnt : 0);
+    record_count("faults", r, r ? r->fault_cnt : 0);
+    record_count("failed_nodes", r, r ? r->node_failure_cnt : 0);
+    record_count("repaired_nodes", r, r ? r->total_repaired : 0);
+    record_count("soft_reboots", r, r ? r->soft_reboot_success_cnt : 0);
+    record_count("failed_soft_reboots", r, r ? r->soft_reboot_failure_cnt : 0);
+    record_count("stopped_early", r, r ? r->stopped_early : 0);
+    record_double("extrapolated_elapsed_min", r ? extrapolate(r, work_time) : NAN);
+    if ((r != NULL) && (r->interrupt_cnt > 0))   {
+	record_double("faults_per_interrupt", (double)r->fault_cnt / r->interrupt_cnt);
+	record_double("app_mtbi_min", r->elapsed_time / r->interrupt_cnt);
+    } else   {
+	record_null("faults_per_interrupt");
+	record_null("app_mtbi_min");
+    }
+    if ((r != NULL) && (r->fault_cnt > 0))   {
+	record_double("sys_mtbf_min", total / r->fault_cnt);
+    } else   {
+	record_null("sys_mtbf_min");
+    }
+
+}  /* end of record_simulation() */
+
+
+
+/*
+** The PROGRAM PERFORMANCE block as a record section, if -p was given.
+** For a sweep, model_time is the time for the whole sweep.
+*/
+static void
+record_performance(result_t *r, int display_perf_info, double model_time)
+{
+
+    if (!display_perf_info)   {
+	return;
+    }
+
+    record_section("performance");
+    record_count("random_numbers", r, r ? r->rnd_gen_cnt : 0);
+    record_count("random_probabilities", r, r ? r->rnd_prob_cnt : 0);
+    record_count("rmpi_calls", r, r ? r->calls_rMPI : 0);
+    record_count("input_faults_read", r, r ? r->read_input_cnt : 0);
+    record_count("input_faults_accepted", r, r ? r->read_input_accepted : 0);
+    record_double("model_time_sec", model_time);
+
+}  /* end of record_performance() */
+
+
+
+static void
+record_count(const char *key, result_t *r, int v)
+{
+
+    if (r == NULL)   {
+	record_null(key);
+    } else   {
+	record_int(key, v);
+    }
+
+}  /* end of record_count() */
@@ -19,4 +19,22 @@ report_results(double work_time, double elapsed_time, double calculated_sys_mtbf
 	double calculated_app_mtbf, int display_perf_info, double model_time,
 	double daly, FILE *fp_input, double calculated_fpi);
 
+/* Results of one application size of a --sizes run, or of one window */
+typedef struct sweep_result_t   {
+    double tau;
+    result_t r;
+} sweep_result_t;
+
+void
+report_scaling(int num_sizes, int *sizes, int *redundant, sweep_result_t *results, int *status,
+	double work_time, int display_perf_info, double model_time);
+
+void
+report_windows(int num_windows, double *offsets, sweep_result_t *results, int *status,
+	double work_time, int display_perf_info, double model_time);
+
+void
+report_branches(int num_branches, branch_t *branches, branch_result_t *results, int *status,
+	branch_point_t *point, double work_time, int display_perf_info, double model_time);
+
 #endif /* _REPORT_H_ */
@@ -12,19 +12,40 @@
 **
 */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_sf_gamma.h>
 
 #include "globals.h"
 #include "rnd.h"
+#include "snapshot.h"
+#include "cache.h"
 
-static rnd_t _rnd= RND_EXP;
-static gsl_rng *_r;
-static double _node_mtbf= 43800; /* Five years */
-static double _dist_shape; /* Shape distribution parameter */
-static double _dist_scale; /* Scale parameter for Weibull */
+static SIM_LOCAL rnd_t _rnd= RND_EXP;
+static SIM_LOCAL gsl_rng *_r= NULL;
+static SIM_LOCAL double _node_mtbf= 43800; /* Five years */
+static SIM_LOCAL double _dist_shape; /* Shape distribution parameter */
+static SIM_LOCAL double _dist_scale; /* Scale parameter for Weibull */
+
+/* gsl_rng_env_setup() sets globals of the GSL. Once per process. */
+static pthread_once_t env_once= PTHREAD_ONCE_INIT;
+
+/* What a snapshot records about the distribution. Compared as bytes */
+typedef struct rnd_params_t   {
+    int32_t rnd;
+    int32_t unused;
+    double node_mtbf;
+    double shape;
+    double scale;
+} rnd_params_t;
+
+
+static void get_params(rnd_params_t *p);
+static void env_setup(void);
 
 
 
@@ -41,9 +62,16 @@ const gsl_rng_type *T;
     _dist_scale= node_mtbf / gsl_sf_gamma(1.0 + 1.0 / shape);
     _dist_scale= scale;
 
-    gsl_rng_env_setup();
+    pthread_once(&env_once, env_setup);
     T= gsl_rng_default;
+    if (_r)   {
+	/* Another run on this thread */
+	gsl_rng_free(_r);
+    }
     _r= gsl_rng_alloc(T);
+    if (_r == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
     if (default_seed == FALSE)   {
 	gsl_rng_set(_r, time(NULL) + getpid());
     }
@@ -52,6 +80,35 @@ const gsl_rng_type *T;
 
 
 
+/*
+** Start the generator with this seed, instead of the one init_rnd() chose
+*/
+void
+rnd_seed(unsigned long seed)
+{
+
+    gsl_rng_set(_r, seed);
+
+}  /* end of rnd_seed() */
+
+
+
+/*
+** Free the generator of this thread
+*/
+void
+rnd_end(void)
+{
+
+    if (_r)   {
+	gsl_rng_free(_r);
+	_r= NULL;
+    }
+
+}  /* end of rnd_end() */
+
+
+
 double
 next_node_failure(double start_time)
 {
@@ -68,8 +125,7 @@ next_node_failure(double start_time)
 	    return start_time + gsl_ran_weibull(_r, _dist_scale, _dist_shape);
 
 	default:
-	    fprintf(stderr, "Unknown random number distribution requested!\n");
-	    exit(6);
+	    sim_error(6, "Unknown random number distribution requested!\n");
     }
 
 }  /* end of next_node_failure() */
@@ -82,3 +138,132 @@ rnd_probability(void)
     rnd_prob_cnt++;
     return gsl_ran_flat(_r, 0.0, 1.0);
 }  /* end of rnd_probability() */
+
+
+
+/*
+** Give each of several processes that continue from the same state its
+** own random number stream. They all draw the same number here, since
+** their generators are in the same state, and seed with it and their
+** stream number.
+*/
+void
+rnd_split(int stream)
+{
+
+unsigned long seed;
+
+
+    seed= gsl_rng_get(_r);
+    gsl_rng_set(_r, seed + 1000003UL * (stream + 1));
+
+}  /* end of rnd_split() */
+
+
+
+/*
+** A hash of the distribution, the type of generator, and its state, for
+** the --cache key. Two runs with the same hash draw the same faults.
+*/
+uint64_t
+rnd_hash(void)
+{
+
+rnd_params_t p;
+uint64_t h;
+char *buf;
+size_t len;
+FILE *fp;
+
+
+    get_params(&p);
+    h= cache_hash(CACHE_HASH_INIT, &p, sizeof(p));
+    h= cache_hash(h, gsl_rng_default->name, strlen(gsl_rng_default->name));
+
+    buf= NULL;
+    len= 0;
+    fp= open_memstream(&buf, &len);
+    if (fp == NULL)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    gsl_rng_fwrite(fp, _r);
+    if (fclose(fp) != 0)   {
+	sim_error(10, "Out of memory!\n");
+    }
+    h= cache_hash(h, buf, len);
+    free(buf);
+
+    return h;
+
+}  /* end of rnd_hash() */
+
+
+
+/*
+** Save the distribution and the state of the generator in a snapshot
+*/
+void
+rnd_save(FILE *fp)
+{
+
+rnd_params_t p;
+
+
+    get_params(&p);
+    snap_put(fp, &p, sizeof(p));
+    if (gsl_rng_fwrite(fp, _r) != 0)   {
+	/* snapshot_write() notices the error when it closes the file */
+	return;
+    }
+
+}  /* end of rnd_save() */
+
+
+
+/*
+** Continue with the generator state from a snapshot. The distribution
+** must be the same. init_rnd() has been called.
+*/
+void
+rnd_load(FILE *fp)
+{
+
+rnd_params_t p;
+rnd_params_t saved;
+
+
+    get_params(&p);
+    snap_get(fp, &saved, sizeof(saved));
+    if (memcmp(&p, &saved, sizeof(p)) != 0)   {
+	sim_error(8, "ERROR: The snapshot was taken with a different fault distribution\n");
+    }
+
+    if (gsl_rng_fread(fp, _r) != 0)   {
+	sim_error(8, "ERROR: Could not read the random number generator state from the snapshot\n");
+    }
+
+}  /* end of rnd_load() */
+
+
+
+static void
+get_params(rnd_params_t *p)
+{
+
+    memset(p, 0, sizeof(rnd_params_t));
+    p->rnd= _rnd;
+    p->node_mtbf= _node_mtbf;
+    p->shape= _dist_shape;
+    p->scale= _dist_scale;
+
+}  /* end of get_params() */
+
+
+
+static void
+env_setup(void)
+{
+
+    gsl_rng_env_setup();
+
+}  /* end of env_setup() */
@@ -14,13 +14,21 @@
 #ifndef _RND_H_
 #define _RND_H_
 
+#include <stdint.h>
+
 /* Which random number distribution to use */
 typedef enum {RND_EXP, RND_GAMMA, RND_WEIBULL} rnd_t;
 
 
 void init_rnd(rnd_t rnd, double node_mtbf, int default_seed, double shape, double scale);
+void rnd_seed(unsigned long seed);
+void rnd_end(void);
 double next_node_failure(double start_time);
 double rnd_probability(void);
+void rnd_split(int stream);
+void rnd_save(FILE *fp);
+void rnd_load(FILE *fp);
+uint64_t rnd_hash(void);
 
 
 #endif /* _RND_H_ */
@@ -0,0 +1,615 @@
+/*
+** $Id$
+**
+** --serve. See serve.h.
+**
+** Short runs spend most of their time starting the process, setting up
+** the GSL, and printing the banner. Here the process stays up and runs
+** each scenario through libapp_model. The scenarios come from stdin,
+** or from the clients of a UNIX domain socket, one client at a time.
+** Each line is parsed with getopt_long(), like the command line, and
+** the result goes back as one JSON or CSV record.
+**
+** With --jobs 1 the scenarios run on the thread that reads them, in
+** order. Otherwise a pool of worker threads takes them from a queue,
+** and the results come back in the order they finish; the "scenario"
+** field says which line each one belongs to. Each worker has its own
+** context and keeps its node array and search tree entries from one
+** run to the next (see rMPI_end()).
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "globals.h"
+#include "timing.h"
+#include "record.h"
+#include "libapp_model.h"
+#include "serve.h"
+
+#define SERVE_MAX_ARGS		(64)
+#define SERVE_QUEUE		(256)	/* Scenarios waiting for a worker */
+
+
+typedef struct job_t   {
+    int id;			/* Scenario number, from 1 */
+    int rc;			/* AM_OK, or why the scenario did not run */
+    am_config_t cfg;
+    char error[256];
+} job_t;
+
+
+/* The options of a scenario line. The same names and codes as in main.c */
+static struct option serve_options[]=   {
+    {"work_time", 1, NULL, 'w'},
+    {"work-time", 1, NULL, 'w'},
+    {"num_bundles", 1, NULL, 'n'},
+    {"num-bundles", 1, NULL, 'n'},
+    {"redundant", 1, NULL, 'r'},
+    {"distribution", 1, NULL, 1100},
+    {"seed", 0, NULL, 's'},
+    {"checkpoint_time", 1, NULL, 'c'},
+    {"checkpoint-time", 1, NULL, 'c'},
+    {"restart_time", 1, NULL, 'R'},
+    {"restart-time", 1, NULL, 'R'},
+    {"tau", 1, NULL, 't'},
+    {"mtbf_node", 1, NULL, 'm'},
+    {"mtbf-node", 1, NULL, 'm'},
+    {"mtbf_sys", 1, NULL, 1003},
+    {"mtbf-sys", 1, NULL, 1003},
+    {"mtbf_app", 1, NULL, 'a'},
+    {"mtbf-app", 1, NULL, 'a'},
+    {"delay_ras", 1, NULL, 'd'},
+    {"delay-ras", 1, NULL, 'd'},
+    {"soft_reboot", 1, NULL, 1002},
+    {"soft-reboot", 1, NULL, 1002},
+    {"shape", 1, NULL, 1006},
+    {"scale", 1, NULL, 1007},
+    {"hotswap", 0, NULL, 1008},
+    {"time_budget", 1, NULL, 1022},
+    {"time-budget", 1, NULL, 1022},
+    {0, 0, 0, 0}
+};
+
+
+/* The queue and the worker pool */
+static pthread_mutex_t lock= PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t have_job= PTHREAD_COND_INITIALIZER;
+static pthread_cond_t have_room= PTHREAD_COND_INITIALIZER;
+static pthread_cond_t all_done= PTHREAD_COND_INITIALIZER;
+static job_t queue[SERVE_QUEUE];
+static int q_first= 0;
+static int q_len= 0;
+static int running= 0;		/* Jobs a worker has taken, but not finished */
+static int shutting_down= FALSE;
+
+/* The record functions write to the client of the current session */
+static pthread_mutex_t out_lock= PTHREAD_MUTEX_INITIALIZER;
+static FILE *out;
+static int out_ok;
+
+static unsigned long seed_base;
+
+
+/* Local functions */
+static void session(FILE *in, FILE *fp, int format, am_ctx_t *ctx);
+static int listen_on(char *path);
+static int get_number(const char *arg, double *v);
+static void run_job(am_ctx_t *ctx, job_t *job);
+static void write_result(job_t *job, am_results_t *r, double model_time);
+static void *worker(void *arg);
+static void enqueue(job_t *job);
+static void wait_idle(void);
+
+
+
+/*
+** Serve scenarios from stdin, if where is "-", or from a UNIX domain
+** socket at that path. With max_jobs > 1, that many worker threads run
+** them. Returns the exit code.
+*/
+int
+serve(char *where, int max_jobs, int format)
+{
+
+pthread_t *tids;
+am_ctx_t *ctx;
+int listen_fd;
+int fd;
+int i;
+FILE *in;
+FILE *fp;
+
+
+    if (format == FORMAT_TEXT)   {
+	format= FORMAT_JSON;
+    }
+
+    /* Scenarios without -s each get a seed of their own */
+    seed_base= (unsigned long)time(NULL) + getpid();
+
+    /* A client that goes away must not take the server with it */
+    signal(SIGPIPE, SIG_IGN);
+
+    ctx= NULL;
+    tids= NULL;
+    if (max_jobs > 1)   {
+	tids= (pthread_t *)malloc(max_jobs * sizeof(pthread_t));
+	if (tids == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    exit(10);
+	}
+	for (i= 0; i < max_jobs; i++)   {
+	    if (pthread_create(&tids[i], NULL, worker, NULL) != 0)   {
+		fprintf(stderr, "Could not start worker thread %d: %s\n", i, strerror(errno));
+		exit(11);
+	    }
+	}
+    } else   {
+	ctx= am_init();
+    }
+
+    if (strcmp(where, "-") == 0)   {
+	session(stdin, stdout, format, ctx);
+	record_close();
+    } else   {
+	listen_fd= listen_on(where);
+	if (listen_fd < 0)   {
+	    return 2;
+	}
+
+	/* Until we get killed */
+	while (TRUE)   {
+	    fd= accept(listen_fd, NULL, NULL);
+	    if (fd < 0)   {
+		if (errno == EINTR)   {
+		    continue;
+		}
+		fprintf(stderr, "Could not accept a connection on \"%s\": %s\n", where,
+		    strerror(errno));
+		break;
+	    }
+
+	    in= fdopen(fd, "r");
+	    fp= fdopen(dup(fd), "w");
+	    if ((in == NULL) || (fp == NULL))   {
+		fprintf(stderr, "Could not open a connection on \"%s\": %s\n", where,
+		    strerror(errno));
+		if (in)   {
+		    fclose(in);
+		} else   {
+		    close(fd);
+		}
+		if (fp)   {
+		    fclose(fp);
+		}
+		continue;
+	    }
+	    session(in, fp, format, ctx);
+	    fclose(in);
+	    fclose(fp);
+	}
+	close(listen_fd);
+	unlink(where);
+    }
+
+    if (tids)   {
+	pthread_mutex_lock(&lock);
+	shutting_down= TRUE;
+	pthread_cond_broadcast(&have_job);
+	pthread_mutex_unlock(&lock);
+	for (i= 0; i < max_jobs; i++)   {
+	    pthread_join(tids[i], NULL);
+	}
+	free(tids);
+    }
+    am_free(ctx);
+    am_thread_end();
+
+    return 0;
+
+}  /* end of serve() */
+
+
+
+/*
+** Run the scenarios of one client, until it closes its end, and wait
+** for the last results before returning
+*/
+static void
+session(FILE *in, FILE *fp, int format, am_ctx_t *ctx)
+{
+
+char *line;
+size_t size;
+char *p;
+int id;
+int ok;
+job_t job;
+
+
+    pthread_mutex_lock(&out_lock);
+    out= fp;
+    out_ok= TRUE;
+    record_open(fp, format);
+    pthread_mutex_unlock(&out_lock);
+
+    line= NULL;
+    size= 0;
+    id= 0;
+    ok= TRUE;
+    while (ok && (getline(&line, &size, in) > 0))   {
+	/* Skip empty lines and comments */
+	for (p= line; (*p == ' ') || (*p == '\t'); p++)   {
+	}
+	if ((*p == '\0') || (*p == '\n') || (*p == '\r') || (*p == '#'))   {
+	    continue;
+	}
+
+	id++;
+	job.id= id;
+	job.rc= serve_parse(line, (seed_base + id) ? seed_base + id : 1, &job.cfg, job.error,
+		    sizeof(job.error));
+	if (ctx)   {
+	    run_job(ctx, &job);
+	} else   {
+	    enqueue(&job);
+	}
+
+	pthread_mutex_lock(&out_lock);
+	ok= out_ok;
+	pthread_mutex_unlock(&out_lock);
+    }
+
+    free(line);
+    wait_idle();
+
+}  /* end of session() */
+
+
+
+/*
+** Returns the listening socket, or -1
+*/
+static int
+listen_on(char *path)
+{
+
+struct sockaddr_un addr;
+int fd;
+
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family= AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))   {
+	fprintf(stderr, "Socket path \"%s\" is too long\n", path);
+	return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    fd= socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)   {
+	fprintf(stderr, "Could not create a socket: %s\n", strerror(errno));
+	return -1;
+    }
+
+    /* Remove what a killed server left behind */
+    unlink(path);
+    if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) || (listen(fd, SOMAXCONN) != 0))   {
+	fprintf(stderr, "Could not listen on \"%s\": %s\n", path, strerror(errno));
+	close(fd);
+	return -1;
+    }
+
+    return fd;
+
+}  /* end of listen_on() */
+
+
+
+/*
+** Turn a scenario line into a configuration with this seed, unless the
+** line has -s. Returns AM_OK, or AM_EINVAL with the reason in error, if
+** the line is not valid. The line is split up in place. Not thread safe,
+** because of getopt_long().
+*/
+int
+serve_parse(char *line, unsigned long seed, am_config_t *c, char *error, size_t size)
+{
+
+char *argv[SERVE_MAX_ARGS + 1];
+int argc;
+char *save;
+int ch;
+int option_index;
+double v;
+int rc;
+
+
+    rc= AM_OK;
+    error[0]= '\0';
+    am_defaults(c);
+    c->seed= seed;
+
+    argc= 0;
+    argv[argc++]= "two_step";
+    for (argv[argc]= strtok_r(line, " \t\r\n", &save); argv[argc];
+	    argv[argc]= strtok_r(NULL, " \t\r\n", &save))   {
+	if (++argc >= SERVE_MAX_ARGS)   {
+	    rc= AM_EINVAL;
+	    snprintf(error, size, "More than %d arguments", SERVE_MAX_ARGS - 1);
+	    return rc;
+	}
+    }
+
+    /* Start over, and let us report the errors */
+    optind= 0;
+    opterr= 0;
+    while (rc == AM_OK)   {
+	ch= getopt_long(argc, argv, ":a:m:c:r:w:t:n:R:sd:", serve_options, &option_index);
+	if (ch == -1)   {
+	    break;
+	}
+
+	v= 0.0;
+	if (optarg && (ch != 1100) && (ch != 1002) && !get_number(optarg, &v))   {
+	    rc= AM_EINVAL;
+	    snprintf(error, size, "Invalid number \"%s\"", optarg);
+	    break;
+	}
+
+	switch (ch)   {
+	    case 'n':	c->active_nodes= (int)v; break;
+	    case 'r':	c->redundant_nodes= (int)v; break;
+	    case 'w':	c->work_time= v; break;
+	    case 'c':	c->checkpoint_time= v; break;
+	    case 'R':	c->restart_time= v; break;
+	    case 't':	c->tau= v; break;
+	    case 'm':	c->node_mtbf= v; break;
+	    case 'a':	c->app_mtbf= v; break;
+	    case 'd':	c->ras_delay= v; break;
+	    case 's':	c->seed= 0; break;
+	    case 1003:	c->sys_mtbf= v; break;
+	    case 1006:	c->shape= v; break;
+	    case 1007:	c->scale= v; break;
+	    case 1008:	c->hotswap= TRUE; break;
+	    case 1022:	c->time_budget= v; break;
+	    case 1100:
+		if ((strcmp(optarg, "g") == 0) || (strcmp(optarg, "gamma") == 0))   {
+		    c->distribution= AM_DIST_GAMMA;
+		} else if ((strcmp(optarg, "e") == 0) || (strcmp(optarg, "exp") == 0))   {
+		    c->distribution= AM_DIST_EXP;
+		} else if ((strcmp(optarg, "w") == 0) || (strcmp(optarg, "weibull") == 0))   {
+		    c->distribution= AM_DIST_WEIBULL;
+		} else   {
+		    rc= AM_EINVAL;
+		    snprintf(error, size, "Unknown random distribution function: \"%s\"",
+			optarg);
+		}
+		break;
+	    case 1002:
+		if ((sscanf(optarg, "%lf,%lf", &c->soft_reboot_success, &c->soft_reboot_time) != 2) ||
+			(c->soft_reboot_success < 0.0))   {
+		    rc= AM_EINVAL;
+		    snprintf(error, size, "Invalid --soft_reboot \"%s\"", optarg);
+		}
+		break;
+	    case ':':
+		rc= AM_EINVAL;
+		snprintf(error, size, "%s needs an argument", argv[optind - 1]);
+		break;
+	    default:
+		rc= AM_EINVAL;
+		snprintf(error, size, "Unknown option, or not one for --serve: %s",
+		    argv[optind - 1]);
+		break;
+	}
+    }
+
+    if ((rc == AM_OK) && (optind < argc))   {
+	rc= AM_EINVAL;
+	snprintf(error, size, "Unexpected argument \"%s\"", argv[optind]);
+    }
+
+    return rc;
+
+}  /* end of serve_parse() */
+
+
+
+/*
+** TRUE, if all of arg is a number
+*/
+static int
+get_number(const char *arg, double *v)
+{
+
+char *endptr;
+
+
+    *v= strtod(arg, &endptr);
+    return (endptr != arg) && (*endptr == '\0');
+
+}  /* end of get_number() */
+
+
+
+static void
+run_job(am_ctx_t *ctx, job_t *job)
+{
+
+am_results_t r;
+double t0;
+
+
+    t0= get_clock_value();
+    if (job->rc == AM_OK)   {
+	job->rc= am_configure(ctx, &job->cfg);
+	if (job->rc == AM_OK)   {
+	    job->rc= am_run(ctx);
+	}
+	if (job->rc != AM_OK)   {
+	    snprintf(job->error, sizeof(job->error), "%s", am_error(ctx));
+	}
+    }
+
+    if (job->rc == AM_OK)   {
+	am_results(ctx, &r);
+	write_result(job, &r, get_clock_value() - t0);
+    } else   {
+	write_result(job, NULL, get_clock_value() - t0);
+    }
+
+}  /* end of run_job() */
+
+
+
+/*
+** One record per scenario. All of them have the same fields; the ones
+** of a failed scenario are null.
+*/
+static void
+write_result(job_t *job, am_results_t *r, double model_time)
+{
+
+double work;
+
+
+    work= 60.0 * job->cfg.work_time;
+
+    pthread_mutex_lock(&out_lock);
+    record_begin();
+    record_int("scenario", job->id);
+    record_int("status", job->rc);
+    record_string("error", job->error);
+
+    record_section("calculated");
+    record_double("checkpoint_interval_min", r ? r->tau : NAN);
+    record_double("sys_mtbf_min", r ? r->sys_mtbf : NAN);
+    record_double("app_mtbi_min", r ? r->app_mtbf : NAN);
+    record_double("modeled_elapsed_min", r ? r->daly : NAN);
+
+    record_section("simulation");
+    record_double("completed_work_min", r ? r->work_time : NAN);
+    record_double("elapsed_min", r ? r->elapsed : NAN);
+    record_double("overhead_pct", r ? (100.0 / work * r->elapsed) - 100.0 : NAN);
+    record_double("restart_min", r ? r->restart_time : NAN);
+    record_double("rework_min", r ? r->rework_time : NAN);
+    record_double("checkpoint_min", r ? r->checkpoint_time : NAN);
+    record_double("ras_delay_min", r ? r->ras_delay : NAN);
+    record_double("interrupts", r ? r->interrupts : NAN);
+    record_double("faults", r ? r->faults : NAN);
+    record_double("node_failures", r ? r->node_failures : NAN);
+    record_double("checkpoints", r ? r->checkpoints : NAN);
+    record_double("failed_checkpoints", r ? r->failed_checkpoints : NAN);
+    record_double("restarts", r ? r->restarts : NAN);
+    record_double("failed_restarts", r ? r->failed_restarts : NAN);
+    record_double("soft_reboot_successes", r ? r->soft_reboot_successes : NAN);
+    record_double("soft_reboot_failures", r ? r->soft_reboot_failures : NAN);
+    record_double("stopped_early", r ? r->stopped_early : NAN);
+    record_double("extrapolated_elapsed_min",
+	(r && (r->extrapolated_elapsed >= 0.0)) ? r->extrapolated_elapsed : NAN);
+
+    record_section("performance");
+    record_double("model_time_sec", model_time);
+    record_end();
+
+    if (fflush(out) != 0)   {
+	/* The client went away. The session stops reading its scenarios. */
+	out_ok= FALSE;
+    }
+    pthread_mutex_unlock(&out_lock);
+
+}  /* end of write_result() */
+
+
+
+static void *
+worker(void *arg)
+{
+
+am_ctx_t *ctx;
+job_t job;
+
+
+    (void)arg;
+    ctx= am_init();
+    while (TRUE)   {
+	pthread_mutex_lock(&lock);
+	while ((q_len == 0) && !shutting_down)   {
+	    pthread_cond_wait(&have_job, &lock);
+	}
+	if (q_len == 0)   {
+	    pthread_mutex_unlock(&lock);
+	    break;
+	}
+	job= queue[q_first];
+	q_first= (q_first + 1) % SERVE_QUEUE;
+	q_len--;
+	running++;
+	pthread_cond_signal(&have_room);
+	pthread_mutex_unlock(&lock);
+
+	run_job(ctx, &job);
+
+	pthread_mutex_lock(&lock);
+	running--;
+	if ((q_len == 0) && (running == 0))   {
+	    pthread_cond_broadcast(&all_done);
+	}
+	pthread_mutex_unlock(&lock);
+    }
+
+    am_free(ctx);
+    am_thread_end();
+    return NULL;
+
+}  /* end of worker() */
+
+
+
+static void
+enqueue(job_t *job)
+{
+
+    pthread_mutex_lock(&lock);
+    while (q_len == SERVE_QUEUE)   {
+	pthread_cond_wait(&have_room, &lock);
+    }
+    queue[(q_first + q_len) % SERVE_QUEUE]= *job;
+    q_len++;
+    pthread_cond_signal(&have_job);
+    pthread_mutex_unlock(&lock);
+
+}  /* end of enqueue() */
+
+
+
+static void
+wait_idle(void)
+{
+
+    pthread_mutex_lock(&lock);
+    while ((q_len > 0) || (running > 0))   {
+	pthread_cond_wait(&all_done, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+}  /* end of wait_idle() */
@@ -0,0 +1,25 @@
+/*
+** $Id$
+**
+** --serve: keep one process running, read scenarios, one per line with
+** the same options as the command line, and write a result record for
+** each one.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _SERVE_H_
+#define _SERVE_H_
+
+#include <stddef.h>
+
+int serve(char *where, int max_jobs, int format);
+
+int serve_parse(char *line, unsigned long seed, am_config_t *cfg, char *error, size_t size);
+
+#endif /* _SERVE_H_ */
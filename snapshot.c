@@ -0,0 +1,225 @@
+/*
+** $Id$
+**
+** Write the state of a running simulation to a file, and read it back to
+** continue the run later. Each module saves and loads its own variables;
+** this file puts the pieces together. See snapshot.h for the layout.
+**
+** A snapshot is written to a temporary file that replaces the previous
+** snapshot only once it is complete, so a run that is killed while it
+** writes one still leaves the last good snapshot behind.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "globals.h"
+#include "perf.h"
+#include "rnd.h"
+#include "hist.h"
+#include "writer.h"
+#include "rMPI_model.h"
+#include "snapshot.h"
+
+
+static char *cur_fname;
+static snapshot_state_t resumed_state;
+static int have_resumed= FALSE;
+
+
+
+/*
+** Write a snapshot. Returns FALSE, if that did not work; the previous
+** snapshot, if any, is still there then.
+*/
+int
+snapshot_write(char *fname, snapshot_state_t *state)
+{
+
+FILE *fp;
+char *tmp;
+snapshot_hdr_t hdr;
+result_t r;
+uint32_t end;
+int rc;
+int timer;
+
+
+    timer= perf_switch(PERF_OUTPUT);
+    tmp= (char *)malloc(strlen(fname) + 5);
+    if (tmp == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    sprintf(tmp, "%s.tmp", fname);
+
+    fp= fopen(tmp, "w");
+    if (fp == NULL)   {
+	fprintf(stderr, "Warning: Could not write snapshot \"%s\": %s\n", tmp, strerror(errno));
+	free(tmp);
+	perf_switch(timer);
+	return FALSE;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version= SNAPSHOT_VERSION;
+    hdr.byte_order= SNAPSHOT_BYTE_ORDER;
+    hdr.state_size= sizeof(snapshot_state_t);
+    hdr.result_size= sizeof(result_t);
+    snap_put(fp, &hdr, sizeof(hdr));
+    snap_put(fp, state, sizeof(snapshot_state_t));
+
+    memset(&r, 0, sizeof(r));
+    save_results(&r, state->elapsed_time);
+    snap_put(fp, &r, sizeof(r));
+
+    rnd_save(fp);
+    hist_save(fp);
+    rMPI_save(fp);
+
+    end= SNAPSHOT_END;
+    snap_put(fp, &end, sizeof(end));
+
+    rc= ferror(fp);
+    if ((fclose(fp) != 0) || rc)   {
+	fprintf(stderr, "Warning: Could not write snapshot \"%s\"\n", tmp);
+	remove(tmp);
+	free(tmp);
+	perf_switch(timer);
+	return FALSE;
+    }
+
+    if (rename(tmp, fname) != 0)   {
+	fprintf(stderr, "Warning: Could not rename \"%s\" to \"%s\": %s\n", tmp, fname,
+	    strerror(errno));
+	remove(tmp);
+	free(tmp);
+	perf_switch(timer);
+	return FALSE;
+    }
+
+    free(tmp);
+    perf_switch(timer);
+    return TRUE;
+
+}  /* end of snapshot_write() */
+
+
+
+/*
+** Load a snapshot in place of rMPI_init(). The next app_model() call
+** picks up where the snapshot was taken.
+*/
+void
+snapshot_resume(char *fname, int num_bundles, int total_nodes, FILE *fp_input)
+{
+
+FILE *fp;
+snapshot_hdr_t hdr;
+result_t r;
+uint32_t end;
+
+
+    fp= fopen(fname, "r");
+    if (fp == NULL)   {
+	fprintf(stderr, "Could not open snapshot \"%s\": %s\n", fname, strerror(errno));
+	exit(2);
+    }
+    cur_fname= fname;
+
+    snap_get(fp, &hdr, sizeof(hdr));
+    if (memcmp(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic)) != 0)   {
+	fprintf(stderr, "ERROR: \"%s\" is not a snapshot\n", fname);
+	exit(8);
+    }
+    if (hdr.byte_order != SNAPSHOT_BYTE_ORDER)   {
+	fprintf(stderr, "ERROR: \"%s\" was written on a machine with a different byte order\n",
+	    fname);
+	exit(8);
+    }
+    if ((hdr.version != SNAPSHOT_VERSION) || (hdr.state_size != sizeof(snapshot_state_t)) ||
+	    (hdr.result_size != sizeof(result_t)))   {
+	fprintf(stderr, "ERROR: \"%s\" is version %u. I can only read version %d\n",
+	    fname, hdr.version, SNAPSHOT_VERSION);
+	exit(8);
+    }
+
+    snap_get(fp, &resumed_state, sizeof(resumed_state));
+    snap_get(fp, &r, sizeof(r));
+    rnd_load(fp);
+    hist_load(fp);
+    rMPI_load(fp, num_bundles, total_nodes, fp_input);
+
+    snap_get(fp, &end, sizeof(end));
+    if (end != SNAPSHOT_END)   {
+	fprintf(stderr, "ERROR: Snapshot \"%s\" is corrupt\n", fname);
+	exit(8);
+    }
+    fclose(fp);
+
+    /* Last, since reading up to the input position counts faults again */
+    restore_results(&r);
+    have_resumed= TRUE;
+
+}  /* end of snapshot_resume() */
+
+
+
+/*
+** Return TRUE and the app_model() state of the snapshot, the first time
+** this is called after snapshot_resume()
+*/
+int
+snapshot_resumed(snapshot_state_t *state)
+{
+
+    if (!have_resumed)   {
+	return FALSE;
+    }
+
+    *state= resumed_state;
+    have_resumed= FALSE;
+    return TRUE;
+
+}  /* end of snapshot_resumed() */
+
+
+
+/*
+** Write errors are checked once, when the file is closed
+*/
+void
+snap_put(FILE *fp, const void *buf, size_t size)
+{
+
+    if (size > 0)   {
+	fwrite(buf, size, 1, fp);
+    }
+
+}  /* end of snap_put() */
+
+
+
+/*
+** A short read is a sim_error(), so a caller that sets sim_jmp can
+** recover from it
+*/
+void
+snap_get(FILE *fp, void *buf, size_t size)
+{
+
+    if ((size > 0) && (fread(buf, size, 1, fp) != 1))   {
+	sim_error(8, "ERROR: Snapshot \"%s\" is truncated\n", cur_fname ? cur_fname : "");
+    }
+
+}  /* end of snap_get() */
@@ -0,0 +1,76 @@
+/*
+** $Id$
+**
+** Snapshots of a running simulation for --snapshot_every, and --resume
+** to continue from one.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/*
+** File layout:
+**     snapshot_hdr_t		header
+**     snapshot_state_t		app_model() parameters and loop variables
+**     result_t			the time keepers and counters of globals.c
+**     rnd_save()		distribution and random number generator
+**     hist_save()		histograms
+**     rMPI_save()		nodes, search tree order, and input position
+**     SNAPSHOT_END		marks a complete file
+** All values are stored in the byte order of the machine that wrote the
+** file. Change SNAPSHOT_VERSION, when any of the sections change.
+*/
+#define SNAPSHOT_MAGIC		"APPMSNP1"
+#define SNAPSHOT_VERSION	(1)
+#define SNAPSHOT_BYTE_ORDER	(0x01020304)
+#define SNAPSHOT_END		(0x454e4421)
+
+typedef struct snapshot_hdr_t   {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t state_size;	/* sizeof(snapshot_state_t) */
+    uint32_t result_size;	/* sizeof(result_t) */
+} snapshot_hdr_t;
+
+/* A resumed run must have the same parameters. They are compared as bytes */
+typedef struct snapshot_params_t   {
+    double tau;
+    double checkpoint_time;
+    double restart_time;
+    double work_time;
+    double ras_delay;
+    float soft_time_to_reboot;
+    float soft_reboot_success_rate;
+    int32_t hotswap;
+    int32_t unused;
+} snapshot_params_t;
+
+/* Where app_model() was: at the top of its loop. Times in minutes */
+typedef struct snapshot_state_t   {
+    snapshot_params_t params;
+    double elapsed_time;
+    double last_event;
+    double rework_time;
+} snapshot_state_t;
+
+
+int snapshot_write(char *fname, snapshot_state_t *state);
+void snapshot_resume(char *fname, int num_bundles, int total_nodes, FILE *fp_input);
+int snapshot_resumed(snapshot_state_t *state);
+
+/* For the save and load functions of the other modules */
+void snap_put(FILE *fp, const void *buf, size_t size);
+void snap_get(FILE *fp, void *buf, size_t size);
+
+#endif /* _SNAPSHOT_H_ */
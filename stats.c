@@ -0,0 +1,183 @@
+/*
+** $Id$
+**
+** Summary statistics of a sample. Elapsed times are large and their
+** spread is small, so the variance is accumulated with Welford's method
+** instead of from the sum of the squares, which loses most of its
+** digits to cancellation.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdlib.h>		/* For qsort() */
+#include <math.h>
+
+#include "globals.h"
+#include "stats.h"
+
+
+/* Local functions */
+static int compare_doubles(const void *pa, const void *pb);
+static double t_975(int df);
+
+
+
+void
+stats_init(stats_t *s)
+{
+
+    s->num= 0;
+    s->mean= 0.0;
+    s->m2= 0.0;
+
+}  /* end of stats_init() */
+
+
+
+void
+stats_add(stats_t *s, double x)
+{
+
+double delta;
+
+
+    s->num++;
+    delta= x - s->mean;
+    s->mean= s->mean + delta / s->num;
+    s->m2= s->m2 + delta * (x - s->mean);
+
+}  /* end of stats_add() */
+
+
+
+/*
+** NAN for an empty sample
+*/
+double
+stats_mean(stats_t *s)
+{
+
+    return (s->num > 0) ? s->mean : NAN;
+
+}  /* end of stats_mean() */
+
+
+
+/*
+** The sample standard deviation. 0 for a single value, NAN for none.
+*/
+double
+stats_stddev(stats_t *s)
+{
+
+    if (s->num < 1)   {
+	return NAN;
+    }
+
+    return (s->num > 1) ? sqrt(s->m2 / (s->num - 1)) : 0.0;
+
+}  /* end of stats_stddev() */
+
+
+
+/*
+** Half the width of the 95% confidence interval of the mean, or NAN
+** with fewer than two values
+*/
+double
+stats_ci95(stats_t *s)
+{
+
+    if (s->num < 2)   {
+	return NAN;
+    }
+
+    return t_975(s->num - 1) * stats_stddev(s) / sqrt(s->num);
+
+}  /* end of stats_ci95() */
+
+
+
+/*
+** Sort values in ascending order, for stats_percentile()
+*/
+void
+stats_sort(double *values, int num)
+{
+
+    qsort(values, num, sizeof(double), compare_doubles);
+
+}  /* end of stats_sort() */
+
+
+
+/*
+** Nearest rank percentile of num sorted values
+*/
+double
+stats_percentile(double *sorted, int num, double p)
+{
+
+int rank;
+
+
+    rank= (int)ceil(p / 100.0 * num);
+    if (rank < 1)   {
+	rank= 1;
+    }
+
+    return sorted[rank - 1];
+
+}  /* end of stats_percentile() */
+
+
+
+static int
+compare_doubles(const void *pa, const void *pb)
+{
+
+const double *a= pa;
+const double *b= pb;
+
+
+    return (*a > *b) - (*a < *b);
+
+}  /* end of compare_doubles() */
+
+
+
+/*
+** The 97.5% quantile of Student's t distribution with df degrees of
+** freedom, for a two sided 95% confidence interval. Sweeps usually have
+** a handful of replicas, where the normal quantile, 1.96, is too small.
+*/
+static double
+t_975(int df)
+{
+
+static const double table[]=   {
+    12.7062, 4.3027, 3.1824, 2.7764, 2.5706, 2.4469, 2.3646, 2.3060, 2.2622, 2.2281,
+    2.2010, 2.1788, 2.1604, 2.1448, 2.1314, 2.1199, 2.1098, 2.1009, 2.0930, 2.0860,
+    2.0796, 2.0739, 2.0687, 2.0639, 2.0595, 2.0555, 2.0518, 2.0484, 2.0452, 2.0423
+};
+const double z= 1.959964;
+double z3, z5, z7;
+
+
+    if (df <= (int)(sizeof(table) / sizeof(table[0])))   {
+	return table[df - 1];
+    }
+
+    /* Cornish-Fisher expansion around the normal quantile */
+    z3= z * z * z;
+    z5= z3 * z * z;
+    z7= z5 * z * z;
+    return z + (z3 + z) / (4.0 * df) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * df * df) +
+	(3.0 * z7 + 19.0 * z5 + 17.0 * z3 - 15.0 * z) / (384.0 * df * df * df);
+
+}  /* end of t_975() */
@@ -0,0 +1,35 @@
+/*
+** $Id$
+**
+** Summary statistics of a sample: the mean and standard deviation with
+** Welford's method, the 95% confidence interval of the mean with
+** Student's t, and nearest rank percentiles. Used for the windows of an
+** --offset_* run and the replicas of a --sweep.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _STATS_H_
+#define _STATS_H_
+
+typedef struct stats_t   {
+    int num;
+    double mean;
+    double m2;			/* Sum of the squared differences from the mean */
+} stats_t;
+
+
+void stats_init(stats_t *s);
+void stats_add(stats_t *s, double x);
+double stats_mean(stats_t *s);
+double stats_stddev(stats_t *s);
+double stats_ci95(stats_t *s);
+void stats_sort(double *values, int num);
+double stats_percentile(double *sorted, int num, double p);
+
+#endif /* _STATS_H_ */
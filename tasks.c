@@ -0,0 +1,246 @@
+/*
+** $Id$
+**
+** Run independent simulations in parallel. The simulator keeps its
+** state in global variables, so each task runs in a child process that
+** starts with a copy of the parent's memory (including anything the
+** parent loaded before, like an input file). Results come back through
+** a pipe.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "globals.h"
+#include "tasks.h"
+
+
+typedef struct child_t   {
+    pid_t pid;
+    int fd;		/* Read end of the result pipe */
+    int task;
+} child_t;
+
+
+/* Local functions */
+static void start_task(child_t *child, int task, task_fn_t fn, void *arg, size_t result_size);
+static int finish_task(child_t *children, int num_children, void *results, size_t result_size,
+		int *status);
+
+
+
+/*
+** Number of tasks to run at the same time, unless the user says otherwise
+*/
+int
+default_jobs(void)
+{
+
+long n;
+
+
+    n= sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)   {
+	return 1;
+    }
+
+    return n;
+
+}  /* end of default_jobs() */
+
+
+
+/*
+** Run num_tasks tasks, at most max_jobs at a time. The results of task
+** i end up at results + i * result_size, and its exit code in status[i].
+** The results of a failed task are all zero. Returns the number of
+** failed tasks.
+*/
+int
+run_tasks(int num_tasks, int max_jobs, task_fn_t fn, void *arg,
+	void *results, size_t result_size, int *status)
+{
+
+child_t *children;
+int running;
+int next;
+int failed;
+
+
+    if (max_jobs < 1)   {
+	max_jobs= 1;
+    }
+
+    children= (child_t *)malloc(max_jobs * sizeof(child_t));
+    if (children == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    /* Anything buffered would otherwise be written by every child */
+    fflush(stdout);
+    fflush(stderr);
+
+    running= 0;
+    next= 0;
+    failed= 0;
+    while ((next < num_tasks) || (running > 0))   {
+	if ((next < num_tasks) && (running < max_jobs))   {
+	    start_task(&children[running], next, fn, arg, result_size);
+	    running++;
+	    next++;
+	} else   {
+	    if (!finish_task(children, running, results, result_size, status))   {
+		failed++;
+	    }
+	    running--;
+	}
+    }
+
+    free(children);
+    return failed;
+
+}  /* end of run_tasks() */
+
+
+
+static void
+start_task(child_t *child, int task, task_fn_t fn, void *arg, size_t result_size)
+{
+
+int fd[2];
+void *result;
+char *pos;
+size_t left;
+ssize_t rc;
+
+
+    if (pipe(fd) != 0)   {
+	fprintf(stderr, "Cannot create pipe for task %d: %s\n", task, strerror(errno));
+	exit(11);
+    }
+
+    child->pid= fork();
+    if (child->pid < 0)   {
+	fprintf(stderr, "Cannot start task %d: %s\n", task, strerror(errno));
+	exit(11);
+    }
+
+    if (child->pid == 0)   {
+	/* Child: compute the result and send it back to the parent */
+	close(fd[0]);
+	result= calloc(1, result_size);
+	if (result == NULL)   {
+	    fprintf(stderr, "Out of memory!\n");
+	    _exit(10);
+	}
+
+	fn(task, arg, result);
+	fflush(stdout);
+	fflush(stderr);
+
+	pos= result;
+	left= result_size;
+	while (left > 0)   {
+	    rc= write(fd[1], pos, left);
+	    if (rc < 0)   {
+		if (errno == EINTR)   {
+		    continue;
+		}
+		_exit(11);
+	    }
+	    pos= pos + rc;
+	    left= left - rc;
+	}
+	_exit(0);
+    }
+
+    /* Parent */
+    close(fd[1]);
+    child->fd= fd[0];
+    child->task= task;
+
+}  /* end of start_task() */
+
+
+
+/*
+** Wait for one of the running tasks to end and collect its result.
+** The finished child is replaced by the last one in the array.
+** Returns FALSE, if the task failed.
+*/
+static int
+finish_task(child_t *children, int num_children, void *results, size_t result_size,
+	int *status)
+{
+
+pid_t pid;
+int wstatus;
+int i;
+int task;
+char *pos;
+size_t left;
+ssize_t rc;
+
+
+    /*
+    ** Results are much smaller than a pipe buffer, so a child can write its
+    ** result and exit before we read it.
+    */
+    do   {
+	pid= waitpid(-1, &wstatus, 0);
+    } while ((pid < 0) && (errno == EINTR));
+
+    for (i= 0; i < num_children; i++)   {
+	if (children[i].pid == pid)   {
+	    break;
+	}
+    }
+    if (i >= num_children)   {
+	fprintf(stderr, "Unknown child process %d ended\n", (int)pid);
+	exit(11);
+    }
+
+    task= children[i].task;
+    pos= (char *)results + task * result_size;
+    if (!WIFEXITED(wstatus) || (WEXITSTATUS(wstatus) != 0))   {
+	/* The child should have said why */
+	status[task]= WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+	memset(pos, 0, result_size);
+	close(children[i].fd);
+	children[i]= children[num_children - 1];
+	return FALSE;
+    }
+
+    left= result_size;
+    while (left > 0)   {
+	rc= read(children[i].fd, pos, left);
+	if (rc <= 0)   {
+	    if ((rc < 0) && (errno == EINTR))   {
+		continue;
+	    }
+	    fprintf(stderr, "Task %d returned no results\n", task);
+	    exit(11);
+	}
+	pos= pos + rc;
+	left= left - rc;
+    }
+    close(children[i].fd);
+    status[task]= 0;
+
+    children[i]= children[num_children - 1];
+    return TRUE;
+
+}  /* end of finish_task() */
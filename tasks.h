@@ -0,0 +1,29 @@
+/*
+** $Id$
+**
+** Run independent simulations in parallel, each in its own process.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _TASKS_H_
+#define _TASKS_H_
+
+#include <stddef.h>
+
+/*
+** A task computes result_size bytes of results for task number "task".
+** It runs in a child process and may change any global state.
+*/
+typedef void (*task_fn_t)(int task, void *arg, void *result);
+
+int default_jobs(void);
+int run_tasks(int num_tasks, int max_jobs, task_fn_t fn, void *arg,
+	void *results, size_t result_size, int *status);
+
+#endif /* _TASKS_H_ */
@@ -27,7 +27,7 @@ get_clock_value(void)
     struct timespec tm;
     int rc;
 
-    rc= clock_gettime(CLOCK_REALTIME, &tm);
+    rc= clock_gettime(CLOCK_MONOTONIC, &tm);
     if (rc)   {
 	perror("get_clock_value() failed");
     }
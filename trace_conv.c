@@ -0,0 +1,276 @@
+/*
+** $Id$
+**
+** Convert a text fault log, as accepted by two_step --input, into the
+** binary trace format described in bintrace.h.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <avl.h>
+#include "globals.h"
+#include "bintrace.h"
+
+#define MAX_ERR_STR_LEN	(2 * 1024)
+
+
+/* Map error strings to small integer IDs */
+typedef struct err_class_t   {
+    char *name;
+    int ID;
+} err_class_t;
+
+static struct avl_table *classes;
+static int num_classes= 0;
+
+
+static int compare_classes(const void *pa, const void *pb, void *param);
+static int lookup_class(char *name);
+static void write_class(err_class_t *class, FILE *fp);
+static void usage(char *prog);
+
+
+
+int
+main(int argc, char *argv[])
+{
+
+FILE *fp_in;
+FILE *fp_out;
+bintrace_hdr_t hdr;
+bintrace_rec_t rec;
+double *index;
+uint64_t index_size;
+char err[MAX_ERR_STR_LEN];
+char *fname_in;
+char *fname_out;
+int verbose;
+int rc;
+int i;
+err_class_t **table;
+struct avl_traverser traverser;
+err_class_t *class;
+
+
+    verbose= FALSE;
+    i= 1;
+    if ((argc > 1) && (strcmp(argv[1], "-v") == 0))   {
+	verbose= TRUE;
+	i++;
+    }
+    if (argc - i != 2)   {
+	usage(argv[0]);
+	exit(1);
+    }
+    fname_in= argv[i];
+    fname_out= argv[i + 1];
+
+    if (strcmp(fname_in, "-") == 0)   {
+	fp_in= stdin;
+    } else   {
+	fp_in= fopen(fname_in, "r");
+	if (fp_in == NULL)   {
+	    fprintf(stderr, "Could not open input file \"%s\": %s\n", fname_in, strerror(errno));
+	    exit(2);
+	}
+    }
+
+    fp_out= fopen(fname_out, "w");
+    if (fp_out == NULL)   {
+	fprintf(stderr, "Could not open output file \"%s\": %s\n", fname_out, strerror(errno));
+	exit(2);
+    }
+
+    classes= avl_create(compare_classes, NULL, NULL);
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, BINTRACE_MAGIC, sizeof(hdr.magic));
+    hdr.version= BINTRACE_VERSION;
+    hdr.byte_order= BINTRACE_BYTE_ORDER;
+    hdr.index_stride= BINTRACE_INDEX_STRIDE;
+    hdr.num_nodes= 0;
+
+    index_size= 1024;
+    index= (double *)malloc(index_size * sizeof(double));
+    if (index == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    /* Header gets rewritten at the end, once we know the counts */
+    if (fwrite(&hdr, sizeof(hdr), 1, fp_out) != 1)   {
+	fprintf(stderr, "Write to \"%s\" failed: %s\n", fname_out, strerror(errno));
+	exit(2);
+    }
+
+    while (TRUE)   {
+	rc= fscanf(fp_in, "%lf %d %s", &rec.t, &rec.node, err);
+	if (rc == EOF)   {
+	    break;
+	} else if (rc != 3)   {
+	    fprintf(stderr, "ERROR: Input file unparsable after %lu records\n",
+		(unsigned long)hdr.num_records);
+	    exit(8);
+	}
+
+	if ((hdr.num_records > 0) && (rec.t < hdr.t_last))   {
+	    fprintf(stderr, "ERROR: Fault times are not ascending after %lu records. Sort the input first.\n",
+		(unsigned long)hdr.num_records);
+	    exit(8);
+	}
+	if (hdr.num_records == 0)   {
+	    hdr.t_first= rec.t;
+	}
+	hdr.t_last= rec.t;
+
+	if (rec.node >= hdr.num_nodes)   {
+	    hdr.num_nodes= rec.node + 1;
+	}
+	rec.err_class= lookup_class(err);
+
+	if ((hdr.num_records % hdr.index_stride) == 0)   {
+	    if (hdr.num_index >= index_size)   {
+		index_size= index_size * 2;
+		index= (double *)realloc(index, index_size * sizeof(double));
+		if (index == NULL)   {
+		    fprintf(stderr, "Out of memory!\n");
+		    exit(10);
+		}
+	    }
+	    index[hdr.num_index]= rec.t;
+	    hdr.num_index++;
+	}
+
+	if (fwrite(&rec, sizeof(rec), 1, fp_out) != 1)   {
+	    fprintf(stderr, "Write to \"%s\" failed: %s\n", fname_out, strerror(errno));
+	    exit(2);
+	}
+	hdr.num_records++;
+    }
+
+    /* The sparse index follows the records */
+    hdr.index_offset= sizeof(hdr) + hdr.num_records * sizeof(rec);
+    if (fwrite(index, sizeof(double), hdr.num_index, fp_out) != hdr.num_index)   {
+	fprintf(stderr, "Write to \"%s\" failed: %s\n", fname_out, strerror(errno));
+	exit(2);
+    }
+
+    /* The class name table is last, in ID order */
+    hdr.class_offset= hdr.index_offset + hdr.num_index * sizeof(double);
+    hdr.num_classes= num_classes;
+    table= (err_class_t **)malloc((num_classes + 1) * sizeof(err_class_t *));
+    if (table == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    for (class= avl_t_first(&traverser, classes); class; class= avl_t_next(&traverser))   {
+	table[class->ID]= class;
+    }
+    for (i= 0; i < num_classes; i++)   {
+	write_class(table[i], fp_out);
+    }
+
+    rewind(fp_out);
+    if (fwrite(&hdr, sizeof(hdr), 1, fp_out) != 1)   {
+	fprintf(stderr, "Write to \"%s\" failed: %s\n", fname_out, strerror(errno));
+	exit(2);
+    }
+    if (fclose(fp_out) != 0)   {
+	fprintf(stderr, "Write to \"%s\" failed: %s\n", fname_out, strerror(errno));
+	exit(2);
+    }
+
+    if (verbose)   {
+	fprintf(stderr, "Converted %lu records, %d nodes, %d error classes, %.3f to %.3f seconds\n",
+	    (unsigned long)hdr.num_records, hdr.num_nodes, num_classes, hdr.t_first, hdr.t_last);
+    }
+
+    if (fp_in != stdin)   {
+	fclose(fp_in);
+    }
+    free(index);
+    free(table);
+
+    return 0;
+
+}  /* end of main() */
+
+
+
+static int
+compare_classes(const void *pa, const void *pb, void *param)
+{
+
+const err_class_t *a= pa;
+const err_class_t *b= pb;
+
+
+    (void)param;
+    return strcmp(a->name, b->name);
+
+}  /* end of compare_classes() */
+
+
+
+/*
+** Return the ID of this error string. New strings get the next ID.
+*/
+static int
+lookup_class(char *name)
+{
+
+err_class_t key;
+err_class_t *class;
+
+
+    key.name= name;
+    class= avl_find(classes, &key);
+    if (class)   {
+	return class->ID;
+    }
+
+    class= (err_class_t *)malloc(sizeof(err_class_t));
+    if (class)   {
+	class->name= strdup(name);
+    }
+    if ((class == NULL) || (class->name == NULL))   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+    class->ID= num_classes++;
+    avl_insert(classes, class);
+
+    return class->ID;
+
+}  /* end of lookup_class() */
+
+
+
+static void
+write_class(err_class_t *class, FILE *fp)
+{
+    if (fwrite(class->name, strlen(class->name) + 1, 1, fp) != 1)   {
+	fprintf(stderr, "Write of error class table failed: %s\n", strerror(errno));
+	exit(2);
+    }
+
+}  /* end of write_class() */
+
+
+
+static void
+usage(char *prog)
+{
+    fprintf(stderr, "Usage: %s [-v] text_input binary_output\n", prog);
+    fprintf(stderr, "    Convert a fault log with lines \"seconds node error\" into a binary trace\n");
+    fprintf(stderr, "    for two_step --input. Use - to read the text log from stdin.\n");
+}  /* end of usage() */
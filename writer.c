@@ -0,0 +1,394 @@
+/*
+** $Id$
+**
+** Buffered writers for the fault and interrupt output files. Records
+** are collected in a large buffer and written out in big blocks. With
+** a writer thread, the simulation fills one buffer while the thread
+** writes the other one.
+**
+** A run that ends with an error calls exit(). writer_exit() writes out
+** what the open writers still hold then, so the records just before the
+** error end up in the files, as they did when these were stdio files.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "globals.h"
+#include "fmt.h"
+#include "writer.h"
+#include "perf.h"
+
+#define WRITER_BUF_SIZE	(1024 * 1024)
+
+
+typedef struct writer_buf_t   {
+    char data[WRITER_BUF_SIZE];
+    size_t len;
+    int full;			/* Waiting to be written by the thread */
+} writer_buf_t;
+
+struct writer_t   {
+    FILE *fp;
+    int binary;
+    int threaded;
+    writer_buf_t buf[2];
+    int fill;			/* Buffer the simulation adds records to */
+    int drain;			/* Buffer the writer thread writes out */
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stop;			/* No more buffers after the full ones */
+    pid_t pid;			/* Process that opened it. Forked tasks leave it alone */
+    writer_t *next;		/* In open_writers */
+};
+
+
+/* Writers that are not closed yet, for writer_exit() */
+static writer_t *open_writers= NULL;
+static pthread_mutex_t open_lock= PTHREAD_MUTEX_INITIALIZER;
+static int exit_registered= FALSE;
+static int exiting= FALSE;
+
+
+/* Local functions */
+static void writer_put(writer_t *w, const void *data, size_t len);
+static void writer_flush(writer_t *w);
+static void writer_write(writer_t *w, writer_buf_t *buf);
+static void *writer_thread(void *arg);
+static void writer_exit(void);
+
+
+
+/*
+** Start buffering output to fp. fp is not closed by writer_close().
+*/
+writer_t *
+writer_open(FILE *fp, int binary, int threaded)
+{
+
+writer_t *w;
+
+
+    w= (writer_t *)malloc(sizeof(writer_t));
+    if (w == NULL)   {
+	fprintf(stderr, "Out of memory!\n");
+	exit(10);
+    }
+
+    w->fp= fp;
+    w->binary= binary;
+    w->threaded= threaded;
+    w->buf[0].len= 0;
+    w->buf[0].full= FALSE;
+    w->buf[1].len= 0;
+    w->buf[1].full= FALSE;
+    w->fill= 0;
+    w->drain= 0;
+    w->stop= FALSE;
+    w->pid= getpid();
+
+    if (threaded)   {
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->cond, NULL);
+	if (pthread_create(&w->thread, NULL, writer_thread, w) != 0)   {
+	    fprintf(stderr, "ERROR: Cannot start thread to write output file\n");
+	    exit(2);
+	}
+    }
+
+    pthread_mutex_lock(&open_lock);
+    if (!exit_registered)   {
+	atexit(writer_exit);
+	exit_registered= TRUE;
+    }
+    w->next= open_writers;
+    open_writers= w;
+    pthread_mutex_unlock(&open_lock);
+
+    return w;
+
+}  /* end of writer_open() */
+
+
+
+/*
+** Write out everything that is still buffered and release the writer
+*/
+void
+writer_close(writer_t *w)
+{
+
+writer_t **prev;
+int timer;
+
+
+    if (w == NULL)   {
+	return;
+    }
+
+    pthread_mutex_lock(&open_lock);
+    for (prev= &open_writers; *prev; prev= &(*prev)->next)   {
+	if (*prev == w)   {
+	    *prev= w->next;
+	    break;
+	}
+    }
+    pthread_mutex_unlock(&open_lock);
+
+    timer= perf_switch(PERF_OUTPUT);
+    writer_flush(w);
+
+    if (w->threaded)   {
+	pthread_mutex_lock(&w->lock);
+	w->stop= TRUE;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+	pthread_join(w->thread, NULL);
+	pthread_mutex_destroy(&w->lock);
+	pthread_cond_destroy(&w->cond);
+    }
+
+    if ((fflush(w->fp) != 0) && !exiting)   {
+	fprintf(stderr, "Write to output file failed: %s\n", strerror(errno));
+	exit(2);
+    }
+    free(w);
+    perf_switch(timer);
+
+}  /* end of writer_close() */
+
+
+
+/*
+** Record the time of a fault
+*/
+void
+writer_fault(writer_t *w, double t)
+{
+
+char str[FMT_BUF_SIZE + 1];
+int len;
+
+
+    if (w->binary)   {
+	writer_put(w, &t, sizeof(t));
+	return;
+    }
+
+    /* "%15.3f\n" */
+    len= fmt_fixed(str, t, 15, 3);
+    str[len++]= '\n';
+    writer_put(w, str, len);
+
+}  /* end of writer_fault() */
+
+
+
+/*
+** Record the time of an interrupt and the number of faults that caused it
+*/
+void
+writer_interrupt(writer_t *w, double t, int faults)
+{
+
+writer_int_rec_t rec;
+char str[2 * FMT_BUF_SIZE + 2];
+int len;
+
+
+    if (w->binary)   {
+	rec.t= t;
+	rec.faults= faults;
+	rec.unused= 0;
+	writer_put(w, &rec, sizeof(rec));
+	return;
+    }
+
+    /* "%15.3f %d\n" */
+    len= fmt_fixed(str, t, 15, 3);
+    str[len++]= ' ';
+    len= len + fmt_int(str + len, faults, 0);
+    str[len++]= '\n';
+    writer_put(w, str, len);
+
+}  /* end of writer_interrupt() */
+
+
+
+/*
+** Write len bytes as they are. Used for other binary files that want
+** the buffering and the writer thread.
+*/
+void
+writer_data(writer_t *w, const void *data, size_t len)
+{
+
+const char *pos= data;
+size_t n;
+
+
+    while (len > 0)   {
+	n= (len < WRITER_BUF_SIZE) ? len : WRITER_BUF_SIZE;
+	writer_put(w, pos, n);
+	pos= pos + n;
+	len= len - n;
+    }
+
+}  /* end of writer_data() */
+
+
+
+/*
+** Append a record to the current buffer, and hand the buffer off
+** when it is full
+*/
+static void
+writer_put(writer_t *w, const void *data, size_t len)
+{
+
+writer_buf_t *buf;
+int timer;
+
+
+    buf= &w->buf[w->fill];
+    if (buf->len + len > WRITER_BUF_SIZE)   {
+	timer= perf_switch(PERF_OUTPUT);
+	writer_flush(w);
+	perf_switch(timer);
+	buf= &w->buf[w->fill];
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len= buf->len + len;
+    perf_output_bytes= perf_output_bytes + len;
+
+}  /* end of writer_put() */
+
+
+
+/*
+** Write the current buffer. With a writer thread, give it to the
+** thread and continue with the other buffer, once that is empty.
+*/
+static void
+writer_flush(writer_t *w)
+{
+
+writer_buf_t *buf;
+
+
+    buf= &w->buf[w->fill];
+    if (buf->len == 0)   {
+	return;
+    }
+
+    if (!w->threaded)   {
+	writer_write(w, buf);
+	buf->len= 0;
+	return;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    buf->full= TRUE;
+    w->fill= 1 - w->fill;
+    pthread_cond_broadcast(&w->cond);
+    while (w->buf[w->fill].full)   {
+	pthread_cond_wait(&w->cond, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+}  /* end of writer_flush() */
+
+
+
+static void
+writer_write(writer_t *w, writer_buf_t *buf)
+{
+
+    if ((fwrite(buf->data, 1, buf->len, w->fp) != buf->len) && !exiting)   {
+	fprintf(stderr, "Write to output file failed: %s\n", strerror(errno));
+	exit(2);
+    }
+
+}  /* end of writer_write() */
+
+
+
+/*
+** Write out full buffers in the order they were filled
+*/
+static void *
+writer_thread(void *arg)
+{
+
+writer_t *w= arg;
+writer_buf_t *buf;
+int full;
+
+
+    while (TRUE)   {
+	buf= &w->buf[w->drain];
+	pthread_mutex_lock(&w->lock);
+	while (!buf->full && !w->stop)   {
+	    pthread_cond_wait(&w->cond, &w->lock);
+	}
+	full= buf->full;
+	pthread_mutex_unlock(&w->lock);
+	if (!full)   {
+	    /* Stopped, and nothing left to write */
+	    break;
+	}
+
+	writer_write(w, buf);
+
+	pthread_mutex_lock(&w->lock);
+	buf->len= 0;
+	buf->full= FALSE;
+	w->drain= 1 - w->drain;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+    }
+
+    return NULL;
+
+}  /* end of writer_thread() */
+
+
+
+/*
+** atexit() hook. Close the writers this process opened and did not
+** close, so their buffers, and the queue of a writer thread, are written
+** out. The files themselves are flushed by exit() after this. A failed
+** write is not reported again; we are already on the way out.
+*/
+static void
+writer_exit(void)
+{
+
+writer_t *w;
+writer_t *next;
+
+
+    exiting= TRUE;
+    w= open_writers;
+    while (w)   {
+	next= w->next;
+	if ((w->pid == getpid()) && !(w->threaded && pthread_equal(w->thread, pthread_self())))   {
+	    writer_close(w);
+	}
+	w= next;
+    }
+
+}  /* end of writer_exit() */
@@ -0,0 +1,41 @@
+/*
+** $Id$
+**
+** Buffered writers for the fault (--ffaults) and interrupt
+** (--finterrupts) output files.
+**
+** This file is part of app_model. App_model is free software and
+** is distributed under the terms of the GNU General Public License
+** Version 3. See the file LICENSE for details.
+** Copyright 2009 Sandia Corporation. Under the terms of Contract
+** DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government
+** retains certain rights in this software.
+**
+*/
+#ifndef _WRITER_H_
+#define _WRITER_H_
+
+#include <stdint.h>
+
+/*
+** In text mode, a fault is written as "%15.3f\n" and an interrupt as
+** "%15.3f %d\n", the same as always. In binary mode, a fault is a
+** double, and an interrupt is a writer_int_rec_t. Both are in the byte
+** order of the machine and there is no header.
+*/
+typedef struct writer_int_rec_t   {
+    double t;			/* Minutes */
+    int32_t faults;		/* Faults that caused this interrupt */
+    int32_t unused;
+} writer_int_rec_t;
+
+typedef struct writer_t writer_t;
+
+
+writer_t *writer_open(FILE *fp, int binary, int threaded);
+void writer_close(writer_t *w);
+void writer_fault(writer_t *w, double t);
+void writer_interrupt(writer_t *w, double t, int faults);
+void writer_data(writer_t *w, const void *data, size_t len);
+
+#endif /* _WRITER_H_ */